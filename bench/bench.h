@@ -0,0 +1,38 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+// shared helpers for the bench/ programs, everything is static inline so each bench stays one file
+
+static inline uint64_t nowNs (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*, deterministic per seed so runs are comparable
+static inline uint64_t benchRandom (uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+// fills keys with a random permutation of 0..n-1
+static inline void benchShuffledKeys (int *keys, int n, uint64_t seed) {
+  uint64_t state = seed ? seed : 1;
+  for (int i = 0; i < n; i++) keys[i] = i;
+  for (int i = n - 1; i > 0; i--)
+  {
+    int j = (int)(benchRandom(&state) % (uint64_t)(i + 1));
+    int tmp = keys[i];
+    keys[i] = keys[j];
+    keys[j] = tmp;
+  }
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "../include/tree.h"
+#include "../include/augment.h"
+#include "../include/build.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// percentile and range count queries: augmented O(log n) lookups versus a full inorder walk
+
+static void walkCount (binary_tree *root, int lo, int hi, int *count) {
+  if(!root) return;
+  walkCount(root -> left, lo, hi, count);
+  if(root -> data >= lo && root -> data <= hi) (*count)++;
+  walkCount(root -> right, lo, hi, count);
+}
+
+static void walkSelect (binary_tree *root, int *k, binary_tree **found) {
+  if(!root || *found) return;
+  walkSelect(root -> left, k, found);
+  if(!*found && (*k)-- == 0) *found = root;
+  walkSelect(root -> right, k, found);
+}
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) keys[i] = 2 * i;
+  binary_tree *root = buildAvlFromSorted(keys, n);
+  uint64_t state = 5;
+  long check = 0;
+  int queries = 1000;
+
+  uint64_t t0 = nowNs();
+  for (int q = 0; q < queries; q++)
+  {
+    int lo = (int)(benchRandom(&state) % (uint64_t)(2 * n));
+    check += countRangeAvlTree(root, lo, lo + n / 2);
+    check += percentileAvlTree(root, (q % 100) / 100.0) -> data;
+  }
+  uint64_t t1 = nowNs();
+
+  // the linear walk is slow, a few queries are enough to time it
+  int slowQueries = n >= 1000000 ? 3 : 30;
+  state = 5;
+  uint64_t t2 = nowNs();
+  for (int q = 0; q < slowQueries; q++)
+  {
+    int lo = (int)(benchRandom(&state) % (uint64_t)(2 * n));
+    int count = 0, k = (int)((q % 100) / 100.0 * n);
+    binary_tree *found = NULL;
+    walkCount(root, lo, lo + n / 2, &count);
+    walkSelect(root, &k, &found);
+    check += count + (found ? found -> data : 0);
+  }
+  uint64_t t3 = nowNs();
+
+  printf("%-10d %16.0f %16.0f\n", n, (double)(t1 - t0) / queries, (double)(t3 - t2) / slowQueries);
+  if(check == 42) printf(" ");
+
+  freeTree(root);
+  free(keys);
+}
+
+int main (void) {
+  printf("%-10s %16s %16s   (ns per range count + percentile)\n", "keys", "augmented", "inorder walk");
+  for (int n = 1000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "../include/tree.h"
+#include "../include/batch.h"
+#include "../include/build.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// lookups in batches: one descent per key versus interleaved and sorted batch descents
+
+#define BATCH 256
+
+static binary_tree *findNode (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return root;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return NULL;
+}
+
+static int compareInts (const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  int *probes = malloc(n * sizeof(int));
+  binary_tree **results = malloc(BATCH * sizeof(binary_tree *));
+  uint64_t state = 8;
+  long found = 0, check = 0;
+
+  benchShuffledKeys(keys, n, 31);
+  binary_tree *root = NULL;
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i] * 2);
+  for (int i = 0; i < n; i++) probes[i] = (int)(benchRandom(&state) % (uint64_t)(2 * n));
+  int batches = n / BATCH;
+  int total = batches * BATCH;
+
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < total; i++) found += findNode(root, probes[i]) != NULL;
+  uint64_t t1 = nowNs();
+
+  for (int b = 0; b < batches; b++)
+  {
+    searchBatchAvlTree(root, probes + b * BATCH, BATCH, results);
+    for (int i = 0; i < BATCH; i++) check += results[i] != NULL;
+  }
+  uint64_t t2 = nowNs();
+
+  // sorting is part of the sorted mode's cost
+  for (int b = 0; b < batches; b++)
+  {
+    qsort(probes + b * BATCH, BATCH, sizeof(int), compareInts);
+    searchSortedBatchAvlTree(root, probes + b * BATCH, BATCH, results);
+    for (int i = 0; i < BATCH; i++) check += results[i] != NULL;
+  }
+  uint64_t t3 = nowNs();
+
+  printf("%-10d %12.1f %12.1f %12.1f\n", n, (double)(t1 - t0) / total, (double)(t2 - t1) / total,
+         (double)(t3 - t2) / total);
+  if(check != 2 * found) printf("lookup mismatch\n");
+
+  freeTree(root);
+  free(keys);
+  free(probes);
+  free(results);
+}
+
+int main (void) {
+  printf("%-10s %12s %12s %12s   (ns/key, batches of %d)\n", "keys", "per key", "interleaved", "sorted", BATCH);
+  for (int n = 10000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
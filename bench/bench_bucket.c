@@ -0,0 +1,107 @@
+#include "../include/tree.h"
+#include "../include/bucket.h"
+#include "bench.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// one key per node against BUCKET_KEYS keys per node: tree height, nodes visited per lookup (one or two
+// cache misses each once the tree is out of cache), lookup/insert/delete time and memory per key.
+// keys are inserted in random order and looked up in another one. pass a key count to add a size,
+// the request behind this was about 50M keys (about 3.5GB for the pointer tree)
+
+static size_t heapBytes (void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+static void countNodes (const bucket_node *node, size_t *nodes) {
+  if(!node) return;
+  (*nodes)++;
+  countNodes(node -> left, nodes);
+  countNodes(node -> right, nodes);
+}
+
+static double avlVisits (binary_tree *root, const int *keys, int n) {
+  long long visits = 0;
+  for (int i = 0; i < n; i += 97)
+  {
+    for (binary_tree *node = root; node && (visits++, node -> data != keys[i]);) node = keys[i] < node -> data ? node -> left : node -> right;
+  }
+  return (double)visits / ((n + 96) / 97);
+}
+
+static double bucketVisits (const bucket_node *root, const int *keys, int n) {
+  long long visits = 0;
+  for (int i = 0; i < n; i += 97)
+  {
+    // bucketContains always goes down to a leaf
+    for (const bucket_node *node = root; node; node = keys[i] >= node -> keys[0] ? node -> right : node -> left) visits++;
+  }
+  return (double)visits / ((n + 96) / 97);
+}
+
+static void report (const char *name, int height, double visits, size_t bytes, int n, uint64_t insertNs,
+                    uint64_t searchNs, uint64_t deleteNs) {
+  printf("%-8s %10d %7d %8.1f %10.1f %10.1f %10.1f %10.1f\n", name, n, height, visits, (double)bytes / n,
+         (double)insertNs / n, (double)searchNs / n, (double)deleteNs / n);
+}
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  int *probes = malloc(n * sizeof(int));
+  benchShuffledKeys(keys, n, 5);
+  benchShuffledKeys(probes, n, 6);
+  long long found = 0;
+
+  size_t heap = heapBytes();
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  size_t bytes = heapBytes() - heap;
+  for (int i = 0; i < n; i++)
+  {
+    binary_tree *node = root;
+    while(node && node -> data != probes[i]) node = probes[i] < node -> data ? node -> left : node -> right;
+    found += node != NULL;
+  }
+  uint64_t t2 = nowNs();
+  int height = root -> height;
+  double visits = avlVisits(root, probes, n);
+  uint64_t t3 = nowNs();
+  for (int i = 0; i < n; i++) root = deleteNodeAvlTree(root, probes[i]);
+  uint64_t t4 = nowNs();
+  report("avl", height, visits, bytes, n, t1 - t0, t2 - t1, t4 - t3);
+
+  heap = heapBytes();
+  bucket_node *buckets = NULL;
+  t0 = nowNs();
+  for (int i = 0; i < n; i++) buckets = insertBucketTree(buckets, keys[i]);
+  t1 = nowNs();
+  bytes = heapBytes() - heap;
+  for (int i = 0; i < n; i++) found += bucketContains(buckets, probes[i]);
+  t2 = nowNs();
+  size_t nodes = 0;
+  countNodes(buckets, &nodes);
+  height = buckets -> height;
+  visits = bucketVisits(buckets, probes, n);
+  t3 = nowNs();
+  for (int i = 0; i < n; i++) buckets = deleteBucketTree(buckets, probes[i]);
+  t4 = nowNs();
+  report("bucket", height, visits, bytes, n, t1 - t0, t2 - t1, t4 - t3);
+  printf("%-8s %10s %7s %8s   %.1f keys per bucket\n", "", "", "", "", (double)n / nodes);
+
+  if(found != 2ll * n || root || buckets) fprintf(stderr, "workload went wrong\n");
+  free(probes);
+  free(keys);
+}
+
+int main (int argc, char **argv) {
+  printf("%-8s %10s %7s %8s %10s %10s %10s %10s\n", "tree", "keys", "height", "visits", "bytes/key", "insert ns",
+         "search ns", "delete ns");
+  for (int n = 100000; n <= 10000000; n *= 10) runSize(n);
+  if(argc > 1) runSize(atoi(argv[1]));
+  return 0;
+}
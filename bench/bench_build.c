@@ -0,0 +1,50 @@
+#include "../include/tree.h"
+#include "../include/pool.h"
+#include "../include/build.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// startup cost: replaying ascending keys through insertAvlTree versus the linear bulk loaders
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  int *shuffled = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) keys[i] = i;
+  benchShuffledKeys(shuffled, n, 7);
+
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  freeTree(root);
+
+  uint64_t t2 = nowNs();
+  root = buildAvlFromSorted(keys, n);
+  uint64_t t3 = nowNs();
+  freeTree(root);
+
+  node_pool *pool = createNodePool(n);
+  uint64_t t4 = nowNs();
+  root = buildAvlFromSortedPool(pool, keys, n);
+  uint64_t t5 = nowNs();
+  destroyNodePool(pool);
+
+  uint64_t t6 = nowNs();
+  root = buildAvlFromUnsorted(shuffled, n);
+  uint64_t t7 = nowNs();
+  freeTree(root);
+
+  printf("%-10d %12.1f %12.1f %12.1f %12.1f\n", n,
+         (t1 - t0) / 1e6, (t3 - t2) / 1e6, (t5 - t4) / 1e6, (t7 - t6) / 1e6);
+
+  free(keys);
+  free(shuffled);
+}
+
+int main (void) {
+  printf("%-10s %12s %12s %12s %12s   (ms)\n", "keys", "insert-asc", "sorted", "sorted+pool", "unsorted");
+  for (int n = 10000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "../include/tree.h"
+#include "../include/cache.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// lookups drawn from a zipf(1.1) distribution over the keys of a 1M key tree (the hot keys scattered over
+// the key range, the tree in a node pool as the cache needs): plain searchAvlTree against
+// searchAvlTreeCached at a few cache sizes, then the same with 1% of the operations deleting and
+// reinserting a hot key, which invalidates.
+// pass a key count to change the size (default 1M)
+
+#define PROBES 4000000
+#define ZIPF_S 1.1
+
+static volatile long sink;
+
+// rank r (0 based) drawn with probability proportional to 1/(r+1)^s, by binary search over the cdf
+static void zipfProbes (int *probes, long count, const int *keys, int n, uint64_t seed) {
+  double *cdf = malloc(n * sizeof(double));
+  double total = 0;
+  uint64_t state = seed;
+
+  for (int r = 0; r < n; r++) cdf[r] = total += 1 / pow(r + 1, ZIPF_S);
+  for (long i = 0; i < count; i++)
+  {
+    double u = (benchRandom(&state) >> 11) * (1.0 / 9007199254740992.0) * total;
+    int lo = 0, hi = n - 1;
+    while(lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if(cdf[mid] < u) lo = mid + 1;
+      else hi = mid;
+    }
+    probes[i] = keys[lo];
+  }
+  free(cdf);
+}
+
+static double runPlain (binary_tree *root, const int *probes) {
+  long found = 0;
+  uint64_t t0 = nowNs();
+  for (long i = 0; i < PROBES; i++) found += searchAvlTree(root, probes[i]) != NULL;
+  uint64_t t1 = nowNs();
+  sink += found;
+  return (double)(t1 - t0) / PROBES;
+}
+
+// every churn-th probe deletes its key and puts it back instead of looking it up, 0 for none
+static binary_tree *runCached (node_pool *pool, binary_tree *root, const int *probes, size_t entries, int churn) {
+  avl_cache *cache = createAvlCache(pool, entries);
+  long found = 0;
+  uint64_t t0 = nowNs();
+
+  for (long i = 0; i < PROBES; i++)
+  {
+    if(churn && i % churn == 0)
+    {
+      root = deleteNodeAvlTreeCached(cache, root, probes[i]);
+      root = insertAvlTreePool(pool, root, probes[i]);
+    }
+    else found += searchAvlTreeCached(cache, root, probes[i]) != NULL;
+  }
+
+  uint64_t t1 = nowNs();
+  printf("%-10zu %8s %10.1f %10.1f%% %14.4f\n", entries, churn ? "1%" : "0", (double)(t1 - t0) / PROBES,
+         100 * avlCacheHitRate(cache), (double)cache -> invalidations / PROBES);
+  if(found != PROBES - (churn ? (PROBES + churn - 1) / churn : 0)) fprintf(stderr, "workload went wrong\n");
+
+  destroyAvlCache(cache);
+  return root;
+}
+
+int main (int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  int *keys = malloc(n * sizeof(int));
+  int *probes = malloc(PROBES * sizeof(int));
+  node_pool *pool = createNodePool(0);
+  binary_tree *root = NULL;
+  size_t sizes[] = { 1024, 4096, 16384, 65536 };
+
+  benchShuffledKeys(keys, n, 5);
+  for (int i = 0; i < n; i++) root = insertAvlTreePool(pool, root, keys[i]);
+  zipfProbes(probes, PROBES, keys, n, 11);
+
+  printf("%d keys, %d zipf(%.1f) lookups\n", n, PROBES, ZIPF_S);
+  printf("plain search %.1f ns/op\n\n", runPlain(root, probes));
+  printf("%-10s %8s %10s %11s %14s\n", "entries", "deletes", "ns/op", "hit rate", "invalidations/op");
+  for (int i = 0; i < 4; i++) root = runCached(pool, root, probes, sizes[i], 0);
+  for (int i = 0; i < 4; i++) root = runCached(pool, root, probes, sizes[i], 100);
+
+  destroyNodePool(pool);
+  free(probes);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "../include/tree.h"
+#include "../include/pool.h"
+#include "../include/compact.h"
+#include "bench.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// memory per key and lookup speed of the compact 12 byte nodes against binary_tree nodes, both from
+// malloc and from a node pool (no malloc header per node). keys are inserted in random order and
+// searched in another random order, memory is the heap growth while building divided by the key count
+
+static size_t heapBytes (void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+static long long searchTree (binary_tree *root, const int *keys, int n) {
+  long long found = 0;
+  for (int i = 0; i < n; i++)
+  {
+    binary_tree *node = root;
+    while(node && node -> data != keys[i]) node = keys[i] < node -> data ? node -> left : node -> right;
+    found += node != NULL;
+  }
+  return found;
+}
+
+static void report (const char *name, int n, size_t bytes, uint64_t insertNs, uint64_t searchNs) {
+  printf("%-18s %10d %12.1f %12.1f %12.1f\n", name, n, (double)bytes / n, (double)insertNs / n, (double)searchNs / n);
+}
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  int *probes = malloc(n * sizeof(int));
+  benchShuffledKeys(keys, n, 3);
+  benchShuffledKeys(probes, n, 4);
+
+  // binary_tree from malloc
+  size_t heap = heapBytes();
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  size_t bytes = heapBytes() - heap;
+  long long found = searchTree(root, probes, n);
+  uint64_t t2 = nowNs();
+  report("binary_tree", n, bytes, t1 - t0, t2 - t1);
+  freeTree(root);
+
+  // binary_tree from a pool
+  heap = heapBytes();
+  node_pool *pool = createNodePool(0);
+  root = NULL;
+  t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTreePool(pool, root, keys[i]);
+  t1 = nowNs();
+  bytes = heapBytes() - heap;
+  found += searchTree(root, probes, n);
+  t2 = nowNs();
+  report("binary_tree pool", n, bytes, t1 - t0, t2 - t1);
+  destroyNodePool(pool);
+
+  // compact, grown by doubling and presized
+  for (int presized = 0; presized < 2; presized++)
+  {
+    heap = heapBytes();
+    compact_tree *tree = createCompactTree(presized ? (size_t)n : 0);
+    t0 = nowNs();
+    for (int i = 0; i < n; i++) compactInsert(tree, keys[i]);
+    t1 = nowNs();
+    bytes = heapBytes() - heap;
+    for (int i = 0; i < n; i++) found += compactContains(tree, probes[i]);
+    t2 = nowNs();
+    report(presized ? "compact presized" : "compact", n, bytes, t1 - t0, t2 - t1);
+    destroyCompactTree(tree);
+  }
+
+  if(found != 4ll * n) fprintf(stderr, "lookups went wrong\n");
+  free(probes);
+  free(keys);
+}
+
+int main (void) {
+  printf("node sizes: binary_tree %zu bytes, compact_node %zu bytes\n", sizeof(binary_tree), sizeof(compact_node));
+  printf("%-18s %10s %12s %12s %12s\n", "nodes", "keys", "bytes/key", "insert ns", "search ns");
+  for (int n = 100000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
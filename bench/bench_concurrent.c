@@ -0,0 +1,140 @@
+#include "../include/tree.h"
+#include "../include/concurrent.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// throughput from 1 to N threads for read-heavy, mixed and update-only workloads: one mutex around the
+// mutable tree versus the fine-grained concurrent tree. the total work is fixed, so on a machine with
+// fewer cores than threads the numbers show contention overhead rather than speedup
+
+#define KEY_RANGE 1000000
+#define TOTAL_OPS 2000000
+#define MAX_THREADS 16
+
+typedef struct workload {
+  const char *name;
+  int containsPercent;
+  int insertPercent;   // the rest are deletes
+}workload;
+
+typedef struct worker_args {
+  pthread_mutex_t *lock;
+  binary_tree **root;
+  concurrent_avl *tree;
+  const workload *mix;
+  int ops;
+  uint64_t seed;
+  long hits;
+}worker_args;
+
+static int containsKey (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return 1;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return 0;
+}
+
+static void *lockedWorker (void *arg) {
+  worker_args *args = arg;
+  uint64_t rng = args -> seed;
+
+  for (int i = 0; i < args -> ops; i++)
+  {
+    uint64_t r = benchRandom(&rng);
+    int key = (int)(r % KEY_RANGE);
+    int op = (int)((r >> 40) % 100);
+
+    pthread_mutex_lock(args -> lock);
+    if(op < args -> mix -> containsPercent) args -> hits += containsKey(*args -> root, key);
+    else if(op < args -> mix -> containsPercent + args -> mix -> insertPercent) *args -> root = insertAvlTree(*args -> root, key);
+    else *args -> root = deleteNodeAvlTree(*args -> root, key);
+    pthread_mutex_unlock(args -> lock);
+  }
+  return NULL;
+}
+
+static void *concurrentWorker (void *arg) {
+  worker_args *args = arg;
+  uint64_t rng = args -> seed;
+  int slot = concurrentRegisterThread(args -> tree);
+
+  for (int i = 0; i < args -> ops; i++)
+  {
+    uint64_t r = benchRandom(&rng);
+    int key = (int)(r % KEY_RANGE);
+    int op = (int)((r >> 40) % 100);
+
+    if(op < args -> mix -> containsPercent) args -> hits += concurrentContains(args -> tree, slot, key);
+    else if(op < args -> mix -> containsPercent + args -> mix -> insertPercent) concurrentInsert(args -> tree, slot, key);
+    else concurrentDelete(args -> tree, slot, key);
+  }
+
+  concurrentUnregisterThread(args -> tree, slot);
+  return NULL;
+}
+
+// runs TOTAL_OPS split over the threads, returns million operations per second
+static double run (void *(*worker)(void *), worker_args *base, int threads) {
+  pthread_t ids[MAX_THREADS];
+  worker_args args[MAX_THREADS];
+
+  uint64_t t0 = nowNs();
+  for (int t = 0; t < threads; t++)
+  {
+    args[t] = *base;
+    args[t].ops = TOTAL_OPS / threads;
+    args[t].seed = 1234 + 77 * t;
+    args[t].hits = 0;
+    pthread_create(&ids[t], NULL, worker, &args[t]);
+  }
+  for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+  uint64_t t1 = nowNs();
+
+  return (double)(TOTAL_OPS / threads * threads) * 1000.0 / (double)(t1 - t0);
+}
+
+int main (void) {
+  static const workload mixes[] = {
+    {"90/5/5", 90, 5},
+    {"50/25/25", 50, 25},
+    {"0/50/50", 0, 50},
+  };
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int maxThreads = cores > 4 ? (int)(cores < MAX_THREADS ? cores : MAX_THREADS) : 4;
+
+  printf("%ld cores, %d keys preloaded out of %d, %d ops per run\n", cores, KEY_RANGE / 2, KEY_RANGE, TOTAL_OPS);
+  printf("%-12s %8s %14s %18s\n", "read/ins/del", "threads", "mutex Mops/s", "concurrent Mops/s");
+
+  for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++)
+  {
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+      pthread_mutex_t lock;
+      binary_tree *root = NULL;
+      pthread_mutex_init(&lock, NULL);
+      for (int i = 0; i < KEY_RANGE; i += 2) root = insertAvlTree(root, i);
+      worker_args locked = {&lock, &root, NULL, &mixes[m], 0, 0, 0};
+      double mutexRate = run(lockedWorker, &locked, threads);
+      freeTree(root);
+      pthread_mutex_destroy(&lock);
+
+      concurrent_avl *tree = createConcurrentAvl();
+      int slot = concurrentRegisterThread(tree);
+      for (int i = 0; i < KEY_RANGE; i += 2) concurrentInsert(tree, slot, i);
+      concurrentUnregisterThread(tree, slot);
+      worker_args fine = {NULL, NULL, tree, &mixes[m], 0, 0, 0};
+      double concurrentRate = run(concurrentWorker, &fine, threads);
+      destroyConcurrentAvl(tree);
+
+      printf("%-12s %8d %14.2f %18.2f\n", mixes[m].name, threads, mutexRate, concurrentRate);
+    }
+  }
+
+  return 0;
+}
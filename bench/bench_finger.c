@@ -0,0 +1,77 @@
+#include "../include/tree.h"
+#include "../include/finger.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ingesting n keys that arrive nearly sorted: plain insertAvlTree from the root against the finger insert
+// (and appendAvlTree for the ascending stream). jittered keys are i * 8 plus up to jitter, so each key lands
+// within a few positions of the previous one, as timestamps from several producers would
+
+enum { ASCENDING, DESCENDING, JITTERED };
+
+static const char *patternNames[] = { "ascending", "descending", "jittered" };
+
+static void makeKeys (int *keys, int n, int pattern, int jitter) {
+  uint64_t state = 17;
+  for (int i = 0; i < n; i++)
+  {
+    if(pattern == ASCENDING) keys[i] = i;
+    else if(pattern == DESCENDING) keys[i] = n - i;
+    else keys[i] = i * 8 + (int)(benchRandom(&state) % (uint64_t)jitter);
+  }
+}
+
+static void runPattern (int n, int pattern, int jitter) {
+  int *keys = malloc(n * sizeof(int));
+  makeKeys(keys, n, pattern, jitter);
+
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  freeTree(root);
+
+  avl_finger finger;
+  fingerReset(&finger);
+  root = NULL;
+  uint64_t t2 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTreeHinted(root, &finger, keys[i]);
+  uint64_t t3 = nowNs();
+  freeTree(root);
+
+  double appendNs = 0;
+  if(pattern == ASCENDING)
+  {
+    fingerReset(&finger);
+    root = NULL;
+    uint64_t t4 = nowNs();
+    for (int i = 0; i < n; i++) root = appendAvlTree(root, &finger, keys[i]);
+    appendNs = (double)(nowNs() - t4) / n;
+    freeTree(root);
+  }
+
+  char name[32];
+  if(pattern == JITTERED) snprintf(name, sizeof(name), "%s/%d", patternNames[pattern], jitter);
+  else snprintf(name, sizeof(name), "%s", patternNames[pattern]);
+
+  printf("%-14s %10d %12.1f %12.1f", name, n, (double)(t1 - t0) / n, (double)(t3 - t2) / n);
+  if(pattern == ASCENDING) printf(" %12.1f", appendNs);
+  printf("\n");
+  free(keys);
+}
+
+int main (int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 10000000;
+
+  printf("%-14s %10s %12s %12s %12s   (ns per insert)\n", "stream", "keys", "insert", "hinted", "append");
+  for (int size = 100000; size <= n; size *= 10)
+  {
+    runPattern(size, ASCENDING, 0);
+    runPattern(size, DESCENDING, 0);
+    runPattern(size, JITTERED, 16);
+    runPattern(size, JITTERED, 1024);
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include "../include/tree.h"
+#include "../include/forest.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// 50% lookups, 25% inserts, 25% deletes from 1 to N threads, uniform keys and keys where 90% of the
+// operations hit 1% of the range: one mutex around one tree versus the sharded forest starting from
+// 8 even shards. the total work is fixed, so with fewer cores than threads only the overhead shows
+
+#define KEY_RANGE 1000000
+#define TOTAL_OPS 2000000
+#define MAX_THREADS 16
+
+typedef struct worker_args {
+  pthread_mutex_t *lock;
+  binary_tree **root;
+  sharded_forest *forest;
+  int skewed;
+  int ops;
+  uint64_t seed;
+  long hits;
+}worker_args;
+
+static int containsKey (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return 1;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return 0;
+}
+
+static int nextKey (uint64_t r, int skewed) {
+  if(skewed && (r >> 32) % 10 != 0) return (int)(r % (KEY_RANGE / 100)) + KEY_RANGE / 2;
+  return (int)(r % KEY_RANGE);
+}
+
+static void *lockedWorker (void *arg) {
+  worker_args *args = arg;
+  uint64_t rng = args -> seed;
+
+  for (int i = 0; i < args -> ops; i++)
+  {
+    uint64_t r = benchRandom(&rng);
+    int key = nextKey(r, args -> skewed);
+    int op = (int)((r >> 40) % 4);
+
+    pthread_mutex_lock(args -> lock);
+    if(op < 2) args -> hits += containsKey(*args -> root, key);
+    else if(op == 2) *args -> root = insertAvlTree(*args -> root, key);
+    else *args -> root = deleteNodeAvlTree(*args -> root, key);
+    pthread_mutex_unlock(args -> lock);
+  }
+  return NULL;
+}
+
+static void *forestWorker (void *arg) {
+  worker_args *args = arg;
+  uint64_t rng = args -> seed;
+
+  for (int i = 0; i < args -> ops; i++)
+  {
+    uint64_t r = benchRandom(&rng);
+    int key = nextKey(r, args -> skewed);
+    int op = (int)((r >> 40) % 4);
+
+    if(op < 2) args -> hits += forestContains(args -> forest, key);
+    else if(op == 2) forestInsert(args -> forest, key);
+    else forestDelete(args -> forest, key);
+  }
+  return NULL;
+}
+
+// runs TOTAL_OPS split over the threads, returns million operations per second
+static double run (void *(*worker)(void *), worker_args *base, int threads) {
+  pthread_t ids[MAX_THREADS];
+  worker_args args[MAX_THREADS];
+
+  uint64_t t0 = nowNs();
+  for (int t = 0; t < threads; t++)
+  {
+    args[t] = *base;
+    args[t].ops = TOTAL_OPS / threads;
+    args[t].seed = 1234 + 77 * t;
+    args[t].hits = 0;
+    pthread_create(&ids[t], NULL, worker, &args[t]);
+  }
+  for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+  uint64_t t1 = nowNs();
+
+  return (double)(TOTAL_OPS / threads * threads) * 1000.0 / (double)(t1 - t0);
+}
+
+int main (void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int maxThreads = cores > 4 ? (int)(cores < MAX_THREADS ? cores : MAX_THREADS) : 4;
+  int sample[8];
+
+  for (int i = 0; i < 8; i++) sample[i] = i * (KEY_RANGE / 8);
+
+  printf("%ld cores, %d keys preloaded out of %d, %d ops per run\n", cores, KEY_RANGE / 2, KEY_RANGE, TOTAL_OPS);
+  printf("%-8s %8s %14s %14s %8s\n", "keys", "threads", "mutex Mops/s", "forest Mops/s", "shards");
+
+  for (int skewed = 0; skewed < 2; skewed++)
+  {
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+      pthread_mutex_t lock;
+      binary_tree *root = NULL;
+      pthread_mutex_init(&lock, NULL);
+      for (int i = 0; i < KEY_RANGE; i += 2) root = insertAvlTree(root, i);
+      worker_args locked = {&lock, &root, NULL, skewed, 0, 0, 0};
+      double mutexRate = run(lockedWorker, &locked, threads);
+      freeTree(root);
+      pthread_mutex_destroy(&lock);
+
+      sharded_forest *forest = createShardedForest(8, sample, 8);
+      for (int i = 0; i < KEY_RANGE; i += 2) forestInsert(forest, i);
+      worker_args sharded = {NULL, NULL, forest, skewed, 0, 0, 0};
+      double forestRate = run(forestWorker, &sharded, threads);
+
+      printf("%-8s %8d %14.2f %14.2f %8d\n", skewed ? "skewed" : "uniform", threads, mutexRate, forestRate, forest -> count);
+      destroyShardedForest(forest);
+    }
+  }
+
+  return 0;
+}
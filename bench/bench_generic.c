@@ -0,0 +1,103 @@
+#include "../include/tree.h"
+#include "../include/avl_generic.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// the int instantiation of the generic tree against the hand written binary_tree code path,
+// each variant runs in its own process so none of them inherits a heap the other one fragmented
+
+AVL_GENERIC_DEFINE(int_set, int, avl_empty, AVL_LESS_NUMERIC)
+AVL_GENERIC_DEFINE(int_map, int, int, AVL_LESS_NUMERIC)
+
+static int containsKey (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return 1;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return 0;
+}
+
+static void runTree (int n, const int *keys) {
+  long found = 0;
+  binary_tree *root = NULL;
+
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  for (int i = 0; i < n; i++) found += containsKey(root, keys[(i * 7) % n]);
+  uint64_t t2 = nowNs();
+  for (int i = 0; i < n; i++) root = deleteNodeAvlTree(root, keys[i]);
+  uint64_t t3 = nowNs();
+
+  printf("%-9d %-12s %10.1f %10.1f %10.1f\n", n, "binary_tree",
+         (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t3 - t2) / n);
+  if(found != n) printf("lookup mismatch\n");
+}
+
+static void runIntSet (int n, const int *keys) {
+  long found = 0;
+  int_set set;
+  int_set_init(&set);
+
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) int_set_insert(&set, keys[i], (avl_empty){});
+  uint64_t t1 = nowNs();
+  for (int i = 0; i < n; i++) found += int_set_contains(&set, keys[(i * 7) % n]);
+  uint64_t t2 = nowNs();
+  for (int i = 0; i < n; i++) int_set_erase(&set, keys[i], NULL);
+  uint64_t t3 = nowNs();
+
+  printf("%-9d %-12s %10.1f %10.1f %10.1f\n", n, "int_set",
+         (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t3 - t2) / n);
+  if(found != n) printf("lookup mismatch\n");
+}
+
+static void runIntMap (int n, const int *keys) {
+  long found = 0;
+  int_map map;
+  int_map_init(&map);
+
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) *int_map_emplace(&map, keys[i], NULL) = i;
+  uint64_t t1 = nowNs();
+  for (int i = 0; i < n; i++) found += *int_map_find(&map, keys[(i * 7) % n]) >= 0;
+  uint64_t t2 = nowNs();
+  for (int i = 0; i < n; i++) int_map_erase(&map, keys[i], NULL);
+  uint64_t t3 = nowNs();
+
+  printf("%-9d %-12s %10.1f %10.1f %10.1f\n", n, "int_map",
+         (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t3 - t2) / n);
+  if(found != n) printf("lookup mismatch\n");
+}
+
+int main (void) {
+  void (*variants[])(int, const int *) = {runTree, runIntSet, runIntMap};
+
+  printf("%-9s %-12s %10s %10s %10s  (ns/op)\n", "keys", "variant", "insert", "find", "delete");
+  for (int n = 1000; n <= 1000000; n *= 10)
+  {
+    int *keys = malloc(n * sizeof(int));
+    benchShuffledKeys(keys, n, 99);
+
+    for (int v = 0; v < 3; v++)
+    {
+      fflush(stdout);
+      pid_t pid = fork();
+      if(pid == 0)
+      {
+        variants[v](n, keys);
+        fflush(stdout);
+        _exit(0);
+      }
+      waitpid(pid, NULL, 0);
+    }
+
+    free(keys);
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "../include/tree.h"
+#include "../include/serialize.h"
+#include "../include/image.h"
+#include "bench.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// startup of a reader process: loadAvlTreeFile (rebuild from the key stream, the tree is private to the
+// process) against openAvlImage (mmap, shared through the page cache), with the files in the page cache
+// as they are for the second and later readers. then random lookups and a range scan on both.
+// pass a key count to change the size (default 10M)
+
+static size_t heapBytes (void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+static bool countKey (int key, void *ctx) {
+  (*(long *)ctx)++;
+  return true;
+}
+
+int main (int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 10000000;
+  int *keys = malloc(n * sizeof(int));
+  char keysPath[] = "/tmp/bench_image_keys_XXXXXX";
+  char imagePath[] = "/tmp/bench_image_tree_XXXXXX";
+  close(mkstemp(keysPath));
+  close(mkstemp(imagePath));
+
+  benchShuffledKeys(keys, n, 9);
+  binary_tree *root = NULL;
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i] * 2);
+  uint64_t t0 = nowNs();
+  saveAvlTreeFile(root, keysPath);
+  uint64_t t1 = nowNs();
+  saveAvlImageFile(root, imagePath);
+  uint64_t t2 = nowNs();
+  freeTree(root);
+  printf("%d keys, save: key stream %.1f ms, image %.1f ms\n\n", n, (t1 - t0) / 1e6, (t2 - t1) / 1e6);
+
+  size_t heap = heapBytes();
+  t0 = nowNs();
+  loadAvlTreeFile(keysPath, &root);
+  t1 = nowNs();
+  size_t privateBytes = heapBytes() - heap;
+  avl_image *image = openAvlImage(imagePath);
+  t2 = nowNs();
+  bool first = imageContains(image, 0);
+  uint64_t t3 = nowNs();
+
+  printf("%-12s %12s %14s\n", "startup", "ms", "private MB");
+  printf("%-12s %12.2f %14.1f\n", "load keys", (t1 - t0) / 1e6, privateBytes / 1e6);
+  printf("%-12s %12.4f %14.1f   (first lookup %.1f us)\n\n", "open image", (t2 - t1) / 1e6, 0.0, (t3 - t2) / 1e3);
+
+  long found = first;
+  t0 = nowNs();
+  for (int i = 0; i < n; i++) found += searchAvlTree(root, keys[i]) != NULL;
+  t1 = nowNs();
+  for (int i = 0; i < n; i++) found += imageContains(image, keys[i]);
+  t2 = nowNs();
+  long scanned = 0;
+  rangeScanAvlTree(root, 0, n / 2, countKey, &scanned);
+  t3 = nowNs();
+  imageRangeScan(image, 0, n / 2, countKey, &scanned);
+  uint64_t t4 = nowNs();
+
+  printf("%-12s %12s %14s\n", "", "lookup ns", "scan ns/key");
+  printf("%-12s %12.1f %14.2f\n", "tree", (double)(t1 - t0) / n, (double)(t3 - t2) / (n / 4 + 1));
+  printf("%-12s %12.1f %14.2f\n", "image", (double)(t2 - t1) / n, (double)(t4 - t3) / (n / 4 + 1));
+
+  // half the probes are odd and miss, every even key in [0, n/2] is there
+  if(found != n + first || scanned != 2 * (n / 4 + 1)) fprintf(stderr, "workload went wrong\n");
+
+  closeAvlImage(image);
+  freeTree(root);
+  unlink(keysPath);
+  unlink(imagePath);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include "../include/tree.h"
+#include "../include/persistent.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// a reader doing lookups while a writer inserts: mutex around the mutable tree versus
+// lock-free snapshots of the persistent tree. reports writer cost and reader latency percentiles
+
+#define PRELOAD 200000
+#define WRITES 200000
+#define SAMPLES 200000
+
+typedef struct shared_state {
+  pthread_mutex_t lock;
+  binary_tree *root;
+  persistent_avl *persistent;
+  atomic_int done;
+  uint64_t *latency;
+  int samples;
+}shared_state;
+
+static int containsKey (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return 1;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return 0;
+}
+
+static void *lockedReader (void *arg) {
+  shared_state *state = arg;
+  uint64_t rng = 77;
+  long found = 0;
+
+  while(!atomic_load(&state -> done) && state -> samples < SAMPLES)
+  {
+    int key = (int)(benchRandom(&rng) % (2 * PRELOAD));
+    uint64_t t0 = nowNs();
+    pthread_mutex_lock(&state -> lock);
+    found += containsKey(state -> root, key);
+    pthread_mutex_unlock(&state -> lock);
+    state -> latency[state -> samples++] = nowNs() - t0;
+  }
+  return (void *)found;
+}
+
+static void *snapshotReader (void *arg) {
+  shared_state *state = arg;
+  uint64_t rng = 77;
+  long found = 0;
+  int slot = persistentRegisterReader(state -> persistent);
+
+  while(!atomic_load(&state -> done) && state -> samples < SAMPLES)
+  {
+    int key = (int)(benchRandom(&rng) % (2 * PRELOAD));
+    uint64_t t0 = nowNs();
+    const persistent_node *snapshot = persistentReadBegin(state -> persistent, slot);
+    found += persistentContains(snapshot, key);
+    persistentReadEnd(state -> persistent, slot);
+    state -> latency[state -> samples++] = nowNs() - t0;
+  }
+
+  persistentUnregisterReader(state -> persistent, slot);
+  return (void *)found;
+}
+
+static int compareU64 (const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void report (const char *name, shared_state *state, uint64_t writeNs) {
+  qsort(state -> latency, state -> samples, sizeof(uint64_t), compareU64);
+  int n = state -> samples;
+  printf("%-12s %12.1f %10d %10llu %10llu %10llu\n", name, (double)writeNs / WRITES, n,
+         (unsigned long long)state -> latency[n / 2], (unsigned long long)state -> latency[(int)(n * 0.99)],
+         (unsigned long long)state -> latency[(int)(n * 0.999)]);
+}
+
+int main (void) {
+  shared_state state;
+  pthread_t reader;
+
+  state.latency = malloc(SAMPLES * sizeof(uint64_t));
+  printf("%-12s %12s %10s %10s %10s %10s\n", "variant", "write ns/op", "reads", "read p50", "read p99", "read p999");
+
+  pthread_mutex_init(&state.lock, NULL);
+  state.root = NULL;
+  for (int i = 0; i < PRELOAD; i++) state.root = insertAvlTree(state.root, 2 * i);
+  atomic_init(&state.done, 0);
+  state.samples = 0;
+  pthread_create(&reader, NULL, lockedReader, &state);
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < WRITES; i++)
+  {
+    pthread_mutex_lock(&state.lock);
+    state.root = insertAvlTree(state.root, 2 * i + 1);
+    pthread_mutex_unlock(&state.lock);
+  }
+  uint64_t t1 = nowNs();
+  atomic_store(&state.done, 1);
+  pthread_join(reader, NULL);
+  report("mutex", &state, t1 - t0);
+  freeTree(state.root);
+
+  state.persistent = createPersistentAvl();
+  for (int i = 0; i < PRELOAD; i++) persistentInsert(state.persistent, 2 * i);
+  atomic_store(&state.done, 0);
+  state.samples = 0;
+  pthread_create(&reader, NULL, snapshotReader, &state);
+  t0 = nowNs();
+  for (int i = 0; i < WRITES; i++) persistentInsert(state.persistent, 2 * i + 1);
+  t1 = nowNs();
+  atomic_store(&state.done, 1);
+  pthread_join(reader, NULL);
+  report("persistent", &state, t1 - t0);
+  destroyPersistentAvl(state.persistent);
+
+  free(state.latency);
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "../include/tree.h"
+#include "../include/validate.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// one balancing policy (the one this binary was built with, make policy-bench runs all three) on the
+// workload mixes: rotations per op, height of the tree afterwards and time per op.
+//   sequential   ascending inserts into an empty tree
+//   insert       random inserts into an empty tree
+//   churn        on the full tree, half inserts and half deletes of random keys over twice the range
+//   read         the same with 90% lookups
+//   delete       every key deleted in random order
+// rotations come from the statistics, so every policy build of this bench has AVL_STATS on (the counters
+// cost the same few ns per op in all three). pass a key count to change the size (default 1M)
+
+typedef struct mix {
+  const char *name;
+  int searches;   // out of 100, the rest split evenly between inserts and deletes
+}mix;
+
+// lookups land here so they cannot be optimised away
+static volatile long sink;
+
+// the real height, the height field holds a rank under the other policies
+static int treeHeight (binary_tree *node) {
+  if(!node) return -1;
+  int hl = treeHeight(node -> left);
+  int hr = treeHeight(node -> right);
+  return (hl > hr ? hl : hr) + 1;
+}
+
+static void report (const char *name, long ops, uint64_t ns, unsigned long rotations, binary_tree *root) {
+  avl_check check;
+  if(checkAvlTree(root, &check)) fprintf(stderr, "%s: %s violated\n", name, avlViolationName(check.violation));
+
+  printf("%-12s %10ld %12.3f %8d %10.1f\n", name, ops, (double)rotations / ops, treeHeight(root), (double)ns / ops);
+}
+
+static binary_tree *runMix (binary_tree *root, const mix *m, int n, long ops, uint64_t seed) {
+  uint64_t state = seed;
+  long found = 0;
+  unsigned long rotations = avlRotationCount();
+  uint64_t t0 = nowNs();
+
+  for (long i = 0; i < ops; i++)
+  {
+    uint64_t r = benchRandom(&state);
+    int key = (int)((r >> 8) % (uint64_t)(2 * n));
+    int pick = (int)(r % 100);
+
+    if(pick < m -> searches) found += searchAvlTree(root, key) != NULL;
+    else if((pick - m -> searches) % 2) root = insertAvlTree(root, key);
+    else root = deleteNodeAvlTree(root, key);
+  }
+
+  uint64_t t1 = nowNs();
+  report(m -> name, ops, t1 - t0, avlRotationCount() - rotations, root);
+  sink += found;
+  return root;
+}
+
+int main (int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  int *keys = malloc(n * sizeof(int));
+  binary_tree *root = NULL;
+  mix churn = { "churn", 0 };
+  mix read = { "read", 90 };
+
+  benchShuffledKeys(keys, n, 3);
+  printf("policy %s, %d keys\n", avlBalancePolicyName(), n);
+  printf("%-12s %10s %12s %8s %10s\n", "workload", "ops", "rotations/op", "height", "ns/op");
+
+  unsigned long rotations = avlRotationCount();
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, i * 2);
+  report("sequential", n, nowNs() - t0, avlRotationCount() - rotations, root);
+  freeTree(root);
+  root = NULL;
+
+  rotations = avlRotationCount();
+  t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i] * 2);
+  report("insert", n, nowNs() - t0, avlRotationCount() - rotations, root);
+
+  // the tree holds the even keys, churn keys are drawn from [0, 2n) so about half of each hit
+  root = runMix(root, &churn, n, n, 17);
+  root = runMix(root, &read, n, n, 29);
+
+  rotations = avlRotationCount();
+  t0 = nowNs();
+  for (int i = 0; i < 2 * n; i++) root = deleteNodeAvlTree(root, keys[i % n] * 2 + i / n);
+  report("delete", 2L * n, nowNs() - t0, avlRotationCount() - rotations, root);
+  // every even key and every odd one churn could have inserted
+  if(root) fprintf(stderr, "workload went wrong\n");
+
+  freeTree(root);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include "../include/tree.h"
+#include "../include/pool.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// malloc per node + recursive freeTree versus a per-tree node pool + destroyNodePool
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  benchShuffledKeys(keys, n, 42);
+
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  uint64_t t1 = nowNs();
+  freeTree(root);
+  uint64_t t2 = nowNs();
+
+  node_pool *pool = createNodePool(0);
+  root = NULL;
+  uint64_t t3 = nowNs();
+  for (int i = 0; i < n; i++) root = insertAvlTreePool(pool, root, keys[i]);
+  uint64_t t4 = nowNs();
+  destroyNodePool(pool);
+  uint64_t t5 = nowNs();
+
+  printf("%-10d %14.1f %14.1f %16.3f %16.3f\n", n,
+         (double)(t1 - t0) / n, (double)(t4 - t3) / n,
+         (double)(t2 - t1) / 1e6, (double)(t5 - t4) / 1e6);
+
+  free(keys);
+}
+
+int main (void) {
+  printf("%-10s %14s %14s %16s %16s\n", "keys", "malloc ns/ins", "pool ns/ins", "freeTree ms", "destroyPool ms");
+  for (int n = 1000; n <= 1000000; n *= 10) runSize(n);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "../include/tree.h"
+#include "../include/build.h"
+#include "../include/serialize.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// persisting a tree: text dump of the keys reloaded by reinserting them, versus the binary format.
+// "read" is a plain fread of the binary file into memory and "build" is buildAvlFromSorted on the keys
+// already in an array, together the floor a loader can get to from the page cache
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  uint64_t rng = 99;
+  long long key = 0;
+
+  // sorted keys with random gaps of 1 to 16
+  for (int i = 0; i < n; i++)
+  {
+    key += 1 + benchRandom(&rng) % 16;
+    keys[i] = (int)key;
+  }
+  binary_tree *root = buildAvlFromSorted(keys, n);
+
+  FILE *text = tmpfile();
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) fprintf(text, "%d ", keys[i]);
+  fflush(text);
+  uint64_t t1 = nowNs();
+  rewind(text);
+  binary_tree *reloaded = NULL;
+  int value;
+  while(fscanf(text, "%d", &value) == 1) reloaded = insertAvlTree(reloaded, value);
+  uint64_t t2 = nowNs();
+  fclose(text);
+  freeTree(reloaded);
+
+  FILE *binary = tmpfile();
+  uint64_t t3 = nowNs();
+  saveAvlTree(root, binary);
+  uint64_t t4 = nowNs();
+  long bytes = ftell(binary);
+  rewind(binary);
+  reloaded = NULL;
+  loadAvlTree(binary, &reloaded);
+  uint64_t t5 = nowNs();
+
+  char *raw = malloc(bytes);
+  rewind(binary);
+  uint64_t t6 = nowNs();
+  size_t got = fread(raw, 1, bytes, binary);
+  uint64_t t7 = nowNs();
+  fclose(binary);
+
+  uint64_t t8 = nowNs();
+  binary_tree *built = buildAvlFromSorted(keys, n);
+  uint64_t t9 = nowNs();
+  freeTree(built);
+
+  printf("%-10d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.2f\n", n, (t1 - t0) / 1e6, (t2 - t1) / 1e6,
+         (t4 - t3) / 1e6, (t5 - t4) / 1e6, (t7 - t6) / 1e6, (t9 - t8) / 1e6, (double)got / n);
+
+  free(raw);
+  freeTree(reloaded);
+  freeTree(root);
+  free(keys);
+}
+
+int main (void) {
+  printf("%-10s %10s %10s %10s %10s %10s %10s %10s   (ms)\n", "keys", "text save", "text load", "bin save", "bin load", "read",
+         "build", "bytes/key");
+  for (int n = 100000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "../include/tree.h"
+#include "../include/join.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// merging a batch of m keys into a live tree of n keys: per key insertAvlTree versus unionAvlTree,
+// then dropping a contiguous range of m keys (ttl expiry): per key deletes versus eraseRangeAvlTree,
+// and extractRangeAvlTree alone, the time the tree is busy when the freeing is left for later
+
+static binary_tree *randomTree (int n, uint64_t seed, int **keysOut) {
+  int *keys = malloc(n * sizeof(int));
+  uint64_t state = seed;
+  binary_tree *root = NULL;
+
+  for (int i = 0; i < n; i++)
+  {
+    keys[i] = (int)(benchRandom(&state) & 0x7fffffff);
+    root = insertAvlTree(root, keys[i]);
+  }
+
+  *keysOut = keys;
+  return root;
+}
+
+static void runSize (int n, int m) {
+  int *liveKeys, *batchKeys;
+  binary_tree *live = randomTree(n, 11, &liveKeys);
+  binary_tree *batch = randomTree(m, 23, &batchKeys);
+
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < m; i++) live = insertAvlTree(live, batchKeys[i]);
+  uint64_t t1 = nowNs();
+  freeTree(live);
+
+  live = NULL;
+  for (int i = 0; i < n; i++) live = insertAvlTree(live, liveKeys[i]);
+
+  uint64_t t2 = nowNs();
+  live = unionAvlTree(live, batch);
+  uint64_t t3 = nowNs();
+
+  batch = NULL;
+  for (int i = 0; i < m; i++) batch = insertAvlTree(batch, batchKeys[i]);
+  uint64_t t4 = nowNs();
+  live = differenceAvlTree(live, batch);
+  uint64_t t5 = nowNs();
+
+  printf("%-10d %-10d %14.2f %14.2f %14.2f\n", n, m, (t1 - t0) / 1e6, (t3 - t2) / 1e6, (t5 - t4) / 1e6);
+
+  freeTree(live);
+  free(liveKeys);
+  free(batchKeys);
+}
+
+static void runRange (int n, int m) {
+  int lo = n / 3, hi = n / 3 + m - 1;
+  binary_tree *root = NULL;
+
+  for (int key = 0; key < n; key++) root = insertAvlTree(root, key);
+  uint64_t t0 = nowNs();
+  for (int key = lo; key <= hi; key++) root = deleteNodeAvlTree(root, key);
+  uint64_t t1 = nowNs();
+  freeTree(root);
+
+  root = NULL;
+  for (int key = 0; key < n; key++) root = insertAvlTree(root, key);
+  uint64_t t2 = nowNs();
+  root = eraseRangeAvlTree(root, lo, hi);
+  uint64_t t3 = nowNs();
+  freeTree(root);
+
+  binary_tree *range;
+  root = NULL;
+  for (int key = 0; key < n; key++) root = insertAvlTree(root, key);
+  uint64_t t4 = nowNs();
+  root = extractRangeAvlTree(root, lo, hi, &range);
+  uint64_t t5 = nowNs();
+  freeTree(range);
+  freeTree(root);
+
+  printf("%-10d %-10d %14.2f %14.2f %14.4f\n", n, m, (t1 - t0) / 1e6, (t3 - t2) / 1e6, (t5 - t4) / 1e6);
+}
+
+int main (void) {
+  printf("%-10s %-10s %14s %14s %14s   (ms)\n", "live", "batch", "insert loop", "union", "difference");
+  runSize(1000000, 1000);
+  runSize(1000000, 100000);
+  runSize(1000000, 1000000);
+  runSize(4000000, 4000000);
+
+  printf("\n%-10s %-10s %14s %14s %14s   (ms)\n", "live", "range", "delete loop", "erase range", "extract only");
+  runRange(1000000, 1000);
+  runRange(1000000, 100000);
+  runRange(10000000, 1000000);
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include "../include/tree.h"
+#include "../include/build.h"
+#include "../include/snapshot.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// random lookups: walking the live pointer tree versus the frozen eytzinger snapshot
+
+static int containsKey (binary_tree *root, int key) {
+  while(root)
+  {
+    if(key == root -> data) return 1;
+    root = key < root -> data ? root -> left : root -> right;
+  }
+  return 0;
+}
+
+static void runSize (int n) {
+  int *keys = malloc(n * sizeof(int));
+  int *probes = malloc(n * sizeof(int));
+  uint64_t state = 3;
+
+  // the tree is built by random inserts so its nodes are scattered the way a live tree's are
+  benchShuffledKeys(keys, n, 17);
+  binary_tree *root = NULL;
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i] * 2);
+  for (int i = 0; i < n; i++) probes[i] = (int)(benchRandom(&state) % (uint64_t)(2 * n));
+
+  uint64_t t0 = nowNs();
+  avl_snapshot *snapshot = freezeAvlTree(root);
+  uint64_t t1 = nowNs();
+
+  long found = 0;
+  uint64_t t2 = nowNs();
+  for (int i = 0; i < n; i++) found += containsKey(root, probes[i]);
+  uint64_t t3 = nowNs();
+  for (int i = 0; i < n; i++) found -= snapshotContains(snapshot, probes[i]);
+  uint64_t t4 = nowNs();
+
+  printf("%-10d %12.1f %12.1f %12.2f\n", n, (double)(t3 - t2) / n, (double)(t4 - t3) / n, (t1 - t0) / 1e6);
+  if(found) printf("lookup mismatch\n");
+
+  freeSnapshot(snapshot);
+  freeTree(root);
+  free(keys);
+  free(probes);
+}
+
+int main (void) {
+  printf("%-10s %12s %12s %12s\n", "keys", "tree ns", "snapshot ns", "freeze ms");
+  for (int n = 1000; n <= 10000000; n *= 10) runSize(n);
+  return 0;
+}
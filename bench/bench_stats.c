@@ -0,0 +1,72 @@
+#include "../include/tree.h"
+#include "../include/stats.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// cost of the operation statistics: the same insert/search/delete workload is built twice by the
+// Makefile, bench/bench_stats with -DAVL_STATS=1 and bench/bench_stats_off without, compare the two.
+// the instrumented build also prints what it counted
+
+#define KEYS 1000000
+#define ROUNDS 3
+
+// best of ROUNDS for each phase, in ns per operation
+static void runWorkload (const int *keys, double *insertNs, double *searchNs, double *deleteNs) {
+  *insertNs = *searchNs = *deleteNs = 1e18;
+
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    binary_tree *root = NULL;
+    long found = 0;
+
+    uint64_t t0 = nowNs();
+    for (int i = 0; i < KEYS; i++) root = insertAvlTree(root, keys[i]);
+    uint64_t t1 = nowNs();
+    for (int i = 0; i < KEYS; i++) found += searchAvlTree(root, keys[KEYS - 1 - i]) != NULL;
+    uint64_t t2 = nowNs();
+    for (int i = 0; i < KEYS; i++) root = deleteNodeAvlTree(root, keys[i]);
+    uint64_t t3 = nowNs();
+
+    if(found != KEYS || root) fprintf(stderr, "workload went wrong\n");
+    if((t1 - t0) / (double)KEYS < *insertNs) *insertNs = (t1 - t0) / (double)KEYS;
+    if((t2 - t1) / (double)KEYS < *searchNs) *searchNs = (t2 - t1) / (double)KEYS;
+    if((t3 - t2) / (double)KEYS < *deleteNs) *deleteNs = (t3 - t2) / (double)KEYS;
+  }
+}
+
+int main (void) {
+  int *keys = malloc(KEYS * sizeof(int));
+  double insertNs, searchNs, deleteNs;
+
+  benchShuffledKeys(keys, KEYS, 7);
+  runWorkload(keys, &insertNs, &searchNs, &deleteNs);
+
+  printf("%-12s %10s %10s %10s   (ns/op, %d random keys, best of %d)\n", "stats", "insert", "search", "delete", KEYS,
+         ROUNDS);
+  printf("%-12s %10.1f %10.1f %10.1f\n", AVL_STATS ? "on" : "off", insertNs, searchNs, deleteNs);
+
+#if AVL_STATS
+  avl_stats stats;
+  avlStatsRead(&stats);
+  uint64_t ops = stats.searches + stats.inserts + stats.deletes;
+
+  printf("\nper operation: %.2f comparisons, %.2f nodes on the path, %.3f retrace steps per update\n",
+         (double)stats.comparisons / ops, (double)stats.pathLength / ops,
+         (double)stats.retraceSteps / (stats.inserts + stats.deletes));
+  printf("rotations: ll %llu, rr %llu, lr %llu, rl %llu\n", (unsigned long long)stats.llRotations,
+         (unsigned long long)stats.rrRotations, (unsigned long long)stats.lrRotations,
+         (unsigned long long)stats.rlRotations);
+  printf("allocations %llu, frees %llu\n", (unsigned long long)stats.allocs, (unsigned long long)stats.frees);
+  printf("depth histogram:");
+  for (int d = 0; d < AVL_MAX_HEIGHT; d++)
+  {
+    if(stats.depthHistogram[d]) printf(" %d:%.2f%%", d, 100.0 * stats.depthHistogram[d] / ops);
+  }
+  printf("\n");
+#endif
+
+  free(keys);
+  return 0;
+}
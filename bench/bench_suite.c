@@ -0,0 +1,559 @@
+// tdestroy is a glibc extension
+#define _GNU_SOURCE
+
+#include "../include/tree.h"
+#include "../include/build.h"
+#include "../include/stats.h"
+#include "bench.h"
+
+#include <malloc.h>
+#include <math.h>
+// search.h names its VISIT values after the traversals tree.h already declares
+#define preorder visitPreorder
+#define postorder visitPostorder
+#include <search.h>
+#undef preorder
+#undef postorder
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// workload harness: insert, delete, search and in order traversal under sequential, random, zipfian and
+// sliding window keys, for the avl tree and two baselines, a sorted array with binary search and glibc's
+// tsearch (a red-black tree like std::map). every run reports ns/op over all of its operations,
+// p50/p99/p999 from every SAMPLE_EVERY-th operation timed on its own, heap bytes per key and rotations
+// per operation (the Makefile builds it with AVL_STATS for those).
+//   bench_suite [--min N] [--max N] [--csv FILE] [--json FILE]
+// sizes go up by tens from --min (1000) to --max (1000000), 100M keys needs about 8GB
+
+#define SAMPLE_EVERY 16
+// sorted array inserts and deletes move O(n) keys, above this size it is built in one go and only searched
+#define ARRAY_UPDATE_LIMIT 100000
+#define ZIPF_THETA 0.99
+
+typedef enum pattern { SEQUENTIAL, RANDOM, ZIPFIAN, WINDOW, PATTERNS }pattern;
+typedef enum op_kind { OP_INSERT, OP_DELETE, OP_SEARCH, OP_SLIDE }op_kind;
+
+static const char *patternNames[] = {"sequential", "random", "zipfian", "window"};
+static const char *opNames[] = {"insert", "delete", "search", "slide", "traverse"};
+
+typedef struct subject {
+  const char *name;
+  void *(*create)(void);
+  void (*insert)(void *, int);
+  void (*remove)(void *, int);
+  bool (*contains)(void *, int);
+  // visits every key in order, returns how many there are
+  long long (*traverse)(void *);
+  void (*destroy)(void *);
+  // bulk load of distinct sorted keys for the structures too slow to fill one key at a time
+  void (*load)(void *, const int *, int);
+}subject;
+
+// keeps the traversals and lookups from being optimized away
+static volatile long long sink;
+
+// ---------------------------------------------------------------------------------------------------
+// the avl tree
+
+static void *avlCreate (void) {
+  return calloc(1, sizeof(binary_tree *));
+}
+
+static void avlInsert (void *state, int key) {
+  binary_tree **root = state;
+  *root = insertAvlTree(*root, key);
+}
+
+static void avlRemove (void *state, int key) {
+  binary_tree **root = state;
+  *root = deleteNodeAvlTree(*root, key);
+}
+
+static bool avlContains (void *state, int key) {
+  binary_tree *node = *(binary_tree **)state;
+  while(node && node -> data != key) node = key < node -> data ? node -> left : node -> right;
+  return node != NULL;
+}
+
+static long long avlTraverse (void *state) {
+  binary_tree *stack[AVL_MAX_HEIGHT];
+  binary_tree *node = *(binary_tree **)state;
+  long long count = 0, sum = 0;
+  int depth = 0;
+
+  while(node || depth)
+  {
+    while(node)
+    {
+      stack[depth++] = node;
+      node = node -> left;
+    }
+    node = stack[--depth];
+    sum += node -> data;
+    count++;
+    node = node -> right;
+  }
+
+  sink += sum;
+  return count;
+}
+
+static void avlDestroy (void *state) {
+  freeTree(*(binary_tree **)state);
+  free(state);
+}
+
+// ---------------------------------------------------------------------------------------------------
+// sorted array
+
+typedef struct sorted_array {
+  int *keys;
+  size_t n;
+  size_t capacity;
+}sorted_array;
+
+static void *arrayCreate (void) {
+  return calloc(1, sizeof(sorted_array));
+}
+
+// first position with keys[pos] >= key, branch free so it costs the same for every key
+static size_t lowerBound (const sorted_array *array, int key) {
+  const int *base = array -> keys;
+  size_t n = array -> n;
+
+  if(!n) return 0;
+  while(n > 1)
+  {
+    size_t half = n / 2;
+    base = base[half - 1] < key ? base + half : base;
+    n -= half;
+  }
+  return (size_t)(base - array -> keys) + (*base < key);
+}
+
+static void arrayInsert (void *state, int key) {
+  sorted_array *array = state;
+  size_t pos = lowerBound(array, key);
+  if(pos < array -> n && array -> keys[pos] == key) return;
+
+  if(array -> n == array -> capacity)
+  {
+    size_t capacity = array -> capacity ? 2 * array -> capacity : 16;
+    int *grown = realloc(array -> keys, capacity * sizeof(int));
+    if(!grown) return;
+    array -> keys = grown;
+    array -> capacity = capacity;
+  }
+
+  memmove(array -> keys + pos + 1, array -> keys + pos, (array -> n - pos) * sizeof(int));
+  array -> keys[pos] = key;
+  array -> n++;
+}
+
+static void arrayRemove (void *state, int key) {
+  sorted_array *array = state;
+  size_t pos = lowerBound(array, key);
+  if(pos == array -> n || array -> keys[pos] != key) return;
+
+  memmove(array -> keys + pos, array -> keys + pos + 1, (array -> n - pos - 1) * sizeof(int));
+  array -> n--;
+}
+
+static bool arrayContains (void *state, int key) {
+  sorted_array *array = state;
+  size_t pos = lowerBound(array, key);
+  return pos < array -> n && array -> keys[pos] == key;
+}
+
+static long long arrayTraverse (void *state) {
+  sorted_array *array = state;
+  long long sum = 0;
+
+  for (size_t i = 0; i < array -> n; i++) sum += array -> keys[i];
+  sink += sum;
+  return (long long)array -> n;
+}
+
+static void arrayLoad (void *state, const int *keys, int n) {
+  sorted_array *array = state;
+
+  free(array -> keys);
+  array -> keys = malloc((size_t)n * sizeof(int));
+  memcpy(array -> keys, keys, (size_t)n * sizeof(int));
+  array -> n = array -> capacity = (size_t)n;
+}
+
+static void arrayDestroy (void *state) {
+  sorted_array *array = state;
+  free(array -> keys);
+  free(array);
+}
+
+// ---------------------------------------------------------------------------------------------------
+// tsearch, keys are stored in the pointer itself
+
+static int compareKeys (const void *a, const void *b) {
+  intptr_t x = (intptr_t)a, y = (intptr_t)b;
+  return (x > y) - (x < y);
+}
+
+static void *rbCreate (void) {
+  return calloc(1, sizeof(void *));
+}
+
+static void rbInsert (void *state, int key) {
+  tsearch((void *)(intptr_t)key, state, compareKeys);
+}
+
+static void rbRemove (void *state, int key) {
+  tdelete((void *)(intptr_t)key, state, compareKeys);
+}
+
+static bool rbContains (void *state, int key) {
+  return tfind((void *)(intptr_t)key, state, compareKeys) != NULL;
+}
+
+// twalk passes no context along
+static long long walkCount, walkSum;
+
+static void walkAction (const void *node, VISIT which, int depth) {
+  (void)depth;
+  if(which == visitPostorder || which == leaf)
+  {
+    walkSum += (intptr_t)*(void *const *)node;
+    walkCount++;
+  }
+}
+
+static long long rbTraverse (void *state) {
+  walkCount = walkSum = 0;
+  twalk(*(void **)state, walkAction);
+  sink += walkSum;
+  return walkCount;
+}
+
+static void keepKey (void *key) {
+  (void)key;
+}
+
+static void rbDestroy (void *state) {
+  tdestroy(*(void **)state, keepKey);
+  free(state);
+}
+
+static const subject subjects[] = {
+  {"avl", avlCreate, avlInsert, avlRemove, avlContains, avlTraverse, avlDestroy, NULL},
+  {"sorted-array", arrayCreate, arrayInsert, arrayRemove, arrayContains, arrayTraverse, arrayDestroy, arrayLoad},
+  {"tsearch-rb", rbCreate, rbInsert, rbRemove, rbContains, rbTraverse, rbDestroy, NULL},
+};
+
+// ---------------------------------------------------------------------------------------------------
+// key patterns
+
+// zipfian ranks in O(1) a draw (gray et al., the generator ycsb uses), rank 0 is the most popular
+typedef struct zipf_gen {
+  int n;
+  double alpha;
+  double zetan;
+  double eta;
+}zipf_gen;
+
+static void zipfInit (zipf_gen *zipf, int n) {
+  double zeta2 = 1.0 + pow(0.5, ZIPF_THETA);
+
+  zipf -> n = n;
+  zipf -> zetan = 0;
+  for (int i = 1; i <= n; i++) zipf -> zetan += pow(i, -ZIPF_THETA);
+  zipf -> alpha = 1.0 / (1.0 - ZIPF_THETA);
+  zipf -> eta = (1.0 - pow(2.0 / n, 1.0 - ZIPF_THETA)) / (1.0 - zeta2 / zipf -> zetan);
+}
+
+// the rank is scattered over the key range so the popular keys are not next to each other in the tree
+static int zipfNext (zipf_gen *zipf, uint64_t *rng) {
+  double u = (double)(benchRandom(rng) >> 11) * 0x1.0p-53;
+  double uz = u * zipf -> zetan;
+  uint64_t rank;
+
+  if(uz < 1.0) rank = 0;
+  else if(uz < 1.0 + pow(0.5, ZIPF_THETA)) rank = 1;
+  else rank = (uint64_t)(zipf -> n * pow(zipf -> eta * u - zipf -> eta + 1.0, zipf -> alpha));
+  if(rank >= (uint64_t)zipf -> n) rank = zipf -> n - 1;
+
+  return (int)(rank * 2654435761u % (uint64_t)zipf -> n);
+}
+
+// the keys one phase of a run works through, a window run slides over keys n..2n-1 and searches the newest tenth
+static void phaseKeys (pattern p, op_kind op, int *keys, int n, zipf_gen *zipf, uint64_t *rng) {
+  switch(p)
+  {
+    case SEQUENTIAL:
+      for (int i = 0; i < n; i++) keys[i] = i;
+      break;
+
+    case RANDOM:
+      if(op == OP_SEARCH) for (int i = 0; i < n; i++) keys[i] = (int)(benchRandom(rng) % (uint64_t)n);
+      else benchShuffledKeys(keys, n, benchRandom(rng));
+      break;
+
+    case ZIPFIAN:
+      for (int i = 0; i < n; i++) keys[i] = zipfNext(zipf, rng);
+      break;
+
+    default:
+      if(op == OP_SEARCH)
+      {
+        int recent = n / 10 ? n / 10 : 1;
+        for (int i = 0; i < n; i++) keys[i] = 2 * n - 1 - (int)(benchRandom(rng) % (uint64_t)recent);
+      }
+      else for (int i = 0; i < n; i++) keys[i] = i;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// measuring
+
+typedef struct result {
+  const char *subject;
+  const char *pattern;
+  const char *op;
+  int n;
+  long long ops;
+  double nsPerOp;
+  uint64_t p50, p99, p999;
+  double bytesPerKey;
+  double rotationsPerOp;   // negative when the structure does not rotate
+}result;
+
+static uint64_t *samples;
+
+static size_t heapBytes (void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+static int compareU64 (const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void apply (const subject *s, void *state, op_kind op, int key, int n) {
+  switch(op)
+  {
+    case OP_INSERT: s -> insert(state, key); break;
+    case OP_DELETE: s -> remove(state, key); break;
+    case OP_SEARCH: sink += s -> contains(state, key); break;
+    default:
+      s -> insert(state, key + n);
+      s -> remove(state, key);
+  }
+}
+
+static void timeOps (const subject *s, void *state, op_kind op, const int *keys, int n, result *r) {
+  int sampled = 0;
+  unsigned long rotations = avlRotationCount();
+  uint64_t t0 = nowNs();
+
+  for (int i = 0; i < n; i++)
+  {
+    if(i % SAMPLE_EVERY)
+    {
+      apply(s, state, op, keys[i], n);
+      continue;
+    }
+
+    uint64_t start = nowNs();
+    apply(s, state, op, keys[i], n);
+    samples[sampled++] = nowNs() - start;
+  }
+
+  uint64_t t1 = nowNs();
+  qsort(samples, sampled, sizeof(uint64_t), compareU64);
+
+  r -> op = opNames[op];
+  r -> ops = n;
+  r -> nsPerOp = (double)(t1 - t0) / n;
+  r -> p50 = samples[sampled / 2];
+  r -> p99 = samples[(int)(sampled * 0.99)];
+  r -> p999 = samples[(int)(sampled * 0.999)];
+  // rotations are only counted in AVL_STATS builds
+  r -> rotationsPerOp = AVL_STATS && s -> insert == avlInsert ? (double)(avlRotationCount() - rotations) / n : -1;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// output
+
+typedef struct outputs {
+  FILE *csv;
+  FILE *json;
+  bool firstJson;
+}outputs;
+
+static void emit (outputs *out, const result *r) {
+  char rotations[32] = "-";
+  if(r -> rotationsPerOp >= 0) snprintf(rotations, sizeof(rotations), "%.3f", r -> rotationsPerOp);
+
+  printf("%-13s %-11s %-9s %10d %10.1f %8llu %8llu %8llu %8.1f %9s\n", r -> subject, r -> pattern, r -> op, r -> n,
+         r -> nsPerOp, (unsigned long long)r -> p50, (unsigned long long)r -> p99, (unsigned long long)r -> p999,
+         r -> bytesPerKey, rotations);
+  fflush(stdout);
+
+  if(out -> csv)
+  {
+    fprintf(out -> csv, "%s,%s,%s,%d,%lld,%.2f,%llu,%llu,%llu,%.2f,%s\n", r -> subject, r -> pattern, r -> op, r -> n,
+            r -> ops, r -> nsPerOp, (unsigned long long)r -> p50, (unsigned long long)r -> p99,
+            (unsigned long long)r -> p999, r -> bytesPerKey, r -> rotationsPerOp >= 0 ? rotations : "");
+  }
+
+  if(out -> json)
+  {
+    fprintf(out -> json, "%s\n  {\"structure\": \"%s\", \"pattern\": \"%s\", \"op\": \"%s\", \"n\": %d, \"ops\": %lld, "
+            "\"ns_per_op\": %.2f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"bytes_per_key\": %.2f, "
+            "\"rotations_per_op\": %s}", out -> firstJson ? "" : ",", r -> subject, r -> pattern, r -> op, r -> n,
+            r -> ops, r -> nsPerOp, (unsigned long long)r -> p50, (unsigned long long)r -> p99,
+            (unsigned long long)r -> p999, r -> bytesPerKey, r -> rotationsPerOp >= 0 ? rotations : "null");
+    out -> firstJson = false;
+  }
+}
+
+// the keys a bulk loaded structure ends up holding, what the fill (and slide) phase would have left behind
+static int finalKeys (pattern p, const int *keys, int *sorted, int n) {
+  if(p == WINDOW)
+  {
+    for (int i = 0; i < n; i++) sorted[i] = n + i;
+    return n;
+  }
+
+  memcpy(sorted, keys, (size_t)n * sizeof(int));
+  size_t unique = sortUniqueKeys(sorted, (size_t)n);
+  if(unique == AVL_SORT_FAILED)
+  {
+    fprintf(stderr, "out of memory sorting %d keys\n", n);
+    exit(1);
+  }
+  return (int)unique;
+}
+
+// one structure, one pattern, one size: fill it (or slide a window over it), search it, walk it, empty it
+static void runOne (const subject *s, pattern p, int n, zipf_gen *zipf, int *keys, int *sorted, outputs *out) {
+  uint64_t rng = 0x5eed + (uint64_t)n * 31 + p;
+  result base = {s -> name, patternNames[p], NULL, n, 0, 0, 0, 0, 0, 0, -1};
+  bool bulk = s -> load && n > ARRAY_UPDATE_LIMIT;
+
+  size_t heap = heapBytes();
+  void *state = s -> create();
+
+  result fill = base;
+  phaseKeys(p, OP_INSERT, keys, n, zipf, &rng);
+  if(bulk) s -> load(state, sorted, finalKeys(p, keys, sorted, n));
+  else if(p != WINDOW) timeOps(s, state, OP_INSERT, keys, n, &fill);
+  else
+  {
+    for (int i = 0; i < n; i++) s -> insert(state, keys[i]);
+    timeOps(s, state, OP_SLIDE, keys, n, &fill);
+  }
+
+  long long size = s -> traverse(state);
+  double bytesPerKey = size ? (double)(heapBytes() - heap) / size : 0;
+  if(fill.op)
+  {
+    fill.bytesPerKey = bytesPerKey;
+    emit(out, &fill);
+  }
+
+  result search = base;
+  phaseKeys(p, OP_SEARCH, keys, n, zipf, &rng);
+  timeOps(s, state, OP_SEARCH, keys, n, &search);
+  search.bytesPerKey = bytesPerKey;
+  emit(out, &search);
+
+  result walk = base;
+  uint64_t t0 = nowNs();
+  s -> traverse(state);
+  uint64_t t1 = nowNs();
+  walk.op = opNames[OP_SLIDE + 1];
+  walk.ops = size;
+  walk.nsPerOp = size ? (double)(t1 - t0) / size : 0;
+  walk.bytesPerKey = bytesPerKey;
+  emit(out, &walk);
+
+  if(p != WINDOW && !bulk)
+  {
+    result drain = base;
+    phaseKeys(p, OP_DELETE, keys, n, zipf, &rng);
+    timeOps(s, state, OP_DELETE, keys, n, &drain);
+    drain.bytesPerKey = bytesPerKey;
+    emit(out, &drain);
+  }
+
+  s -> destroy(state);
+}
+
+static FILE *openOutput (const char *path) {
+  FILE *file = fopen(path, "w");
+  if(!file) fprintf(stderr, "cannot write %s\n", path);
+  return file;
+}
+
+int main (int argc, char **argv) {
+  long long minKeys = 1000, maxKeys = 1000000;
+  const char *csvPath = NULL, *jsonPath = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if(i + 1 < argc && !strcmp(argv[i], "--min")) minKeys = atoll(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--max")) maxKeys = atoll(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--csv")) csvPath = argv[++i];
+    else if(i + 1 < argc && !strcmp(argv[i], "--json")) jsonPath = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--min N] [--max N] [--csv FILE] [--json FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+  // window runs use keys up to 2n
+  if(minKeys < 16 || maxKeys > 1000000000 || minKeys > maxKeys)
+  {
+    fprintf(stderr, "sizes must be 16 <= min <= max <= 1000000000\n");
+    return 1;
+  }
+
+  outputs out = {NULL, NULL, true};
+  if(csvPath && !(out.csv = openOutput(csvPath))) return 1;
+  if(jsonPath && !(out.json = openOutput(jsonPath))) return 1;
+  if(out.csv) fprintf(out.csv, "structure,pattern,op,n,ops,ns_per_op,p50_ns,p99_ns,p999_ns,bytes_per_key,rotations_per_op\n");
+  if(out.json) fprintf(out.json, "[");
+
+  int *keys = malloc((size_t)maxKeys * sizeof(int));
+  int *sorted = malloc((size_t)maxKeys * sizeof(int));
+  samples = malloc(((size_t)maxKeys / SAMPLE_EVERY + 1) * sizeof(uint64_t));
+  if(!keys || !sorted || !samples)
+  {
+    fprintf(stderr, "out of memory for %lld keys\n", maxKeys);
+    return 1;
+  }
+
+  printf("%-13s %-11s %-9s %10s %10s %8s %8s %8s %8s %9s\n", "structure", "pattern", "op", "n", "ns/op", "p50", "p99",
+         "p999", "bytes/key", "rot/op");
+  for (long long n = minKeys; n <= maxKeys; n *= 10)
+  {
+    zipf_gen zipf;
+    zipfInit(&zipf, (int)n);
+    for (pattern p = 0; p < PATTERNS; p++)
+    {
+      for (size_t s = 0; s < sizeof(subjects) / sizeof(subjects[0]); s++) runOne(&subjects[s], p, (int)n, &zipf, keys, sorted, &out);
+    }
+  }
+
+  if(out.csv) fclose(out.csv);
+  if(out.json)
+  {
+    fprintf(out.json, "\n]\n");
+    fclose(out.json);
+  }
+  free(samples);
+  free(sorted);
+  free(keys);
+  return 0;
+}
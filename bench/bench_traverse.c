@@ -0,0 +1,87 @@
+#include "../include/tree.h"
+#include "../include/traverse.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// full tree scans and teardown on 1 to 2x cores threads: sum, filtered count, filtered collect and
+// parallelFreeTree, against a plain recursive walk and freeTree. plus the ring buffer breadth first walk.
+// pass a key count to change the tree size (default 10M, the request behind this was about 100M)
+
+static long long sequentialSum (binary_tree *node) {
+  long long sum = 0;
+  while(node)
+  {
+    sum += node -> data + sequentialSum(node -> left);
+    node = node -> right;
+  }
+  return sum;
+}
+
+static bool keepEven (int key, void *ctx) {
+  return !(key & 1);
+}
+
+static void countLevel (binary_tree *node, int level, void *ctx) {
+  (*(long *)ctx)++;
+}
+
+static binary_tree *buildTree (int n) {
+  int *keys = malloc(n * sizeof(int));
+  binary_tree *root = NULL;
+
+  // random insertion order spreads the nodes over the heap the way a long lived tree has them
+  benchShuffledKeys(keys, n, 3);
+  for (int i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  free(keys);
+  return root;
+}
+
+int main (int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 10000000;
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  binary_tree *root = buildTree(n);
+
+  uint64_t t0 = nowNs();
+  long long expected = sequentialSum(root);
+  uint64_t t1 = nowNs();
+  long visited = 0;
+  levelOrderVisit(root, countLevel, &visited);
+  uint64_t t2 = nowNs();
+  printf("%d keys, %ld cores\nrecursive sum %.1f ms, ring bfs %.1f ms (%ld nodes)\n\n", n, cores, (t1 - t0) / 1e6,
+         (t2 - t1) / 1e6, visited);
+
+  printf("%-8s %10s %10s %10s %10s   (ms)\n", "threads", "sum", "count", "collect", "free");
+  for (int threads = 1; threads <= 2 * cores; threads *= 2)
+  {
+    t0 = nowNs();
+    long long sum = parallelSumAvlTree(root, threads);
+    t1 = nowNs();
+    size_t even = parallelCountAvlTree(root, threads, keepEven, NULL);
+    t2 = nowNs();
+    int *keys;
+    size_t collected = parallelCollectAvlTree(root, threads, keepEven, NULL, &keys);
+    uint64_t t3 = nowNs();
+    free(keys);
+
+    if(sum != expected || even != collected) fprintf(stderr, "workload went wrong\n");
+
+    // teardown needs its own tree each round
+    freeTree(root);
+    root = buildTree(n);
+    uint64_t t4 = nowNs();
+    parallelFreeTree(root, threads);
+    uint64_t t5 = nowNs();
+    root = buildTree(n);
+
+    printf("%-8d %10.1f %10.1f %10.1f %10.1f\n", threads, (t1 - t0) / 1e6, (t2 - t1) / 1e6, (t3 - t2) / 1e6,
+           (t5 - t4) / 1e6);
+  }
+
+  t0 = nowNs();
+  freeTree(root);
+  printf("\nfreeTree %.1f ms\n", (nowNs() - t0) / 1e6);
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "../include/tree.h"
+#include "../include/wal.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// update throughput at each durability level (and without a log at all), WAL_SYNC from several threads
+// to show group commit, then recovery time per million log records and the cost of a checkpoint.
+// pass a directory on the disk to measure, the default /tmp is often not one
+
+#define UPDATES 1000000
+#define SYNC_UPDATES 20000
+#define THREADS 4
+
+typedef struct writer_args {
+  wal_tree *wal;
+  int first;
+  int count;
+}writer_args;
+
+static void *writer (void *arg) {
+  writer_args *args = arg;
+  for (int i = 0; i < args -> count; i++) walInsert(args -> wal, args -> first + i);
+  return NULL;
+}
+
+static void removeFiles (const char *base) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s.log", base);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s.ckpt", base);
+  unlink(path);
+}
+
+// n inserts of shuffled keys spread over the given threads, returns thousand updates per second
+static double run (const char *base, wal_durability durability, int n, int threads, uint64_t *syncs) {
+  wal_options options = {durability, 0, 0, 0};
+  wal_tree *wal = walOpen(base, &options);
+  pthread_t ids[THREADS];
+  writer_args args[THREADS];
+
+  uint64_t t0 = nowNs();
+  for (int t = 0; t < threads; t++)
+  {
+    args[t] = (writer_args){wal, t * n, n / threads};
+    pthread_create(&ids[t], NULL, writer, &args[t]);
+  }
+  for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+  walSync(wal);
+  uint64_t t1 = nowNs();
+
+  *syncs = wal -> syncs;
+  walClose(wal);
+  removeFiles(base);
+  return (double)(n / threads * threads) * 1e6 / (double)(t1 - t0);
+}
+
+int main (int argc, char **argv) {
+  char base[512];
+  snprintf(base, sizeof(base), "%s/bench_wal_tree", argc > 1 ? argv[1] : "/tmp");
+  removeFiles(base);
+
+  wal_tree *probe = walOpen(base, NULL);
+  if(!probe)
+  {
+    fprintf(stderr, "cannot open a log at %s\n", base);
+    return 1;
+  }
+  walClose(probe);
+  removeFiles(base);
+
+  binary_tree *root = NULL;
+  uint64_t t0 = nowNs();
+  for (int key = 0; key < UPDATES; key++) root = insertAvlTree(root, key);
+  uint64_t t1 = nowNs();
+  freeTree(root);
+
+  printf("%-22s %8s %12s %10s\n", "durability", "threads", "k updates/s", "fsyncs");
+  printf("%-22s %8d %12.1f %10d\n", "no log", 1, UPDATES * 1e6 / (double)(t1 - t0), 0);
+
+  uint64_t syncs;
+  double rate = run(base, WAL_NONE, UPDATES, 1, &syncs);
+  printf("%-22s %8d %12.1f %10llu\n", "WAL_NONE", 1, rate, (unsigned long long)syncs);
+  rate = run(base, WAL_GROUP, UPDATES, 1, &syncs);
+  printf("%-22s %8d %12.1f %10llu\n", "WAL_GROUP (256)", 1, rate, (unsigned long long)syncs);
+  rate = run(base, WAL_SYNC, SYNC_UPDATES, 1, &syncs);
+  printf("%-22s %8d %12.1f %10llu\n", "WAL_SYNC", 1, rate, (unsigned long long)syncs);
+  rate = run(base, WAL_SYNC, SYNC_UPDATES, THREADS, &syncs);
+  printf("%-22s %8d %12.1f %10llu\n", "WAL_SYNC group commit", THREADS, rate, (unsigned long long)syncs);
+
+  // a log of UPDATES records over an empty checkpoint, then the same tree as a checkpoint
+  wal_options options = {WAL_NONE, 0, 0, 0};
+  wal_tree *wal = walOpen(base, &options);
+  for (int key = 0; key < UPDATES; key++) walInsert(wal, (int)((key * 2654435761u) % UPDATES));
+  walClose(wal);
+
+  t0 = nowNs();
+  wal = walOpen(base, &options);
+  t1 = nowNs();
+  uint64_t replayed = wal -> replayed;
+  walCheckpoint(wal);
+  uint64_t t2 = nowNs();
+  walClose(wal);
+
+  uint64_t t3 = nowNs();
+  wal = walOpen(base, &options);
+  uint64_t t4 = nowNs();
+  walClose(wal);
+  removeFiles(base);
+
+  printf("\nreplay %llu records      %10.1f ms (%.1f ms per million)\n", (unsigned long long)replayed, (t1 - t0) / 1e6,
+         (t1 - t0) / 1e6 * 1e6 / (double)replayed);
+  printf("checkpoint %d keys     %10.1f ms\n", UPDATES, (t2 - t1) / 1e6);
+  printf("load that checkpoint    %10.1f ms\n", (t4 - t3) / 1e6);
+  return 0;
+}
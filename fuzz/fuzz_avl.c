@@ -0,0 +1,235 @@
+#include "../include/tree.h"
+#include "../include/finger.h"
+#include "../include/join.h"
+#include "../include/validate.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// differential soak test: random inserts, finger inserts, deletes, lookups and small range erases on a
+// binary_tree against a bitmap over the key range, the reference set. every update is followed by
+// checkAvlPath on its key (O(log n)), every --full ops and after each range erase the whole tree goes
+// through checkAvlTree. each round is deterministic in its seed, a failure prints the command that
+// replays it up to the failing op. built with -DAVL_POLICY (make fuzz-policies) it soaks the wavl or
+// red-black retracing with plain inserts and deletes.
+//   fuzz_avl [--seed N] [--rounds N] [--ops N] [--range N] [--full N] [--seconds N]
+
+#if AVL_POLICY != AVL_POLICY_AVL
+// finger.c and join.c refuse to build under the rank policies (make leaves them out), their ops are
+// turned into plain ones below and these only keep the calls compiling
+#define fingerReset(finger) ((void)(finger))
+#define insertAvlTreeHinted(root, finger, key) insertAvlTree(root, key)
+#define eraseRangeAvlTree(root, lo, hi) (root)
+#endif
+
+enum { OP_INSERT, OP_FINGER_INSERT, OP_DELETE, OP_SEARCH, OP_ERASE_RANGE };
+
+static const char *opNames[] = { "insert", "finger insert", "delete", "search", "erase range" };
+
+typedef struct fuzz_config {
+  uint64_t seed;
+  long rounds;
+  long ops;
+  int range;
+  long fullEvery;
+  double seconds;
+}fuzz_config;
+
+// splitmix64, every round starts from its own seed
+static uint64_t nextRandom (uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static double nowSeconds (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool present (const uint64_t *bits, int index) {
+  return bits[index >> 6] >> (index & 63) & 1;
+}
+
+static void setPresent (uint64_t *bits, int index, bool on) {
+  if(on) bits[index >> 6] |= 1ull << (index & 63);
+  else bits[index >> 6] &= ~(1ull << (index & 63));
+}
+
+static void report (const fuzz_config *config, uint64_t seed, long op, int kind, int key, const char *what) {
+  fprintf(stderr, "FAIL seed=%llu op=%ld (%s %d): %s\n", (unsigned long long)seed, op, opNames[kind], key, what);
+  fprintf(stderr, "replay: fuzz_avl --seed %llu --rounds 1 --ops %ld --range %d --full %ld\n",
+          (unsigned long long)seed, op + 1, config -> range, config -> fullEvery);
+}
+
+static bool checked (const fuzz_config *config, uint64_t seed, long op, int kind, int key, avl_violation violation,
+                     const avl_check *check) {
+  if(!violation) return true;
+
+  char what[128];
+  snprintf(what, sizeof(what), "%s violated at data=%d", avlViolationName(violation), check -> node -> data);
+  report(config, seed, op, kind, key, what);
+  return false;
+}
+
+// one round on a fresh tree, false on the first disagreement with the reference or broken invariant
+static bool runRound (const fuzz_config *config, uint64_t seed, long *opsDone) {
+  int range = config -> range;
+  int offset = range / 2;   // keys run from -range/2, so negative keys get exercised too
+  uint64_t *bits = calloc((range + 63) / 64, sizeof(uint64_t));
+  uint64_t state = seed;
+  binary_tree *root = NULL;
+  avl_finger finger;
+  long count = 0;
+  bool ok = true;
+  avl_check check;
+
+  fingerReset(&finger);
+
+  for (long op = 0; ok && op < config -> ops; op++)
+  {
+    uint64_t r = nextRandom(&state);
+    // range erases need a full check each, so they are kept rare enough not to dominate
+    unsigned pick = r % 20000;
+    int index = (int)((r >> 16) % (uint64_t)range);
+    int key = index - offset;
+    int kind = pick < 7000 ? OP_INSERT : pick < 10000 ? OP_FINGER_INSERT : pick < 18000 ? OP_DELETE : pick < 19999 ? OP_SEARCH : OP_ERASE_RANGE;
+#if AVL_POLICY != AVL_POLICY_AVL
+    // finger inserts and range erases write real heights, the rank policies get plain updates instead
+    if(kind == OP_FINGER_INSERT) kind = OP_INSERT;
+    if(kind == OP_ERASE_RANGE) kind = OP_DELETE;
+#endif
+
+    switch(kind)
+    {
+      case OP_INSERT:
+      case OP_FINGER_INSERT:
+        if(kind == OP_INSERT)
+        {
+          root = insertAvlTree(root, key);
+          fingerReset(&finger);
+        }
+        else root = insertAvlTreeHinted(root, &finger, key);
+        count += !present(bits, index);
+        setPresent(bits, index, true);
+        if(!searchAvlTree(root, key))
+        {
+          report(config, seed, op, kind, key, "key missing after insert");
+          ok = false;
+        }
+        else ok = checked(config, seed, op, kind, key, checkAvlPath(root, key, &check), &check);
+        break;
+
+      case OP_DELETE:
+        root = deleteNodeAvlTree(root, key);
+        fingerReset(&finger);
+        count -= present(bits, index);
+        setPresent(bits, index, false);
+        if(searchAvlTree(root, key))
+        {
+          report(config, seed, op, kind, key, "key still there after delete");
+          ok = false;
+        }
+        else ok = checked(config, seed, op, kind, key, checkAvlPath(root, key, &check), &check);
+        break;
+
+      case OP_SEARCH:
+        if((searchAvlTree(root, key) != NULL) != present(bits, index))
+        {
+          report(config, seed, op, kind, key, "search disagrees with the reference");
+          ok = false;
+        }
+        break;
+
+      default:
+      {
+        int hi = key + (int)(r >> 48) % 64;
+        root = eraseRangeAvlTree(root, key, hi);
+        fingerReset(&finger);
+        for (int i = index; i <= hi + offset && i < range; i++)
+        {
+          count -= present(bits, i);
+          setPresent(bits, i, false);
+        }
+        // split and join touch more than one path, so the whole tree is checked
+        ok = checked(config, seed, op, kind, key, checkAvlTree(root, &check), &check);
+        break;
+      }
+    }
+
+#if AVL_AUGMENT
+    if(ok && (root ? root -> size : 0) != count)
+    {
+      report(config, seed, op, kind, key, "size disagrees with the reference");
+      ok = false;
+    }
+#endif
+
+    if(ok && config -> fullEvery && (op + 1) % config -> fullEvery == 0)
+    {
+      ok = checked(config, seed, op, kind, key, checkAvlTree(root, &check), &check);
+      if(ok && (long)check.nodes != count)
+      {
+        report(config, seed, op, kind, key, "node count disagrees with the reference");
+        ok = false;
+      }
+    }
+
+    (*opsDone)++;
+  }
+
+  // the final state, key by key
+  for (int i = 0; ok && i < range; i++)
+  {
+    if((searchAvlTree(root, i - offset) != NULL) != present(bits, i))
+    {
+      report(config, seed, config -> ops - 1, OP_SEARCH, i - offset, "final contents disagree with the reference");
+      ok = false;
+    }
+  }
+
+  freeTree(root);
+  free(bits);
+  return ok;
+}
+
+int main (int argc, char **argv) {
+  fuzz_config config = { .seed = 1, .rounds = 20, .ops = 1000000, .range = 1 << 16, .fullEvery = 100000, .seconds = 0 };
+
+  for (int i = 1; i < argc; i++)
+  {
+    if(i + 1 < argc && !strcmp(argv[i], "--seed")) config.seed = strtoull(argv[++i], NULL, 10);
+    else if(i + 1 < argc && !strcmp(argv[i], "--rounds")) config.rounds = atol(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--ops")) config.ops = atol(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--range")) config.range = atoi(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--full")) config.fullEvery = atol(argv[++i]);
+    else if(i + 1 < argc && !strcmp(argv[i], "--seconds")) config.seconds = atof(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--seed N] [--rounds N] [--ops N] [--range N] [--full N] [--seconds N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(config.range < 64) config.range = 64;
+
+  // with --seconds the rounds go on until the time is up instead of stopping at --rounds
+  double start = nowSeconds();
+  long opsDone = 0;
+  long round = 0;
+
+  for (; config.seconds > 0 ? nowSeconds() - start < config.seconds : round < config.rounds; round++)
+  {
+    if(!runRound(&config, config.seed + round, &opsDone)) return 1;
+  }
+
+  double elapsed = nowSeconds() - start;
+  printf("%ld rounds, %ld ops in %.1f s (%.2f M ops/s), seeds %llu..%llu ok\n", round, opsDone, elapsed,
+         opsDone / elapsed / 1e6, (unsigned long long)config.seed, (unsigned long long)(config.seed + round - 1));
+  return 0;
+}
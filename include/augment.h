@@ -0,0 +1,26 @@
+#ifndef AUGMENT_H
+#define AUGMENT_H
+
+#include "tree.h"
+
+// order statistics and range aggregates in O(log n), answered from the size and aggregate
+// that updateNode keeps in every node (only available while AVL_AUGMENT is on)
+#if AVL_AUGMENT
+
+int sizeAvlTree (binary_tree *root);
+// number of keys strictly below key
+int rankAvlTree (binary_tree *root, int key);
+// node holding the k-th smallest key (0 based), NULL when k is out of range
+binary_tree *selectAvlTree (binary_tree *root, int k);
+// node at percentile p in [0, 1] (nearest rank), NULL for an empty tree
+binary_tree *percentileAvlTree (binary_tree *root, double p);
+
+// number of keys in [lo, hi]
+int countRangeAvlTree (binary_tree *root, int lo, int hi);
+// sum/min/max of the keys in [lo, hi], count (may be NULL) gets how many there are
+// an empty range gives sum 0, min INT_MAX and max INT_MIN
+avl_aggregate aggregateRangeAvlTree (binary_tree *root, int lo, int hi, int *count);
+
+#endif
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef AVL_GENERIC_H
+#define AVL_GENERIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree.h"
+
+// type generic avl tree, the C counterpart of a template: AVL_GENERIC_DEFINE stamps out a node type,
+// a tree type and static inline functions for one (key, value, comparator, allocator) combination,
+// so the comparator is inlined and keys/values live directly inside the node.
+//
+//   AVL_GENERIC_DEFINE(name_map, const char *, int, AVL_LESS_STRING)
+//   name_map map; name_map_init(&map);
+//   *name_map_emplace(&map, "x", NULL) = 3;
+//
+// LESS(a, b) is a macro or inline function returning a < b. The _ALLOC variant takes ALLOC(bytes) and
+// FREE(ptr) for the nodes. For a key only set use avl_empty as the value type: with gcc or clang compiling
+// C it is the GNU empty struct (size 0, marked __extension__ so -pedantic accepts it), elsewhere (C++,
+// other compilers) it has one char member and costs a byte plus padding per node.
+//
+// the balancing is the one of src/tree.c: the same four ll/rr/lr/rl rotations relinking prev,
+// an explicit path stack of AVL_MAX_HEIGHT and the retrace that stops at the first unchanged height
+
+#if defined(__GNUC__) && !defined(__cplusplus)
+__extension__ typedef struct avl_empty {} avl_empty;
+#else
+typedef struct avl_empty { char unused; } avl_empty;
+#endif
+
+#define AVL_LESS_NUMERIC(a, b) ((a) < (b))
+#define AVL_LESS_STRING(a, b) (strcmp((a), (b)) < 0)
+
+#define AVL_GENERIC_DEFINE(name, KeyType, ValueType, LESS) \
+  AVL_GENERIC_DEFINE_ALLOC(name, KeyType, ValueType, LESS, malloc, free)
+
+#define AVL_GENERIC_DEFINE_ALLOC(name, KeyType, ValueType, LESS, ALLOC, FREE) \
+\
+typedef struct name##_node { \
+  struct name##_node *left; \
+  struct name##_node *right; \
+  KeyType key; \
+  int height; \
+  ValueType value; \
+}name##_node; \
+\
+typedef struct name { \
+  name##_node *root; \
+  size_t count; \
+}name; \
+\
+static inline void name##_init (name *tree) { \
+  tree -> root = NULL; \
+  tree -> count = 0; \
+} \
+\
+static inline int name##_nodeHeight (name##_node *node) { \
+  int hl = node -> left ? node -> left -> height : -1; \
+  int hr = node -> right ? node -> right -> height : -1; \
+  return hl > hr ? hl + 1 : hr + 1; \
+} \
+\
+static inline int name##_balanceFactor (name##_node *node) { \
+  int hl = node -> left ? node -> left -> height : -1; \
+  int hr = node -> right ? node -> right -> height : -1; \
+  return hl - hr; \
+} \
+\
+static inline void name##_relink (name##_node *root, name##_node *prev, name##_node *newRoot) { \
+  if(root != prev) \
+  { \
+    if(prev -> left == root) prev -> left = newRoot; \
+    else prev -> right = newRoot; \
+  } \
+} \
+\
+static inline name##_node *name##_llRotation (name##_node *root, name##_node *prev) { \
+  name##_node *newRoot = root -> left; \
+  root -> left = newRoot -> right; \
+  newRoot -> right = root; \
+  name##_relink(root, prev, newRoot); \
+  root -> height = name##_nodeHeight(root); \
+  newRoot -> height = name##_nodeHeight(newRoot); \
+  return newRoot; \
+} \
+\
+static inline name##_node *name##_rrRotation (name##_node *root, name##_node *prev) { \
+  name##_node *newRoot = root -> right; \
+  root -> right = newRoot -> left; \
+  newRoot -> left = root; \
+  name##_relink(root, prev, newRoot); \
+  root -> height = name##_nodeHeight(root); \
+  newRoot -> height = name##_nodeHeight(newRoot); \
+  return newRoot; \
+} \
+\
+static inline name##_node *name##_lrRotation (name##_node *root, name##_node *prev) { \
+  name##_node *child = root -> left; \
+  name##_node *newRoot = child -> right; \
+  child -> right = newRoot -> left; \
+  root -> left = newRoot -> right; \
+  newRoot -> left = child; \
+  newRoot -> right = root; \
+  name##_relink(root, prev, newRoot); \
+  child -> height = name##_nodeHeight(child); \
+  root -> height = name##_nodeHeight(root); \
+  newRoot -> height = name##_nodeHeight(newRoot); \
+  return newRoot; \
+} \
+\
+static inline name##_node *name##_rlRotation (name##_node *root, name##_node *prev) { \
+  name##_node *child = root -> right; \
+  name##_node *newRoot = child -> left; \
+  child -> left = newRoot -> right; \
+  root -> right = newRoot -> left; \
+  newRoot -> left = root; \
+  newRoot -> right = child; \
+  name##_relink(root, prev, newRoot); \
+  child -> height = name##_nodeHeight(child); \
+  root -> height = name##_nodeHeight(root); \
+  newRoot -> height = name##_nodeHeight(newRoot); \
+  return newRoot; \
+} \
+\
+static inline name##_node *name##_balanceNode (name##_node *curr, name##_node *prev) { \
+  int balanceFactor = name##_balanceFactor(curr); \
+  if(balanceFactor < -1) \
+  { \
+    if(name##_balanceFactor(curr -> right) > 0) return name##_rlRotation(curr, prev); \
+    return name##_rrRotation(curr, prev); \
+  } \
+  if(balanceFactor > 1) \
+  { \
+    if(name##_balanceFactor(curr -> left) < 0) return name##_lrRotation(curr, prev); \
+    return name##_llRotation(curr, prev); \
+  } \
+  return curr; \
+} \
+\
+static inline ValueType *name##_find (const name *tree, KeyType key) { \
+  name##_node *curr = tree -> root; \
+  while(curr) \
+  { \
+    /* the reverse comparison only when the key is not smaller, as in insertAvlTree: LESS can be a strcmp */ \
+    if(LESS(key, curr -> key)) curr = curr -> left; \
+    else if(LESS(curr -> key, key)) curr = curr -> right; \
+    else return &curr -> value; \
+  } \
+  return NULL; \
+} \
+\
+static inline bool name##_contains (const name *tree, KeyType key) { \
+  return name##_find(tree, key) != NULL; \
+} \
+\
+/* returns the value slot of key, a new node gets a zeroed value for the caller to construct in place */ \
+static inline ValueType *name##_emplace (name *tree, KeyType key, bool *inserted) { \
+  name##_node *path[AVL_MAX_HEIGHT]; \
+  int depth = 0; \
+  name##_node *curr = tree -> root; \
+  bool left = false; \
+  if(inserted) *inserted = false; \
+  while(curr) \
+  { \
+    if(LESS(key, curr -> key)) left = true; \
+    else if(LESS(curr -> key, key)) left = false; \
+    else return &curr -> value; \
+    path[depth++] = curr; \
+    curr = left ? curr -> left : curr -> right; \
+  } \
+  name##_node *node = ALLOC(sizeof(name##_node)); \
+  if(!node) return NULL; \
+  node -> left = node -> right = NULL; \
+  node -> key = key; \
+  node -> height = 0; \
+  memset(&node -> value, 0, sizeof(ValueType)); \
+  tree -> count++; \
+  if(inserted) *inserted = true; \
+  if(!depth) \
+  { \
+    tree -> root = node; \
+    return &node -> value; \
+  } \
+  if(left) path[depth - 1] -> left = node; \
+  else path[depth - 1] -> right = node; \
+  for (int i = depth - 1; i >= 0; i--) \
+  { \
+    name##_node *at = path[i]; \
+    int oldHeight = at -> height; \
+    int balanceFactor; \
+    at -> height = name##_nodeHeight(at); \
+    balanceFactor = name##_balanceFactor(at); \
+    if(balanceFactor < -1 || balanceFactor > 1) \
+    { \
+      at = name##_balanceNode(at, i ? path[i - 1] : at); \
+      if(!i) tree -> root = at; \
+      break; \
+    } \
+    if(at -> height == oldHeight) break; \
+  } \
+  return &node -> value; \
+} \
+\
+/* inserts or overwrites, the value is moved in by assignment */ \
+static inline bool name##_insert (name *tree, KeyType key, ValueType value) { \
+  bool inserted; \
+  ValueType *slot = name##_emplace(tree, key, &inserted); \
+  if(!slot) return false; \
+  *slot = value; \
+  return inserted; \
+} \
+\
+/* removes key, its value is moved to *removed when that is not NULL */ \
+static inline bool name##_erase (name *tree, KeyType key, ValueType *removed) { \
+  name##_node *path[AVL_MAX_HEIGHT]; \
+  int depth = 0; \
+  name##_node *curr = tree -> root; \
+  while(curr) \
+  { \
+    bool left = LESS(key, curr -> key); \
+    if(!left && !LESS(curr -> key, key)) break; \
+    path[depth++] = curr; \
+    curr = left ? curr -> left : curr -> right; \
+  } \
+  if(!curr) return false; \
+  if(removed) *removed = curr -> value; \
+  if(curr -> left && curr -> right) \
+  { \
+    name##_node *target = curr; \
+    path[depth++] = curr; \
+    if(curr -> left -> height > curr -> right -> height) \
+    { \
+      curr = curr -> left; \
+      while(curr -> right) { path[depth++] = curr; curr = curr -> right; } \
+    } \
+    else \
+    { \
+      curr = curr -> right; \
+      while(curr -> left) { path[depth++] = curr; curr = curr -> left; } \
+    } \
+    target -> key = curr -> key; \
+    target -> value = curr -> value; \
+  } \
+  name##_node *child = curr -> left ? curr -> left : curr -> right; \
+  if(!depth) tree -> root = child; \
+  else if(path[depth - 1] -> left == curr) path[depth - 1] -> left = child; \
+  else path[depth - 1] -> right = child; \
+  FREE(curr); \
+  tree -> count--; \
+  for (int i = depth - 1; i >= 0; i--) \
+  { \
+    name##_node *at = path[i]; \
+    int oldHeight = at -> height; \
+    at -> height = name##_nodeHeight(at); \
+    at = name##_balanceNode(at, i ? path[i - 1] : at); \
+    if(!i) tree -> root = at; \
+    if(at -> height == oldHeight) break; \
+  } \
+  return true; \
+} \
+\
+static inline void name##_freeNodes (name##_node *node) { \
+  while(node) \
+  { \
+    name##_node *right = node -> right; \
+    name##_freeNodes(node -> left); \
+    FREE(node); \
+    node = right; \
+  } \
+} \
+\
+static inline void name##_clear (name *tree) { \
+  name##_freeNodes(tree -> root); \
+  name##_init(tree); \
+} \
+\
+static inline size_t name##_size (const name *tree) { \
+  return tree -> count; \
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+typedef struct binary_tree binary_tree;
+
+// looks up n keys at once, results[i] is the node holding keys[i] or NULL.
+// the descents are interleaved: each step advances a group of lookups by one level and prefetches
+// their next nodes, so the cache misses of different keys overlap instead of queueing up
+void searchBatchAvlTree (binary_tree *root, const int *keys, size_t n, binary_tree **results);
+
+// same for keys sorted ascending: the batch is split at every node it passes, so the path shared
+// by many keys near the root is walked once for all of them
+void searchSortedBatchAvlTree (binary_tree *root, const int *keys, size_t n, binary_tree **results);
+
+#endif
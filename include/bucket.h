@@ -0,0 +1,33 @@
+#ifndef BUCKET_H
+#define BUCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// avl tree of key buckets (a t-tree): every node holds a sorted block of up to BUCKET_KEYS keys, all
+// above the keys of its left subtree and below the ones of its right subtree. a lookup descends on the
+// smallest key of each block only, remembering the last block whose smallest key was not above the key,
+// and finishes with an sse2 scan of that one block, so the tree is about log2(BUCKET_KEYS) levels shorter
+// than a one key per node tree. balancing is plain avl on node heights.
+// same calling convention as insertAvlTree/deleteNodeAvlTree: pass the root in, get the new root back
+
+#define BUCKET_KEYS 24
+// an internal node (two children) that drops below this borrows keys from the leaf before it
+#define BUCKET_MIN_KEYS (BUCKET_KEYS / 2)
+
+// the links come first so a lookup's descent, which only reads them and keys[0], stays in the first cache line
+typedef struct bucket_node {
+  struct bucket_node *left;
+  struct bucket_node *right;
+  int count;
+  int height;
+  int keys[BUCKET_KEYS];   // sorted, the slots past count hold INT_MAX so a whole block can be compared at once
+}bucket_node;
+
+bucket_node *insertBucketTree (bucket_node *root, int key);
+bucket_node *deleteBucketTree (bucket_node *root, int key);
+bool bucketContains (const bucket_node *root, int key);
+size_t bucketTreeSize (const bucket_node *root);
+void freeBucketTree (bucket_node *root);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef BUILD_H
+#define BUILD_H
+
+#include <stddef.h>
+
+typedef struct binary_tree binary_tree;
+typedef struct node_pool node_pool;
+
+// linear time construction of a perfectly balanced avl tree (heights already set)
+// keys must be strictly increasing
+binary_tree *buildAvlFromSorted (const int *keys, size_t n);
+binary_tree *buildAvlFromSortedPool (node_pool *pool, const int *keys, size_t n);
+
+// any order and duplicates allowed, the keys are radix sorted and deduplicated into a scratch copy first.
+// n > 0 keys always make a tree, so NULL for n > 0 means memory ran out
+binary_tree *buildAvlFromUnsorted (const int *keys, size_t n);
+binary_tree *buildAvlFromUnsortedPool (node_pool *pool, const int *keys, size_t n);
+
+// sorts keys in place (radix sort, O(n)) and removes duplicates, returns the new length.
+// AVL_SORT_FAILED when the scratch buffer could not be allocated, keys are untouched then
+#define AVL_SORT_FAILED ((size_t)-1)
+
+size_t sortUniqueKeys (int *keys, size_t n);
+
+#endif
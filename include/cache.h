@@ -0,0 +1,57 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tree.h"
+#include "pool.h"
+
+// hot key cache in front of a binary_tree: a small set associative table of key -> node from recent
+// successful lookups, so a key that keeps coming back (skewed, zipf like workloads) costs one probe of a
+// single cache line instead of a descent from the root. only hits are cached, a key that is not in the
+// tree always descends.
+// the cache is held by the caller next to the root, the tree itself has no room for it, and only works
+// over a pool backed tree. entries point at nodes: deleteNodeAvlTreeCached drops the deleted key and the
+// key a two-child delete moves into the deleted node, inserts and rotations never change which node holds
+// a key and need nothing. a pool keeps its memory until it is reset or destroyed, so a node freed some
+// other way (a plain delete, erase range, a set operation on the pool) is still readable, marked free or
+// recycled for another key, and every hit checks for both. a malloc backed tree would leave the cache
+// pointing at freed memory, which is why the cache is tied to a pool. clear or destroy the cache before
+// resetNodePool or destroyNodePool
+#define AVL_CACHE_WAYS 4
+
+typedef struct avl_cache_entry {
+  int key;
+  binary_tree *node;   // NULL when the way is empty
+}avl_cache_entry;
+
+typedef struct avl_cache {
+  node_pool *pool;         // where the tree's nodes come from
+  avl_cache_entry *sets;   // AVL_CACHE_WAYS entries per set, one 64 byte line each, most recent first
+  uint32_t mask;           // sets - 1
+  int shift;               // 32 - log2(sets), the hash takes the top bits
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t invalidations;
+}avl_cache;
+
+// entries is rounded up to a power of two number of sets, NULL without a pool or when out of memory
+avl_cache *createAvlCache (node_pool *pool, size_t entries);
+void destroyAvlCache (avl_cache *cache);
+
+// searchAvlTree with the cache in front, a hit never touches the tree
+binary_tree *searchAvlTreeCached (avl_cache *cache, binary_tree *root, int key);
+
+// deleteNodeAvlTreePool on the cache's pool that keeps the cache right
+binary_tree *deleteNodeAvlTreeCached (avl_cache *cache, binary_tree *root, int key);
+
+// drops one key, for a node freed or rekeyed some other way
+void avlCacheInvalidate (avl_cache *cache, int key);
+// drops everything, the counters stay
+void avlCacheClear (avl_cache *cache);
+
+// hits / (hits + misses), 0 before the first lookup
+double avlCacheHitRate (const avl_cache *cache);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// compact avl tree for when memory is the limit: 12 byte nodes in one contiguous array, linked by
+// 32 bit indices instead of pointers, and a 2 bit balance factor per node in place of a height.
+// the balance factors live packed four to a byte in a side array, so a search never touches them and the
+// child links need no masking (masking the link kept gcc from selecting it with a cmov, which halved lookup speed).
+// index 0 is the null link. rebalancing keeps the balance factors up to date through the rotations
+// instead of recomputing heights
+
+#define COMPACT_NIL 0
+#define COMPACT_MAX_NODES 0x7fffffffu
+
+enum { COMPACT_BALANCED, COMPACT_LEFT_HEAVY, COMPACT_RIGHT_HEAVY };
+
+typedef struct compact_node {
+  uint32_t left;
+  uint32_t right;   // or the next free node while on the freelist
+  int key;
+}compact_node;
+
+typedef struct compact_tree {
+  compact_node *nodes;   // grown by doubling, indices stay valid across a realloc
+  uint8_t *balance;      // 2 bits per node
+  uint32_t capacity;
+  uint32_t used;         // nodes[1..used-1] have been handed out at least once
+  uint32_t freeList;
+  uint32_t root;
+  size_t count;
+}compact_tree;
+
+static inline unsigned compactBalance (const compact_tree *tree, uint32_t i) {
+  return (tree -> balance[i >> 2] >> ((i & 3) * 2)) & 3;
+}
+
+// capacity is a hint for the node count (0 picks a default), NULL when out of memory
+compact_tree *createCompactTree (size_t capacity);
+void destroyCompactTree (compact_tree *tree);
+
+// false when the key was already there (or out of memory / nodes)
+bool compactInsert (compact_tree *tree, int key);
+// false when the key was not there
+bool compactDelete (compact_tree *tree, int key);
+bool compactContains (const compact_tree *tree, int key);
+size_t compactSize (const compact_tree *tree);
+// bytes held by the node and balance arrays, for memory per key
+size_t compactBytes (const compact_tree *tree);
+
+#endif
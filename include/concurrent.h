@@ -0,0 +1,65 @@
+#ifndef CONCURRENT_H
+#define CONCURRENT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// concurrent avl set after Bronson, Casper, Chafi and Olukotun, "A Practical Concurrent Binary Search Tree":
+// searches never lock, they validate per-node version numbers hand over hand and retry when a rotation
+// moved a node they depend on; updates lock only the one to three nodes they change; deletion of a node
+// with two children just clears its present flag (it stays as a routing node until it can be unlinked)
+// and balance is relaxed, each update repairs heights and rotates on its way up after it is done.
+// unlinked nodes are freed through epoch based reclamation once no thread can still be traversing them
+
+#define CONCURRENT_MAX_THREADS 64
+
+typedef struct concurrent_node {
+  // everything a search touches comes first so one descent step stays in one cache line
+  int key;
+  atomic_int present;
+  atomic_ulong version;
+  _Atomic(struct concurrent_node *) left;
+  _Atomic(struct concurrent_node *) right;
+  _Atomic(struct concurrent_node *) parent;
+  atomic_int height;     // a leaf is 1 here, missing children count as 0
+  pthread_mutex_t lock;
+  struct concurrent_node *retiredNext;
+}concurrent_node;
+
+typedef struct concurrent_thread {
+  // 0 for a free slot, 1 while registered but outside an operation, otherwise the epoch it entered + 2
+  atomic_ulong state;
+  atomic_ulong *epoch;       // the tree's global epoch
+  concurrent_node *limbo[3];
+  unsigned long limboEpoch[3];
+  unsigned ops;
+}concurrent_thread;
+
+typedef struct concurrent_avl {
+  concurrent_node holder;    // its right child is the root, it is never rotated or unlinked
+  atomic_ulong epoch;
+  concurrent_thread threads[CONCURRENT_MAX_THREADS];
+
+  pthread_mutex_t orphanLock;
+  concurrent_node *orphans;  // limbo nodes left behind by threads that unregistered
+}concurrent_avl;
+
+concurrent_avl *createConcurrentAvl (void);
+// only once every thread has unregistered
+void destroyConcurrentAvl (concurrent_avl *tree);
+
+// each thread takes a slot (-1 when all are taken) and passes it to every operation
+int concurrentRegisterThread (concurrent_avl *tree);
+void concurrentUnregisterThread (concurrent_avl *tree, int slot);
+
+// linearizable set operations, insert/delete return whether they changed the set
+bool concurrentContains (concurrent_avl *tree, int slot, int key);
+bool concurrentInsert (concurrent_avl *tree, int slot, int key);
+bool concurrentDelete (concurrent_avl *tree, int slot, int key);
+
+// number of keys, only meaningful while no update is running
+size_t concurrentSize (concurrent_avl *tree);
+
+#endif
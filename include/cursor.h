@@ -0,0 +1,46 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tree.h"
+
+// in order cursor over a binary_tree, it keeps its root to node path inline so moving it never allocates
+// (nodes have no parent pointer); any insert or delete on the tree invalidates the cursors on it
+typedef struct avl_cursor {
+  binary_tree *path[AVL_MAX_HEIGHT];
+  int depth;
+}avl_cursor;
+
+// positioning, the cursor ends up invalid (past the end) when there is no such key
+void cursorFirst (avl_cursor *cursor, binary_tree *root);
+void cursorLast (avl_cursor *cursor, binary_tree *root);
+// first key >= key
+void cursorLowerBound (avl_cursor *cursor, binary_tree *root, int key);
+// first key > key
+void cursorUpperBound (avl_cursor *cursor, binary_tree *root, int key);
+// last key <= key
+void cursorFloor (avl_cursor *cursor, binary_tree *root, int key);
+
+bool cursorValid (const avl_cursor *cursor);
+binary_tree *cursorNode (const avl_cursor *cursor);
+int cursorKey (const avl_cursor *cursor);
+
+// step in key order, false (and an invalid cursor) when walking off either end
+bool cursorNext (avl_cursor *cursor);
+bool cursorPrev (avl_cursor *cursor);
+
+// point queries, true and the key in *out when it exists
+bool floorAvlTree (binary_tree *root, int key, int *out);        // largest <= key
+bool ceilAvlTree (binary_tree *root, int key, int *out);         // smallest >= key
+bool predecessorAvlTree (binary_tree *root, int key, int *out);  // largest < key
+bool successorAvlTree (binary_tree *root, int key, int *out);    // smallest > key
+
+// visit returns false to stop the scan early
+typedef bool (*avl_visit)(int key, void *ctx);
+
+// calls visit for every key in [lo, hi] in ascending order, O(log n + k), returns the number visited
+size_t rangeScanAvlTree (binary_tree *root, int lo, int hi, avl_visit visit, void *ctx);
+
+#endif
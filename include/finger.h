@@ -0,0 +1,31 @@
+#ifndef FINGER_H
+#define FINGER_H
+
+#include "tree.h"
+
+// hinted insertion for keys that arrive nearly sorted. a finger is the root to node path of the last key
+// inserted, with the key range each subtree on it covers. the next insert climbs the path only until the
+// key fits a subtree and descends from there, so an insert d keys away from the previous one costs
+// O(log d) comparisons, and ascending input costs O(1) amortized (with AVL_AUGMENT the sizes and
+// aggregates above the new node still get refreshed, one cached update per level).
+// nodes have no parent pointer, so like a cursor the finger is invalidated by any other change to the
+// tree: reset it (or hand it a tree whose root differs, which is noticed) after deletes or other inserts
+typedef struct avl_finger {
+  binary_tree *path[AVL_MAX_HEIGHT];
+  long long lo[AVL_MAX_HEIGHT];   // keys of the subtree at path[i] are in (lo[i], hi[i])
+  long long hi[AVL_MAX_HEIGHT];
+  int depth;                      // 0 until the first insert
+}avl_finger;
+
+void fingerReset (avl_finger *finger);
+
+// insertAvlTree starting from the finger, which is left on key (the new node or the one already there)
+binary_tree *insertAvlTreeHinted (binary_tree *root, avl_finger *finger, int key);
+binary_tree *insertAvlTreeHintedPool (node_pool *pool, binary_tree *root, avl_finger *finger, int key);
+
+// append fast path for a key above every key in the tree: no comparisons, the node goes right of the
+// maximum. a key that is not above the maximum falls back to the hinted insert
+binary_tree *appendAvlTree (binary_tree *root, avl_finger *finger, int key);
+binary_tree *appendAvlTreePool (node_pool *pool, binary_tree *root, avl_finger *finger, int key);
+
+#endif
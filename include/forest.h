@@ -0,0 +1,62 @@
+#ifndef FOREST_H
+#define FOREST_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tree.h"
+#include "cursor.h"
+
+// key range sharded forest: the key space is cut into contiguous ranges, each one a plain avl tree behind
+// its own mutex, so operations on different ranges never wait for each other.
+// the cut points start at quantiles of a sample of the keys and move online: a shard that takes far more
+// than its share of the operations is split at the median of the keys it saw lately (and once the table
+// is full the coldest pair of neighbours is merged to make room), so a skewed workload spreads out again
+
+#define FOREST_MAX_SHARDS 64
+#define FOREST_RECENT_KEYS 32
+
+typedef struct forest_shard {
+  pthread_mutex_t lock;
+  binary_tree *root;
+  // operations routed here since the last resplit, written under lock and read racily by the hot check
+  atomic_ulong hits;
+  // ring of the last keys routed here, the split point is taken from them
+  int recent[FOREST_RECENT_KEYS];
+}forest_shard;
+
+typedef struct sharded_forest {
+  // every operation holds it shared while it routes and works on its shard, a resplit holds it exclusively
+  pthread_rwlock_t tableLock;
+  int count;
+  // shard i holds the keys in [lo[i], lo[i + 1]), lo[0] is INT_MIN
+  int lo[FOREST_MAX_SHARDS];
+  forest_shard *shards[FOREST_MAX_SHARDS];
+  atomic_flag resplitting;
+  unsigned long resplits;
+}sharded_forest;
+
+// cut points at the quantiles of the distinct keys of sample (may be NULL/0 for an even split of all ints),
+// fewer than shards when the sample has fewer distinct keys
+sharded_forest *createShardedForest (int shards, const int *sample, size_t n);
+void destroyShardedForest (sharded_forest *forest);
+
+// each call locks only the shard that owns key, insert and delete leave the tree alone when nothing changes
+bool forestContains (sharded_forest *forest, int key);
+void forestInsert (sharded_forest *forest, int key);
+void forestDelete (sharded_forest *forest, int key);
+
+// calls visit for every key in [lo, hi] in ascending order across shards, returns the number visited.
+// shards are locked one at a time, so the scan is consistent per shard but not across them, and visit
+// must not call back into the forest
+size_t forestRangeScan (sharded_forest *forest, int lo, int hi, avl_visit visit, void *ctx);
+// quiescent only
+size_t forestSize (sharded_forest *forest);
+
+// splits the hottest shard if it takes at least 1.5 times its share of the operations, true when it did.
+// runs on its own every few thousand operations of a shard, public to force it
+bool forestResplit (sharded_forest *forest);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cursor.h"
+
+// read-only tree image for processes that share one key set: the tree is written once with its shape, as
+// 12 byte nodes linked by index, and readers mmap the file and search it where it lies. there is nothing
+// to rebuild, opening costs about one mmap, and every reader maps the same page cache pages.
+// file layout, all integers little endian (a big endian host refuses to open images):
+//   header   64 bytes: "AVLI", u32 version, u64 node count, u32 height, u32 node bytes, zero padding
+//   nodes    in postorder: every subtree is one run of the array ending at its root, so the last levels of
+//            a lookup stay within a page or two (breadth first order put each of them on its own page and
+//            lookups ran 1.3x slower than on the pointer tree). the root is the last node, children come
+//            before their parent and AVL_IMAGE_NONE in a child link means none
+//   trailer  u32 fnv-1a of the node array
+#define AVL_IMAGE_VERSION 1
+#define AVL_IMAGE_NONE 0xffffffffu
+
+typedef struct image_node {
+  int32_t key;
+  uint32_t left;
+  uint32_t right;
+}image_node;
+
+typedef struct avl_image {
+  const image_node *nodes;
+  uint32_t count;
+  uint32_t height;   // lookups never take more steps than this, even on a damaged image
+  uint32_t checksum;
+  size_t length;     // of the mapping
+  void *base;
+}avl_image;
+
+// false on a write error (or more than 2^32 - 1 nodes)
+bool saveAvlImage (binary_tree *root, FILE *out);
+bool saveAvlImageFile (binary_tree *root, const char *path);
+
+// maps the file read-only and checks the header and the length, not the nodes (that is what
+// verifyAvlImage is for). NULL when the file cannot be mapped or is not a valid image.
+// lookups stay inside the mapping whatever the nodes contain
+avl_image *openAvlImage (const char *path);
+void closeAvlImage (avl_image *image);
+
+// O(n): checksum, child links in range, postorder and key order
+bool verifyAvlImage (const avl_image *image);
+
+bool imageContains (const avl_image *image, int key);
+// largest key <= key, false when there is none
+bool imageFloor (const avl_image *image, int key, int *out);
+// calls visit for every key in [lo, hi] in ascending order, the same contract as rangeScanAvlTree
+size_t imageRangeScan (const avl_image *image, int lo, int hi, avl_visit visit, void *ctx);
+
+#endif
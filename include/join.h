@@ -0,0 +1,40 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <stddef.h>
+
+typedef struct binary_tree binary_tree;
+typedef struct node_pool node_pool;
+
+// join based primitives, every function consumes its input trees and reuses their nodes
+
+// every key of left < pivot -> data < every key of right, pivot is a detached node
+binary_tree *joinAvlTree (binary_tree *left, binary_tree *pivot, binary_tree *right);
+// splits root around key: keys below go to *left, above to *right, the node holding key (if any) to *found
+void splitAvlTree (binary_tree *root, int key, binary_tree **left, binary_tree **found, binary_tree **right);
+
+// removes every key in [lo, hi] with two splits and one join, O(log n) plus freeing what was cut out
+binary_tree *eraseRangeAvlTree (binary_tree *root, int lo, int hi);
+binary_tree *eraseRangeAvlTreePool (node_pool *pool, binary_tree *root, int lo, int hi);
+// same cut without the freeing: the keys in [lo, hi] come back in *range as an avl tree of their own,
+// so a caller with a latency budget can release them later or on another thread
+binary_tree *extractRangeAvlTree (binary_tree *root, int lo, int hi, binary_tree **range);
+
+// set operations in O(m*log(n/m + 1)), subtrees are merged on separate threads when the inputs are big
+// both trees must come from the same allocator, nodes dropped along the way are released to it
+// (pool-backed trees are merged on the calling thread since a pool is not thread safe)
+binary_tree *unionAvlTree (binary_tree *a, binary_tree *b);
+binary_tree *intersectAvlTree (binary_tree *a, binary_tree *b);
+// keys of a that are not in b
+binary_tree *differenceAvlTree (binary_tree *a, binary_tree *b);
+
+binary_tree *unionAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b);
+binary_tree *intersectAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b);
+binary_tree *differenceAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b);
+
+// batch insert/delete of an unsorted key array, built into a tree and merged in one go (one key at a
+// time when there is no memory for that tree)
+binary_tree *insertKeysAvlTree (binary_tree *root, const int *keys, size_t n);
+binary_tree *deleteKeysAvlTree (binary_tree *root, const int *keys, size_t n);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PERSISTENT_H
+#define PERSISTENT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// persistent (path copying) avl tree: an update copies the O(log n) nodes on its path, shares the rest
+// with the previous version and publishes the new root with one atomic store. readers never lock:
+// they pin the current version and keep reading it while writers move on.
+// old versions are reclaimed once no reader that could still see them is left (epochs),
+// and nodes shared between versions are freed with the last version using them (reference counts)
+
+#define PERSISTENT_MAX_READERS 64
+
+typedef struct persistent_node {
+  struct persistent_node *left;
+  struct persistent_node *right;
+  int data;
+  int height;
+  int refs;    // parents (nodes or versions) pointing here, only touched by the writer
+}persistent_node;
+
+typedef struct retired_version {
+  persistent_node *root;
+  unsigned long epoch;
+}retired_version;
+
+typedef struct persistent_avl {
+  _Atomic(persistent_node *) root;
+  atomic_ulong epoch;
+  // 0 for a free slot, 1 for a registered idle reader, otherwise the epoch its snapshot was taken in + 2
+  atomic_ulong readers[PERSISTENT_MAX_READERS];
+
+  pthread_mutex_t writeLock;
+  retired_version *retired;
+  size_t retiredCount;
+  size_t retiredCapacity;
+}persistent_avl;
+
+persistent_avl *createPersistentAvl (void);
+// no reader may be active anymore
+void destroyPersistentAvl (persistent_avl *tree);
+
+// writers serialize among themselves but never wait for readers, false when nothing changed (the key
+// was already there / missing, or memory ran out, which leaves the current version as it was)
+bool persistentInsert (persistent_avl *tree, int key);
+bool persistentDelete (persistent_avl *tree, int key);
+
+// a reader thread takes a slot once (-1 when all are taken) and brackets each snapshot with begin/end
+int persistentRegisterReader (persistent_avl *tree);
+void persistentUnregisterReader (persistent_avl *tree, int slot);
+const persistent_node *persistentReadBegin (persistent_avl *tree, int slot);
+void persistentReadEnd (persistent_avl *tree, int slot);
+
+// queries on a pinned snapshot
+bool persistentContains (const persistent_node *snapshot, int key);
+size_t persistentCount (const persistent_node *snapshot);
+
+#endif
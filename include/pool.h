@@ -0,0 +1,38 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+typedef struct binary_tree binary_tree;
+
+// a slab is one contiguous block of nodes handed out front to back
+typedef struct node_slab {
+  struct node_slab *next;
+  size_t capacity;
+  size_t used;
+  binary_tree *nodes;
+}node_slab;
+
+// per-tree node arena: nodes come from slabs, deleted nodes go on a freelist (chained through left)
+// and destroying the pool releases every node of the tree at once without walking it
+typedef struct node_pool {
+  node_slab *slabs;
+  binary_tree *freeList;
+  size_t nextCapacity;
+  size_t liveNodes;
+}node_pool;
+
+// slabCapacity is the node count of the first slab (0 picks a default), later slabs double up to a cap
+node_pool *createNodePool (size_t slabCapacity);
+void destroyNodePool (node_pool *pool);
+// drops every node but keeps the biggest slab around for the next tree
+void resetNodePool (node_pool *pool);
+
+binary_tree *poolAllocNode (node_pool *pool);
+void poolFreeNode (node_pool *pool, binary_tree *node);
+
+// node allocation used by the tree code, a NULL pool falls back to malloc/free
+binary_tree *newTreeNode (node_pool *pool, int key);
+void releaseTreeNode (node_pool *pool, binary_tree *node);
+
+#endif
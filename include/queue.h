@@ -1,19 +1,34 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
-// #include <stdbool.h>
-#include <stdlib.h> 
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef struct binary_tree binary_tree;
 
+// fifo of node pointers for breadth first walks, a ring buffer so nothing is allocated per node.
+// the first slots are inline (a ring on the stack covers trees up to a few hundred nodes without
+// touching the heap), past that the ring doubles, so a walk allocates O(log n) times at most
+#define QUEUE_INLINE_SLOTS 64
+
 typedef struct queue {
-  binary_tree *data;
-  struct queue *next;
+  binary_tree **slots;
+  size_t capacity;   // a power of two
+  size_t head;
+  size_t count;
+  binary_tree *inlineSlots[QUEUE_INLINE_SLOTS];
 }queue;
 
+// slots can point into the queue itself, so a queue must not be copied or moved once initialised
+void queueInit (queue *q);
+void queueFree (queue *q);
+// false when the ring could not grow (out of memory), the queue is unchanged then
+bool enQueue (queue *q, binary_tree *element);
+// NULL when empty
+binary_tree *deQueue (queue *q);
 
+static inline bool queueEmpty (const queue *q) {
+  return q -> count == 0;
+}
 
-void enQueue (queue **front, queue **rear, binary_tree *element);
-binary_tree *deQueue(queue **front, queue **rear);
-
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,28 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct binary_tree binary_tree;
+typedef struct node_pool node_pool;
+
+// binary on-disk format for the keys of a tree, all integers little endian:
+//   header   "AVLK", u32 format version, u64 key count
+//   payload  the keys in ascending order, each one as the gap to the previous key minus one
+//            (the first as its distance from INT_MIN) in LEB128, so dense keys take a byte each
+//   trailer  u32 adler-32 of header and payload
+#define AVL_FORMAT_VERSION 1
+
+// streams the keys out in order through a fixed buffer, false on a write error
+bool saveAvlTree (binary_tree *root, FILE *out);
+bool saveAvlTreeFile (binary_tree *root, const char *path);
+
+// rebuilds the tree in one pass as the keys stream in, already balanced (the shape buildAvlFromSorted
+// gives) so no rotation is done. true and the tree in *root, false for a bad header, a corrupt or
+// truncated stream or no memory, with nothing left allocated and *root NULL
+bool loadAvlTree (FILE *in, binary_tree **root);
+bool loadAvlTreePool (node_pool *pool, FILE *in, binary_tree **root);
+bool loadAvlTreeFile (const char *path, binary_tree **root);
+
+#endif
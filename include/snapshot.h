@@ -0,0 +1,25 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct binary_tree binary_tree;
+
+// frozen copy of a tree's keys in eytzinger (bfs) order: the children of slot k are 2k and 2k+1,
+// so the top levels share a few cache lines and a search is a branchless walk down one array.
+// the snapshot is immutable and independent from the tree, which can keep taking writes
+typedef struct avl_snapshot {
+  int *keys;       // 1 based, keys[0] is unused, cache line aligned
+  size_t n;
+}avl_snapshot;
+
+// O(n), NULL on allocation failure (an empty tree gives an empty snapshot)
+avl_snapshot *freezeAvlTree (binary_tree *root);
+void freeSnapshot (avl_snapshot *snapshot);
+
+bool snapshotContains (const avl_snapshot *snapshot, int key);
+// smallest key >= key
+bool snapshotLowerBound (const avl_snapshot *snapshot, int key, int *out);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tree.h"
+
+// operation statistics for the plain avl tree (tree.c and node allocation), to tell deeper trees, more
+// rotations and allocator churn apart when latency moves. build with -DAVL_STATS=1 to turn them on,
+// otherwise every AVL_STAT_ADD compiles to nothing and avlStatsRead reports zeros.
+// each thread bumps its own counters without any atomic read-modify-write, a read sums all the threads
+// (and the ones that already exited) so it can run while others keep updating
+#ifndef AVL_STATS
+#define AVL_STATS 0
+#endif
+
+typedef struct avl_stats {
+  uint64_t searches;
+  uint64_t inserts;
+  uint64_t deletes;
+  uint64_t comparisons;     // key comparisons on the way down
+  uint64_t pathLength;      // nodes visited on the way down, summed over all operations
+  uint64_t llRotations;
+  uint64_t rrRotations;
+  uint64_t lrRotations;
+  uint64_t rlRotations;
+  uint64_t retraceSteps;    // nodes rechecked on the way back up after an insert or delete
+  uint64_t allocs;
+  uint64_t frees;
+  // operations by the number of nodes their descent visited, the last bucket takes anything deeper
+  uint64_t depthHistogram[AVL_MAX_HEIGHT];
+}avl_stats;
+
+// sum over every thread since the start (or the last reset)
+void avlStatsRead (avl_stats *out);
+// zeroes every thread's counters, increments racing with it may survive
+void avlStatsReset (void);
+
+#if AVL_STATS
+
+#define AVL_STAT_COUNTERS (sizeof(avl_stats) / sizeof(uint64_t))
+
+// the calling thread's counters, laid out like avl_stats, NULL until its first update
+extern _Thread_local _Atomic uint64_t *avlThreadCounters;
+_Atomic uint64_t *avlStatsRegisterThread (void);
+
+// only the owning thread writes a counter, so a relaxed load and store is enough (a plain add once compiled)
+static inline void avlStatAdd (size_t index, uint64_t n) {
+  _Atomic uint64_t *counters = avlThreadCounters ? avlThreadCounters : avlStatsRegisterThread();
+  if(!counters) return;
+  atomic_store_explicit(&counters[index], atomic_load_explicit(&counters[index], memory_order_relaxed) + n,
+                        memory_order_relaxed);
+}
+
+#define AVL_STAT_ADD(field, n) avlStatAdd(offsetof(avl_stats, field) / sizeof(uint64_t), (n))
+#define AVL_STAT_DEPTH(depth) \
+  avlStatAdd(offsetof(avl_stats, depthHistogram) / sizeof(uint64_t) + \
+             ((depth) < AVL_MAX_HEIGHT ? (size_t)(depth) : AVL_MAX_HEIGHT - 1), 1)
+
+#else
+
+#define AVL_STAT_ADD(field, n) ((void)0)
+#define AVL_STAT_DEPTH(depth) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef TRAVERSE_H
+#define TRAVERSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tree.h"
+
+// fork-join walks over a whole tree, for scans and teardown. the tree is cut into subtree tasks kept on
+// one deque per thread: a thread works depth first through its own deque (newest task first) and an idle
+// thread steals the oldest task of another one, which is the biggest subtree left there, so the threads
+// stay busy however uneven the visits are. a subtree no higher than TRAVERSE_GRAIN_HEIGHT (about 2^10 nodes)
+// is walked on one thread with no task bookkeeping.
+// the calling thread takes part, the others come from a pool of helpers started on first use and parked
+// (not spinning) between walks and while there is nothing to steal. one walk at a time gets the helpers, a
+// walk that finds them taken (from another thread, or from inside a visit) runs on its calling thread only.
+// threads 0 means one per core, 1 walks on the calling thread only. nothing may change the tree during a walk
+#define TRAVERSE_GRAIN_HEIGHT 10
+
+// called once for every node, on some thread, with that thread's accumulator. the node's children are
+// read before the call, so visit may free the node
+typedef void (*avl_par_visit)(binary_tree *node, void *acc, void *ctx);
+// folds the accumulator of one thread into acc
+typedef void (*avl_par_merge)(void *acc, const void *part, void *ctx);
+
+// the generic walk. every thread's accumulator starts as a copy of the accSize bytes at acc (so acc holds
+// the identity on entry) and they are merged back into acc in thread order at the end. the visit order
+// is unspecified
+void parallelVisitAvlTree (binary_tree *root, int threads, avl_par_visit visit, avl_par_merge merge,
+                           void *acc, size_t accSize, void *ctx);
+
+typedef bool (*avl_key_filter)(int key, void *ctx);
+
+// the common reductions on top of it, a NULL filter keeps every key
+size_t parallelCountAvlTree (binary_tree *root, int threads, avl_key_filter keep, void *ctx);
+long long parallelSumAvlTree (binary_tree *root, int threads);
+// the kept keys in a malloced array (in no particular order), their number is returned.
+// NULL and 0 when nothing matched or memory ran out
+size_t parallelCollectAvlTree (binary_tree *root, int threads, avl_key_filter keep, void *ctx, int **keys);
+// freeTree on several threads, for malloced nodes (a pool backed tree goes with destroyNodePool)
+void parallelFreeTree (binary_tree *root, int threads);
+
+// breadth first, level by level, with the ring queue: visit gets each node and its depth (root 0).
+// false when the queue could not grow, the walk stops there
+bool levelOrderVisit (binary_tree *root, void (*visit)(binary_tree *node, int level, void *ctx), void *ctx);
+
+#endif
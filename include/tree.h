@@ -3,14 +3,71 @@
 #define TREE_H
 #include <stdbool.h>
 
+typedef struct node_pool node_pool;
+
+// balancing policy of insertAvlTree and deleteNodeAvlTree, picked at build time (-DAVL_POLICY=...):
+//   AVL_POLICY_AVL   the default, height holds the subtree height
+//   AVL_POLICY_WAVL  weak avl: height holds a rank, every rank difference (parent minus child, a missing
+//                    child has rank -1) is 1 or 2 and leaves have rank 0. inserts rebalance exactly like
+//                    avl, deletes do at most two rotations
+//   AVL_POLICY_RB    red-black in rank form: differences are 0 (a red node) or 1 and no 0-child has a
+//                    0-child. at most two rotations per insert and three per delete, taller trees
+// both rank policies keep the rank in the height field and share the node, search, traversal and
+// read-only code. join/split and the set operations, finger inserts, the bulk builds (build, load), the
+// write-ahead log (its replay) and the sharded forest (its resplits) write real heights, their sources
+// stop with an #error under the other policies
+#define AVL_POLICY_AVL 0
+#define AVL_POLICY_WAVL 1
+#define AVL_POLICY_RB 2
+#ifndef AVL_POLICY
+#define AVL_POLICY AVL_POLICY_AVL
+#endif
+
+// an avl tree with n nodes is at most 1.44*log2(n+2) high, with int keys (at most 2^32 nodes)
+// that stays under 46, so fixed size path stacks of this depth can never overflow.
+// wavl (after deletes) and red-black trees only promise 2*log2(n+1), up to 64
+#if AVL_POLICY == AVL_POLICY_AVL
+#define AVL_MAX_HEIGHT 48
+#else
+#define AVL_MAX_HEIGHT 68
+#endif
+
+// longest root to leaf path (in edges) below a node whose height field holds h
+#if AVL_POLICY == AVL_POLICY_RB
+#define AVL_HEIGHT_BOUND(h) (2 * (h) + 1)
+#else
+#define AVL_HEIGHT_BOUND(h) (h)
+#endif
+
+// subtree augmentation, off by default: built with -DAVL_AUGMENT=1 every node also carries its subtree
+// size and an aggregate of its subtree keys (the fixed size/sum/min/max below, nodes grow from 24 to 48
+// bytes), kept up to date by updateNode wherever heights are recomputed (retracing, all four rotations,
+// join, build). the order statistics in augment.h need it, make test-augment runs the tests with it on
+#ifndef AVL_AUGMENT
+#define AVL_AUGMENT 0
+#endif
+
+// monoid over the keys of a subtree, combineAggregate is associative and the empty aggregate is its identity
+typedef struct avl_aggregate {
+  long long sum;
+  int min;
+  int max;
+}avl_aggregate;
+
 typedef struct binary_tree {
   struct binary_tree *left;
   struct binary_tree *right;
   int data;
   int height;
+#if AVL_AUGMENT
+  int size;
+  avl_aggregate agg;
+#endif
 }binary_tree;
 
 void freeTree (binary_tree *root);
+// frees a tree node by node into its pool, to drop a whole pool-backed tree at once use destroyNodePool
+void freeTreePool (node_pool *pool, binary_tree *root);
 
 //tree traversels
 void inorder(binary_tree *root);
@@ -22,10 +79,40 @@ void display_tree(binary_tree *root);
 
 // int height (binary_tree *root);
 
+// node helpers shared with the other tree modules
+int NodeHeight(binary_tree *node);
+// the augmentation hook: recomputes height and, with AVL_AUGMENT, size and aggregate from the children
+void updateNode (binary_tree *node);
+int calculateBalanceFactor (binary_tree *node);
+// rotations relink prev to the new subtree root unless prev == root (no parent to update)
+binary_tree *llRotation (binary_tree *root, binary_tree *prev);
+binary_tree *rrRotation (binary_tree *root, binary_tree *prev);
+binary_tree *lrRotation (binary_tree *root, binary_tree *prev);
+binary_tree *rlRotation (binary_tree *root, binary_tree *prev);
+binary_tree *balanceNode (binary_tree *curr, binary_tree *prev);
+// the avl insert retrace after a node was hung under path[depth - 1] (default policy only). *stop gets
+// the level it ended at, -1 when it went past the root, and *rotated (may be NULL) whether that was a
+// rotation. the ancestors above *stop keep their heights, refreshing their augmentation is up to the caller
+binary_tree *retraceInsertPath (binary_tree *root, binary_tree **path, int depth, int *stop, bool *rotated);
+// rotations done so far by all threads (a double rotation counts once), for the benchmarks. taken from
+// the statistics in stats.h, so always 0 unless built with AVL_STATS
+unsigned long avlRotationCount (void);
+// "avl", "wavl" or "red-black"
+const char *avlBalancePolicyName (void);
+
+// the node holding key, NULL when there is none
+binary_tree *searchAvlTree (binary_tree *root, int key);
+
 // avl insert
 binary_tree *insertAvlTree (binary_tree *root, int key);
+// same as insertAvlTree but nodes come from the given pool (NULL means malloc)
+binary_tree *insertAvlTreePool (node_pool *pool, binary_tree *root, int key);
 
 binary_tree *insertBstGeneric(binary_tree *root, int key);
 // avl deletion
 binary_tree *deleteNodeAvlTree(binary_tree *root, int key);
+binary_tree *deleteNodeAvlTreePool(node_pool *pool, binary_tree *root, int key);
+// the delete itself: a node with two children takes over the key of its predecessor or successor and
+// that node is the one freed. *moved (unless moved is NULL) is then the node that took the key, else NULL
+binary_tree *refactorTree(node_pool *pool, binary_tree *root, int key, binary_tree **moved);
 #endif
\ No newline at end of file
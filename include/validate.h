@@ -0,0 +1,36 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stddef.h>
+
+#include "tree.h"
+
+// invariant checks for binary_tree, for tests and soak runs. checkAvlTree does ordering, stored heights,
+// balance and (with AVL_AUGMENT) sizes and aggregates in a single O(n) pass with key bounds instead of an
+// in order predecessor, so any int key is fine. checkAvlPath only checks the nodes on the search path of
+// one key and their children, O(log n): after an insert or delete of that key these are all the nodes
+// whose fields retracing or a rotation could have written. under the wavl and red-black policies the
+// height and balance checks are the policy's rank rules instead
+
+typedef enum avl_violation {
+  AVL_OK,
+  AVL_ORDER,       // a key outside the range its ancestors allow
+  AVL_HEIGHT,      // stored height is not one above the taller child (wavl: a leaf with a rank above 0)
+  AVL_BALANCE,     // children heights differ by more than one (rank policies: a rank difference rule)
+  AVL_AUGMENT_BAD, // stored size or aggregate does not match the children
+  AVL_TOO_DEEP     // deeper than any avl tree can be, probably a cycle
+}avl_violation;
+
+typedef struct avl_check {
+  avl_violation violation;
+  binary_tree *node;   // where it was found, NULL when the tree is fine
+  size_t nodes;        // nodes checked
+  int height;          // of the whole tree (checkAvlTree only), -1 when empty
+}avl_check;
+
+avl_violation checkAvlTree (binary_tree *root, avl_check *report);
+avl_violation checkAvlPath (binary_tree *root, int key, avl_check *report);
+
+const char *avlViolationName (avl_violation violation);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tree.h"
+
+// crash durable tree: every insert/delete is appended to a write-ahead log (<path>.log) before the call
+// returns, a checkpoint saves the whole tree (<path>.ckpt, the serialize.h format) and empties the log,
+// and opening loads the last checkpoint and replays the log after it.
+// inserts and deletes of single keys are idempotent as a sequence, so a log replayed over a checkpoint
+// that already contains it (a crash between the two steps of a checkpoint) still gives the right tree
+
+#define WAL_BUFFER 65536
+
+typedef enum wal_durability {
+  WAL_NONE,     // records are handed to the os when the buffer fills up, lost if the process dies before
+  WAL_GROUP,    // one fsync per group of records, a crash loses at most the last unsynced group
+  WAL_SYNC      // durable when the call returns, concurrent callers share fsyncs (group commit)
+}wal_durability;
+
+typedef struct wal_options {
+  wal_durability durability;
+  size_t groupRecords;        // WAL_GROUP syncs after this many records (0 for 256)...
+  unsigned groupMicros;       // ...or on the first update once the oldest unsynced record is this old (0 for 2000)
+  size_t checkpointRecords;   // checkpoint on its own once the log holds this many records, 0 for never
+}wal_options;
+
+typedef struct wal_tree {
+  // guards everything below except the file I/O, which runs unlocked by one flushing thread at a time
+  pthread_mutex_t lock;
+  pthread_cond_t flushed;
+  binary_tree *root;
+
+  wal_options options;
+  char *checkpointPath;
+  char *logPath;
+  int logFd;
+
+  // records are numbered from 1 on, these are the last one appended, written to the log and fsynced
+  uint64_t appended;
+  uint64_t written;
+  uint64_t synced;
+  uint64_t groupStart;    // when the oldest unsynced record was appended, in ns
+  uint64_t logRecords;    // records in the log file since the last checkpoint
+  bool flushing;
+  bool failed;            // an I/O error, the log can no longer be trusted and every update fails
+
+  size_t used;
+  unsigned char buffer[WAL_BUFFER];
+  unsigned char io[WAL_BUFFER];
+
+  // statistics
+  uint64_t replayed;      // log records applied when opening
+  uint64_t syncs;
+  uint64_t checkpoints;
+}wal_tree;
+
+// NULL options for WAL_GROUP defaults. NULL when the checkpoint is corrupt, the log is not a log, on an
+// I/O error or out of memory; a torn record at the end of the log (a crash mid write) is cut off and
+// everything before it replayed
+wal_tree *walOpen (const char *path, const wal_options *options);
+// syncs what is left and frees the tree, false when something could not be made durable
+bool walClose (wal_tree *wal);
+
+// the tree is updated either way, false means the update is not (and will never be) durable
+bool walInsert (wal_tree *wal, int key);
+bool walDelete (wal_tree *wal, int key);
+bool walContains (wal_tree *wal, int key);
+
+// makes every update so far durable whatever the durability level
+bool walSync (wal_tree *wal);
+// saves the tree next to the log and empties the log, updates wait for it to finish
+bool walCheckpoint (wal_tree *wal);
+
+#endif
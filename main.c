@@ -1,9 +1,36 @@
 #include "include/tree.h" 
+#include "include/pool.h"
+#include "include/build.h"
+#include "include/join.h"
+#include "include/avl_generic.h"
+#include "include/augment.h"
+#include "include/cursor.h"
+#include "include/snapshot.h"
+#include "include/batch.h"
+#include "include/persistent.h"
+#include "include/concurrent.h"
+#include "include/forest.h"
+#include "include/serialize.h"
+#include "include/wal.h"
+#include "include/stats.h"
+#include "include/compact.h"
+#include "include/bucket.h"
+#include "include/finger.h"
+#include "include/traverse.h"
+#include "include/queue.h"
+#include "include/validate.h"
+#include "include/image.h"
+#include "include/cache.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <limits.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 
 // ===== VALIDATION HELPERS (ALL USING 'data' FIELD) =====
@@ -15,61 +42,14 @@ int get_balance(binary_tree *node) {
     return node ? height(node->left) - height(node->right) : 0;
 }
 
-// Verify BST property (in-order traversal must be strictly increasing)
-void verify_bst(binary_tree *root, int *prev, bool *valid) {
-    if (!root || !*valid) return;
-    verify_bst(root->left, prev, valid);
-    if (*prev != -1 && root->data <= *prev) *valid = false;  // <-- data field
-    *prev = root->data;  // <-- data field
-    verify_bst(root->right, prev, valid);
-}
-
-bool is_valid_bst(binary_tree *root) {
-    int prev = -1;
-    bool valid = true;
-    verify_bst(root, &prev, &valid);
-    return valid;
-}
-
-// Verify AVL balance property (|balance| <= 1 everywhere)
-bool verify_avl_balance(binary_tree *root) {
-    if (!root) return true;
-    int bf = get_balance(root);
-    if (bf < -1 || bf > 1) {
-        printf("❌ Balance violation at data=%d (bf=%d)\n", root->data, bf);
-        return false;
-    }
-    return verify_avl_balance(root->left) && verify_avl_balance(root->right);
-}
-
-// Verify height consistency
-bool verify_heights(binary_tree *root) {
-    if (!root) return true;
-    int actual_height = 1 + (height(root->left) > height(root->right) ? height(root->left) : height(root->right));
-    if (root->height != actual_height) {
-        printf("❌ Height mismatch at data=%d: stored=%d, actual=%d\n", 
-               root->data, root->height, actual_height);
-        return false;
-    }
-    return verify_heights(root->left) && verify_heights(root->right);
-}
-
-// Full validation (BST + balance + heights)
+// Full validation (BST + balance + heights, and sizes/aggregates with AVL_AUGMENT) in one pass of checkAvlTree
 bool validate_avl_tree(binary_tree *root, const char *test_name) {
-    if (!root) return true;  // Empty tree is valid AVL
-    
-    bool bst_ok = is_valid_bst(root);
-    bool balance_ok = verify_avl_balance(root);
-    bool height_ok = verify_heights(root);
-    
-    if (!bst_ok || !balance_ok || !height_ok) {
-        printf("\n❌ TEST FAILED: %s\n", test_name);
-        if (!bst_ok) printf("   → BST property violated\n");
-        if (!balance_ok) printf("   → Balance factor violation\n");
-        if (!height_ok) printf("   → Height inconsistency\n");
-        return false;
-    }
-    return true;
+    avl_check report;
+    if (checkAvlTree(root, &report) == AVL_OK) return true;
+
+    printf("\n❌ TEST FAILED: %s\n", test_name);
+    printf("   → %s violated at data=%d\n", avlViolationName(report.violation), report.node->data);
+    return false;
 }
 
 // Search node by value (using 'data' field)
@@ -365,13 +345,2256 @@ void run_all_deletion_tests() {
         printf("✅ TEST 17 PASSED: Delete all nodes in reverse sorted order\n");
     }
 
+    // ===== TEST 18: Large ascending build and interleaved deletions =====
+    {
+        binary_tree *root = NULL;
+        for (int i = 0; i < 100000; i++) root = insertAvlTree(root, i);
+        assert(validate_avl_tree(root, "TEST 18: Ascending build") && "Tree unbalanced!");
+        assert(root->height <= 24 && "Ascending inserts must keep the tree logarithmic");
+
+        for (int i = 0; i < 100000; i += 2) root = deleteNodeAvlTree(root, i);
+        assert(validate_avl_tree(root, "TEST 18: Every other key deleted"));
+        for (int i = 0; i < 100000; i++) assert(search(root, i) == (i % 2 == 1));
+        freeTree(root);
+        printf("✅ TEST 18 PASSED: Large ascending build and interleaved deletions\n");
+    }
+
     printf("\n========================================\n");
-    printf("🎉 ALL 18 TESTS PASSED SUCCESSFULLY!\n");
+    printf("🎉 ALL 19 TESTS PASSED SUCCESSFULLY!\n");
     printf("   • Insertion: insertAvlTree()\n");
     printf("   • All rotations covered: LL, LR, RR, RL\n");
     printf("========================================\n");
 }
 
+void run_all_pool_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING NODE POOL TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== POOL TEST 1: pool-backed tree behaves like the malloc one =====
+    {
+        node_pool *pool = createNodePool(4);  // tiny slabs to force several of them
+        binary_tree *root = NULL;
+        for (int i = 1; i <= 200; i++) root = insertAvlTreePool(pool, root, i * 7 % 211);
+        assert(validate_avl_tree(root, "POOL TEST 1: Pool insertion"));
+        assert(pool->liveNodes == 200 && "Every insert takes one pool node");
+        for (int i = 1; i <= 200; i++) assert(search(root, i * 7 % 211));
+        destroyNodePool(pool);
+        printf("✅ POOL TEST 1 PASSED: Pool-backed insertion\n");
+    }
+
+    // ===== POOL TEST 2: deleted nodes are recycled =====
+    {
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        for (int i = 0; i < 64; i++) root = insertAvlTreePool(pool, root, i);
+        for (int i = 0; i < 32; i++) root = deleteNodeAvlTreePool(pool, root, i);
+        assert(pool->liveNodes == 32 && "Deletion returns nodes to the pool");
+        assert(validate_avl_tree(root, "POOL TEST 2: Post-deletion"));
+
+        binary_tree *recycled = pool->freeList;
+        root = insertAvlTreePool(pool, root, 1000);
+        assert(search(root, 1000) && pool->freeList != recycled && "Insert reuses a freed node");
+        assert(validate_avl_tree(root, "POOL TEST 2: Reinsertion"));
+        destroyNodePool(pool);
+        printf("✅ POOL TEST 2 PASSED: Freelist recycling\n");
+    }
+
+    // ===== POOL TEST 3: reset keeps the pool usable =====
+    {
+        node_pool *pool = createNodePool(8);
+        binary_tree *root = NULL;
+        for (int i = 0; i < 100; i++) root = insertAvlTreePool(pool, root, i);
+        resetNodePool(pool);
+        assert(pool->liveNodes == 0);
+        root = NULL;
+        for (int i = 0; i < 100; i++) root = insertAvlTreePool(pool, root, -i);
+        assert(validate_avl_tree(root, "POOL TEST 3: Reuse after reset"));
+        destroyNodePool(pool);
+        printf("✅ POOL TEST 3 PASSED: Pool reset\n");
+    }
+}
+
+void run_all_build_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING BULK LOAD TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== BUILD TEST 1: sorted input of every small size =====
+    {
+        int keys[64];
+        for (int i = 0; i < 64; i++) keys[i] = i * 3 - 50;
+        for (int n = 0; n <= 64; n++) {
+            binary_tree *root = buildAvlFromSorted(keys, n);
+            assert((n == 0) == (root == NULL));
+            assert(validate_avl_tree(root, "BUILD TEST 1: Sorted build"));
+            for (int i = 0; i < 64; i++) assert(search(root, keys[i]) == (i < n));
+            freeTree(root);
+        }
+        printf("✅ BUILD TEST 1 PASSED: Sorted builds of size 0..64\n");
+    }
+
+    // ===== BUILD TEST 2: unsorted input with duplicates and negatives =====
+    {
+        int keys[] = {5, -3, 99, 5, 0, -2147483647 - 1, 2147483647, 42, -3, 17, 0};
+        binary_tree *root = buildAvlFromUnsorted(keys, 11);
+        assert(validate_avl_tree(root, "BUILD TEST 2: Unsorted build"));
+        for (int i = 0; i < 11; i++) assert(search(root, keys[i]));
+        assert(keys[0] == 5 && keys[1] == -3 && "Input must not be modified");
+
+        // a built tree keeps working with the incremental operations
+        root = insertAvlTree(root, 6);
+        root = deleteNodeAvlTree(root, 99);
+        assert(search(root, 6) && !search(root, 99));
+        assert(validate_avl_tree(root, "BUILD TEST 2: Updates after build"));
+        freeTree(root);
+        printf("✅ BUILD TEST 2 PASSED: Unsorted build with duplicates\n");
+    }
+
+    // ===== BUILD TEST 3: sortUniqueKeys =====
+    {
+        int keys[] = {3, 1, 3, -1, 2, 1, -1};
+        size_t n = sortUniqueKeys(keys, 7);
+        int expected[] = {-1, 1, 2, 3};
+        assert(n == 4);
+        for (size_t i = 0; i < n; i++) assert(keys[i] == expected[i]);
+        printf("✅ BUILD TEST 3 PASSED: Sort and dedup\n");
+    }
+}
+
+typedef struct point { double x, y; } point;
+AVL_GENERIC_DEFINE(word_map, const char *, point, AVL_LESS_STRING)
+AVL_GENERIC_DEFINE(int_set, int, avl_empty, AVL_LESS_NUMERIC)
+
+#define GREATER(a, b) ((a) > (b))
+AVL_GENERIC_DEFINE(desc_map, long long, int, GREATER)
+
+// height of a valid generic int_set subtree with keys in (lo, hi), -2 when something is off
+int int_set_check(int_set_node *node, long long lo, long long hi) {
+    if (!node) return -1;
+    if (node->key <= lo || node->key >= hi) return -2;
+    int l = int_set_check(node->left, lo, node->key);
+    int r = int_set_check(node->right, node->key, hi);
+    if (l == -2 || r == -2 || l - r > 1 || r - l > 1) return -2;
+    int h = (l > r ? l : r) + 1;
+    return h == node->height ? h : -2;
+}
+
+void run_all_generic_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING GENERIC TREE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== GENERIC TEST 1: string keys with struct values =====
+    {
+        word_map map;
+        word_map_init(&map);
+        const char *words[] = {"pear", "apple", "fig", "kiwi", "date", "lime", "plum", "banana"};
+        for (int i = 0; i < 8; i++) {
+            point *p = word_map_emplace(&map, words[i], NULL);
+            p->x = i;
+            p->y = -i;
+        }
+        bool inserted = true;
+        word_map_emplace(&map, "fig", &inserted);
+        assert(!inserted && word_map_size(&map) == 8 && "Existing key keeps its node");
+        assert(word_map_find(&map, "kiwi")->x == 3 && word_map_find(&map, "banana")->y == -7);
+        assert(!word_map_find(&map, "grape"));
+
+        point removed;
+        assert(word_map_erase(&map, "apple", &removed) && removed.x == 1);
+        assert(!word_map_erase(&map, "apple", NULL) && word_map_size(&map) == 7);
+        assert(word_map_find(&map, "pear")->x == 0 && word_map_find(&map, "plum")->x == 6);
+        word_map_clear(&map);
+        printf("✅ GENERIC TEST 1 PASSED: String keys with in-node values\n");
+    }
+
+    // ===== GENERIC TEST 2: int set stays a valid avl tree =====
+    {
+        int_set set;
+        int_set_init(&set);
+#if !AVL_AUGMENT
+        assert(sizeof(int_set_node) == sizeof(binary_tree) && "Key-only set costs no more than binary_tree");
+#else
+        assert(sizeof(int_set_node) <= sizeof(binary_tree) && "Key-only set costs no more than binary_tree");
+#endif
+        for (int i = 0; i < 1000; i++) int_set_insert(&set, i * 37 % 1009, (avl_empty){});
+        for (int i = 0; i < 1000; i += 3) int_set_erase(&set, i * 37 % 1009, NULL);
+        assert(int_set_check(set.root, INT_MIN, INT_MAX) >= 0 && "Int set must stay an avl tree");
+        for (int i = 0; i < 1000; i++) assert(int_set_contains(&set, i * 37 % 1009) == (i % 3 != 0));
+        int_set_clear(&set);
+        printf("✅ GENERIC TEST 2 PASSED: Int set\n");
+    }
+
+    // ===== GENERIC TEST 3: custom comparator =====
+    {
+        desc_map map;
+        desc_map_init(&map);
+        for (long long k = 0; k < 100; k++) desc_map_insert(&map, k * 1000000000LL, (int)k);
+        desc_map_insert(&map, 0, 42);
+        assert(desc_map_size(&map) == 100 && *desc_map_find(&map, 0) == 42);
+        assert(map.root->left->key > map.root->key && "Greater comparator puts larger keys on the left");
+        desc_map_clear(&map);
+        printf("✅ GENERIC TEST 3 PASSED: Custom comparator\n");
+    }
+}
+
+#if AVL_AUGMENT
+void run_all_augment_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING ORDER STATISTICS TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // reference: keys present in a sorted array
+    int n = 0, sorted[600];
+    binary_tree *root = NULL;
+    for (int i = 0; i < 600; i++) root = insertAvlTree(root, (i * 389) % 1201 - 600);
+    for (int i = 0; i < 600; i += 4) root = deleteNodeAvlTree(root, (i * 389) % 1201 - 600);
+    for (int k = -600; k <= 600; k++) if (search(root, k)) sorted[n++] = k;
+    assert(validate_avl_tree(root, "AUGMENT: Mixed updates"));
+
+    // ===== AUGMENT TEST 1: rank and select =====
+    {
+        assert(sizeAvlTree(root) == n);
+        for (int i = 0; i < n; i++) {
+            assert(selectAvlTree(root, i)->data == sorted[i]);
+            assert(rankAvlTree(root, sorted[i]) == i);
+            assert(rankAvlTree(root, sorted[i] + 1) == i + 1);
+        }
+        assert(!selectAvlTree(root, n) && !selectAvlTree(root, -1));
+        assert(percentileAvlTree(root, 0)->data == sorted[0]);
+        assert(percentileAvlTree(root, 1)->data == sorted[n - 1]);
+        assert(percentileAvlTree(root, 0.5)->data == sorted[(n + 1) / 2 - 1]);
+        printf("✅ AUGMENT TEST 1 PASSED: Rank, select, percentile\n");
+    }
+
+    // ===== AUGMENT TEST 2: range count and aggregates =====
+    {
+        for (int lo = -650; lo <= 650; lo += 37) {
+            for (int hi = lo - 5; hi <= 650; hi += 53) {
+                int count = 0, got;
+                long long sum = 0;
+                int min = INT_MAX, max = INT_MIN;
+                for (int i = 0; i < n; i++) {
+                    if (sorted[i] < lo || sorted[i] > hi) continue;
+                    count++;
+                    sum += sorted[i];
+                    if (sorted[i] < min) min = sorted[i];
+                    if (sorted[i] > max) max = sorted[i];
+                }
+                avl_aggregate agg = aggregateRangeAvlTree(root, lo, hi, &got);
+                assert(countRangeAvlTree(root, lo, hi) == count && got == count);
+                assert(agg.sum == sum && agg.min == min && agg.max == max);
+            }
+        }
+        assert(countRangeAvlTree(root, INT_MIN, INT_MAX) == n);
+        printf("✅ AUGMENT TEST 2 PASSED: Range count, sum, min, max\n");
+    }
+
+    freeTree(root);
+}
+#endif
+
+typedef struct scan_state { int keys[64]; int n; int limit; } scan_state;
+
+bool collect_key(int key, void *ctx) {
+    scan_state *state = ctx;
+    state->keys[state->n++] = key;
+    return state->n < state->limit;
+}
+
+void run_all_cursor_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING CURSOR / RANGE SCAN TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // keys 0, 5, 10, ..., 495 inserted in a scrambled order
+    binary_tree *root = NULL;
+    for (int i = 0; i < 100; i++) root = insertAvlTree(root, (i * 37 % 100) * 5);
+    avl_cursor cursor;
+
+    // ===== CURSOR TEST 1: full forward and backward iteration =====
+    {
+        int expected = 0;
+        for (cursorFirst(&cursor, root); cursorValid(&cursor); cursorNext(&cursor)) {
+            assert(cursorKey(&cursor) == expected);
+            expected += 5;
+        }
+        assert(expected == 500 && !cursorNext(&cursor));
+
+        expected = 495;
+        for (cursorLast(&cursor, root); cursorValid(&cursor); cursorPrev(&cursor)) {
+            assert(cursorKey(&cursor) == expected);
+            expected -= 5;
+        }
+        assert(expected == -5);
+
+        cursorFirst(&cursor, NULL);
+        assert(!cursorValid(&cursor) && !cursorNode(&cursor));
+        printf("✅ CURSOR TEST 1 PASSED: Forward and backward iteration\n");
+    }
+
+    // ===== CURSOR TEST 2: seeks and point queries =====
+    {
+        for (int key = -7; key <= 503; key++) {
+            int up = (key + 4) / 5 * 5, down = key / 5 * 5, out;
+            if (key < 0) up = 0, down = -5;
+
+            cursorLowerBound(&cursor, root, key);
+            assert(up > 495 ? !cursorValid(&cursor) : cursorKey(&cursor) == up);
+            cursorUpperBound(&cursor, root, key);
+            int above = key % 5 == 0 && key >= 0 ? key + 5 : up;
+            assert(above > 495 ? !cursorValid(&cursor) : cursorKey(&cursor) == above);
+            cursorFloor(&cursor, root, key);
+            if (down > 495) down = 495;
+            assert(down < 0 ? !cursorValid(&cursor) : cursorKey(&cursor) == down);
+
+            assert(floorAvlTree(root, key, &out) == (down >= 0) && (down < 0 || out == down));
+            assert(ceilAvlTree(root, key, &out) == (up <= 495) && (up > 495 || out == up));
+            int below = key % 5 == 0 && key >= 0 ? key - 5 : down;
+            assert(predecessorAvlTree(root, key, &out) == (below >= 0) && (below < 0 || out == below));
+            assert(successorAvlTree(root, key, &out) == (above <= 495) && (above > 495 || out == above));
+        }
+
+        // a cursor placed by a seek keeps walking from there
+        cursorLowerBound(&cursor, root, 251);
+        assert(cursorKey(&cursor) == 255 && cursorPrev(&cursor) && cursorKey(&cursor) == 250);
+        assert(cursorNext(&cursor) && cursorNext(&cursor) && cursorKey(&cursor) == 260);
+        printf("✅ CURSOR TEST 2 PASSED: Seeks, floor, ceil, predecessor, successor\n");
+    }
+
+    // ===== CURSOR TEST 3: range scans =====
+    {
+        scan_state state = {{0}, 0, 64};
+        assert(rangeScanAvlTree(root, 12, 61, collect_key, &state) == 10);
+        for (int i = 0; i < 10; i++) assert(state.keys[i] == 15 + 5 * i);
+
+        state.n = 0;
+        state.limit = 3;
+        assert(rangeScanAvlTree(root, 0, 1000, collect_key, &state) == 3 && state.keys[2] == 10);
+
+        state.n = 0;
+        state.limit = 64;
+        assert(rangeScanAvlTree(root, 61, 12, collect_key, &state) == 0);
+        assert(rangeScanAvlTree(root, 496, 2000, collect_key, &state) == 0);
+        assert(rangeScanAvlTree(root, 495, 495, collect_key, &state) == 1 && state.keys[0] == 495);
+        printf("✅ CURSOR TEST 3 PASSED: Range scans\n");
+    }
+
+    freeTree(root);
+}
+
+void run_all_snapshot_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING FROZEN SNAPSHOT TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== SNAPSHOT TEST 1: lookups agree with the tree for every size =====
+    {
+        for (int n = 0; n <= 70; n++) {
+            binary_tree *root = NULL;
+            for (int i = 0; i < n; i++) root = insertAvlTree(root, (i * 11 % 71) * 3);
+            avl_snapshot *snapshot = freezeAvlTree(root);
+            assert(snapshot && snapshot->n == (size_t)n);
+            for (int key = -2; key <= 215; key++) {
+                int expected, got;
+                bool has = ceilAvlTree(root, key, &expected);
+                assert(snapshotContains(snapshot, key) == search(root, key));
+                assert(snapshotLowerBound(snapshot, key, &got) == has && (!has || got == expected));
+            }
+            freeSnapshot(snapshot);
+            freeTree(root);
+        }
+        printf("✅ SNAPSHOT TEST 1 PASSED: Lookups match the tree\n");
+    }
+
+    // ===== SNAPSHOT TEST 2: the snapshot is unaffected by later writes =====
+    {
+        binary_tree *root = NULL;
+        for (int i = 0; i < 100; i++) root = insertAvlTree(root, i);
+        avl_snapshot *snapshot = freezeAvlTree(root);
+        for (int i = 0; i < 100; i += 2) root = deleteNodeAvlTree(root, i);
+        root = insertAvlTree(root, 1000);
+        for (int i = 0; i < 100; i++) assert(snapshotContains(snapshot, i));
+        assert(!snapshotContains(snapshot, 1000));
+        freeSnapshot(snapshot);
+        freeTree(root);
+        printf("✅ SNAPSHOT TEST 2 PASSED: Snapshot isolation\n");
+    }
+}
+
+void run_all_batch_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING BATCHED LOOKUP TEST SUITE\n");
+    printf("========================================\n\n");
+
+    binary_tree *root = NULL;
+    for (int i = 0; i < 500; i++) root = insertAvlTree(root, (i * 173 % 500) * 2);
+
+    // ===== BATCH TEST 1: unsorted batches of several sizes =====
+    {
+        int keys[300];
+        binary_tree *results[300];
+        for (int n = 0; n <= 300; n += 37) {
+            for (int i = 0; i < n; i++) keys[i] = (i * 7919) % 1003 - 1;
+            searchBatchAvlTree(root, keys, n, results);
+            for (int i = 0; i < n; i++) {
+                assert((results[i] != NULL) == search(root, keys[i]));
+                assert(!results[i] || results[i]->data == keys[i]);
+            }
+        }
+        searchBatchAvlTree(NULL, keys, 10, results);
+        for (int i = 0; i < 10; i++) assert(!results[i]);
+
+        // a tree tall enough for the prefetching lanes to kick in
+        int big = 1 << 21;
+        int *even = malloc(big * sizeof(int));
+        for (int i = 0; i < big; i++) even[i] = 2 * i;
+        binary_tree *tall = buildAvlFromSorted(even, big);
+        for (int i = 0; i < 300; i++) keys[i] = (int)((i * 2654435761u) % (unsigned)(2 * big));
+        searchBatchAvlTree(tall, keys, 300, results);
+        for (int i = 0; i < 300; i++) {
+            assert((results[i] != NULL) == (keys[i] % 2 == 0));
+            assert(!results[i] || results[i]->data == keys[i]);
+        }
+        for (int i = 0; i < 300; i++) keys[i] = i * 13001 + i % 2;
+        searchSortedBatchAvlTree(tall, keys, 300, results);
+        for (int i = 0; i < 300; i++) assert((results[i] != NULL) == (keys[i] % 2 == 0));
+        freeTree(tall);
+        free(even);
+        printf("✅ BATCH TEST 1 PASSED: Interleaved batch lookup\n");
+    }
+
+    // ===== BATCH TEST 2: sorted batches with duplicates =====
+    {
+        int keys[400];
+        binary_tree *results[400];
+        for (int i = 0; i < 400; i++) keys[i] = i * 5 / 2 - 3;  // ascending, with repeats
+        searchSortedBatchAvlTree(root, keys, 400, results);
+        for (int i = 0; i < 400; i++) {
+            assert((results[i] != NULL) == search(root, keys[i]));
+            assert(!results[i] || results[i]->data == keys[i]);
+        }
+        printf("✅ BATCH TEST 2 PASSED: Sorted batch lookup\n");
+    }
+
+    freeTree(root);
+}
+
+// height of a valid persistent subtree with keys in (lo, hi), -2 when something is off
+int persistent_check(const persistent_node *node, long long lo, long long hi) {
+    if (!node) return -1;
+    if (node->data <= lo || node->data >= hi) return -2;
+    int l = persistent_check(node->left, lo, node->data);
+    int r = persistent_check(node->right, node->data, hi);
+    if (l == -2 || r == -2 || l - r > 1 || r - l > 1) return -2;
+    int h = (l > r ? l : r) + 1;
+    return h == node->height ? h : -2;
+}
+
+typedef struct reader_args { persistent_avl *tree; atomic_int *stop; long snapshots; bool ok; } reader_args;
+
+// the writer only ever inserts 0, 1, 2, ... in order, so any consistent snapshot holds a prefix
+void *persistent_reader(void *arg) {
+    reader_args *args = arg;
+    int slot = persistentRegisterReader(args->tree);
+    args->ok = slot >= 0;
+    while (args->ok && !atomic_load(args->stop)) {
+        const persistent_node *snapshot = persistentReadBegin(args->tree, slot);
+        size_t count = persistentCount(snapshot);
+        if (count && (!persistentContains(snapshot, (int)count - 1) || persistentContains(snapshot, (int)count)))
+            args->ok = false;
+        if (persistent_check(snapshot, INT_MIN - 1LL, INT_MAX + 1LL) == -2) args->ok = false;
+        persistentReadEnd(args->tree, slot);
+        args->snapshots++;
+    }
+    if (slot >= 0) persistentUnregisterReader(args->tree, slot);
+    return NULL;
+}
+
+void run_all_persistent_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING PERSISTENT TREE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== PERSISTENT TEST 1: updates keep the tree valid =====
+    {
+        persistent_avl *tree = createPersistentAvl();
+        int slot = persistentRegisterReader(tree);
+        for (int i = 0; i < 500; i++) assert(persistentInsert(tree, i * 7 % 503));
+        assert(!persistentInsert(tree, 0) && !persistentDelete(tree, 9999));
+        for (int i = 0; i < 500; i += 3) assert(persistentDelete(tree, i * 7 % 503));
+
+        const persistent_node *snapshot = persistentReadBegin(tree, slot);
+        assert(persistent_check(snapshot, INT_MIN - 1LL, INT_MAX + 1LL) >= 0);
+        for (int i = 0; i < 500; i++) assert(persistentContains(snapshot, i * 7 % 503) == (i % 3 != 0));
+        persistentReadEnd(tree, slot);
+        persistentUnregisterReader(tree, slot);
+        destroyPersistentAvl(tree);
+        printf("✅ PERSISTENT TEST 1 PASSED: Path-copying insert and delete\n");
+    }
+
+    // ===== PERSISTENT TEST 2: a pinned snapshot never changes =====
+    {
+        persistent_avl *tree = createPersistentAvl();
+        int slot = persistentRegisterReader(tree);
+        for (int i = 0; i < 100; i++) persistentInsert(tree, i);
+
+        const persistent_node *snapshot = persistentReadBegin(tree, slot);
+        for (int i = 0; i < 100; i += 2) persistentDelete(tree, i);
+        for (int i = 100; i < 200; i++) persistentInsert(tree, i);
+        assert(persistentCount(snapshot) == 100);
+        for (int i = 0; i < 200; i++) assert(persistentContains(snapshot, i) == (i < 100));
+        assert(persistent_check(snapshot, INT_MIN - 1LL, INT_MAX + 1LL) >= 0);
+        assert(tree->retiredCount > 0 && "Versions visible to the reader are kept");
+        persistentReadEnd(tree, slot);
+
+        // the next update frees everything the pinned reader was holding on to
+        persistentInsert(tree, 1000);
+        assert(tree->retiredCount == 0);
+        snapshot = persistentReadBegin(tree, slot);
+        assert(persistentCount(snapshot) == 151);
+        persistentReadEnd(tree, slot);
+        persistentUnregisterReader(tree, slot);
+        destroyPersistentAvl(tree);
+        printf("✅ PERSISTENT TEST 2 PASSED: Snapshot isolation and reclamation\n");
+    }
+
+    // ===== PERSISTENT TEST 3: lock-free readers alongside a writer =====
+    {
+        persistent_avl *tree = createPersistentAvl();
+        atomic_int stop;
+        atomic_init(&stop, 0);
+        reader_args args[3];
+        pthread_t readers[3];
+        for (int i = 0; i < 3; i++) {
+            args[i] = (reader_args){tree, &stop, 0, true};
+            pthread_create(&readers[i], NULL, persistent_reader, &args[i]);
+        }
+        for (int i = 0; i < 3000; i++) persistentInsert(tree, i);
+        atomic_store(&stop, 1);
+        for (int i = 0; i < 3; i++) {
+            pthread_join(readers[i], NULL);
+            assert(args[i].ok && "Reader saw an inconsistent snapshot");
+        }
+        destroyPersistentAvl(tree);
+        printf("✅ PERSISTENT TEST 3 PASSED: Concurrent readers\n");
+    }
+}
+
+// height of a quiescent concurrent subtree with keys in (lo, hi) hanging off parent, -2 when something is off
+int concurrent_check(concurrent_node *node, concurrent_node *parent, long long lo, long long hi) {
+    if (!node) return 0;
+    if (node->key <= lo || node->key >= hi || atomic_load(&node->parent) != parent) return -2;
+    int l = concurrent_check(atomic_load(&node->left), node, lo, node->key);
+    int r = concurrent_check(atomic_load(&node->right), node, node->key, hi);
+    if (l == -2 || r == -2 || abs(l - r) > 1) return -2;
+    int height = (l > r ? l : r) + 1;
+    return atomic_load(&node->height) == height ? height : -2;
+}
+
+typedef struct concurrent_args { concurrent_avl *tree; int id, threads, range, ops; atomic_int *stop; bool ok; } concurrent_args;
+
+// each writer owns the keys congruent to its id, so it alone knows what contains() must answer for them
+void *concurrent_writer(void *arg) {
+    concurrent_args *args = arg;
+    int slot = concurrentRegisterThread(args->tree);
+    char *mine = calloc(args->range, 1);
+    unsigned long long state = 0x9e3779b97f4a7c15ULL * (args->id + 1);
+    for (int i = 0; i < args->ops; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        int key = (int)(state % (args->range / args->threads)) * args->threads + args->id;
+        int op = (int)(state >> 40) % 3;
+        if (op == 0) {
+            if (concurrentInsert(args->tree, slot, key) == mine[key]) args->ok = false;
+            mine[key] = 1;
+        } else if (op == 1) {
+            if (concurrentDelete(args->tree, slot, key) != mine[key]) args->ok = false;
+            mine[key] = 0;
+        } else if (concurrentContains(args->tree, slot, key) != mine[key]) {
+            args->ok = false;
+        }
+    }
+    for (int key = args->id; key < args->range; key += args->threads)
+        if (concurrentContains(args->tree, slot, key) != mine[key]) args->ok = false;
+    free(mine);
+    concurrentUnregisterThread(args->tree, slot);
+    return NULL;
+}
+
+// the even keys are never touched by the writers and have to stay visible through all their rotations
+void *concurrent_reader(void *arg) {
+    concurrent_args *args = arg;
+    int slot = concurrentRegisterThread(args->tree);
+    while (!atomic_load(args->stop)) {
+        for (int key = 0; key < args->range; key += 2)
+            if (!concurrentContains(args->tree, slot, key)) args->ok = false;
+    }
+    concurrentUnregisterThread(args->tree, slot);
+    return NULL;
+}
+
+void *concurrent_churn(void *arg) {
+    concurrent_args *args = arg;
+    int slot = concurrentRegisterThread(args->tree);
+    for (int round = 0; round < args->ops; round++) {
+        for (int key = 1 + 2 * args->id; key < args->range; key += 2 * args->threads) concurrentInsert(args->tree, slot, key);
+        for (int key = 1 + 2 * args->id; key < args->range; key += 2 * args->threads) concurrentDelete(args->tree, slot, key);
+    }
+    concurrentUnregisterThread(args->tree, slot);
+    return NULL;
+}
+
+void run_all_concurrent_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING CONCURRENT TREE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== CONCURRENT TEST 1: single-threaded against a reference =====
+    {
+        concurrent_avl *tree = createConcurrentAvl();
+        int slot = concurrentRegisterThread(tree);
+        char present[2000] = {0};
+        for (int i = 0; i < 20000; i++) {
+            int key = (i * 7919) % 2000;
+            if (i % 3 == 2) {
+                assert(concurrentDelete(tree, slot, key) == present[key]);
+                present[key] = 0;
+            } else {
+                assert(concurrentInsert(tree, slot, key) == !present[key]);
+                present[key] = 1;
+            }
+        }
+        size_t expected = 0;
+        for (int key = 0; key < 2000; key++) {
+            assert(concurrentContains(tree, slot, key) == present[key]);
+            expected += present[key];
+        }
+        assert(concurrentSize(tree) == expected);
+        assert(concurrent_check(atomic_load(&tree->holder.right), &tree->holder, INT_MIN - 1LL, INT_MAX + 1LL) >= 0);
+
+        // ascending inserts are the worst case for the rotations
+        for (int key = 2000; key < 100000; key++) concurrentInsert(tree, slot, key);
+        int height = concurrent_check(atomic_load(&tree->holder.right), &tree->holder, INT_MIN - 1LL, INT_MAX + 1LL);
+        assert(height > 0 && height <= 25 && "AVL height bound");
+        concurrentUnregisterThread(tree, slot);
+        destroyConcurrentAvl(tree);
+        printf("✅ CONCURRENT TEST 1 PASSED: Sequential insert, delete and contains\n");
+    }
+
+    // ===== CONCURRENT TEST 2: writers on interleaved key sets =====
+    {
+        concurrent_avl *tree = createConcurrentAvl();
+        concurrent_args args[4];
+        pthread_t threads[4];
+        for (int i = 0; i < 4; i++) {
+            args[i] = (concurrent_args){tree, i, 4, 4096, 50000, NULL, true};
+            pthread_create(&threads[i], NULL, concurrent_writer, &args[i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+            assert(args[i].ok && "A writer saw a wrong answer for its own keys");
+        }
+        assert(concurrent_check(atomic_load(&tree->holder.right), &tree->holder, INT_MIN - 1LL, INT_MAX + 1LL) >= 0);
+        destroyConcurrentAvl(tree);
+        printf("✅ CONCURRENT TEST 2 PASSED: Concurrent writers\n");
+    }
+
+    // ===== CONCURRENT TEST 3: readers never miss keys moved by rotations =====
+    {
+        concurrent_avl *tree = createConcurrentAvl();
+        int slot = concurrentRegisterThread(tree);
+        for (int key = 0; key < 2048; key += 2) concurrentInsert(tree, slot, key);
+        concurrentUnregisterThread(tree, slot);
+
+        atomic_int stop;
+        atomic_init(&stop, 0);
+        concurrent_args readers[2], writers[2];
+        pthread_t readerThreads[2], writerThreads[2];
+        for (int i = 0; i < 2; i++) {
+            readers[i] = (concurrent_args){tree, i, 2, 2048, 0, &stop, true};
+            writers[i] = (concurrent_args){tree, i, 2, 2048, 30, &stop, true};
+            pthread_create(&readerThreads[i], NULL, concurrent_reader, &readers[i]);
+            pthread_create(&writerThreads[i], NULL, concurrent_churn, &writers[i]);
+        }
+        for (int i = 0; i < 2; i++) pthread_join(writerThreads[i], NULL);
+        atomic_store(&stop, 1);
+        for (int i = 0; i < 2; i++) {
+            pthread_join(readerThreads[i], NULL);
+            assert(readers[i].ok && "Reader missed a key that was never deleted");
+        }
+        assert(concurrentSize(tree) == 1024);
+        assert(concurrent_check(atomic_load(&tree->holder.right), &tree->holder, INT_MIN - 1LL, INT_MAX + 1LL) >= 0);
+        destroyConcurrentAvl(tree);
+        printf("✅ CONCURRENT TEST 3 PASSED: Optimistic readers under rotations\n");
+    }
+}
+
+// every shard is a valid avl tree holding only keys in its own range
+bool forest_check(sharded_forest *forest) {
+    for (int i = 0; i < forest->count; i++) {
+        binary_tree *root = forest->shards[i]->root;
+        if (!validate_avl_tree(root, "forest shard")) return false;
+        if (!root) continue;
+        binary_tree *min = root, *max = root;
+        while (min->left) min = min->left;
+        while (max->right) max = max->right;
+        if (min->data < forest->lo[i] || (i + 1 < forest->count && max->data >= forest->lo[i + 1])) return false;
+    }
+    return true;
+}
+
+typedef struct forest_args { sharded_forest *forest; int id, threads, range, ops; bool ok; } forest_args;
+
+// like concurrent_writer, but most keys fall in the bottom 1/16 of the range to keep one shard hot
+void *forest_writer(void *arg) {
+    forest_args *args = arg;
+    char *mine = calloc(args->range, 1);
+    unsigned long long state = 0x9e3779b97f4a7c15ULL * (args->id + 1);
+    for (int i = 0; i < args->ops; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        int span = (state >> 60) ? args->range / 16 : args->range;
+        int key = (int)(state % (span / args->threads)) * args->threads + args->id;
+        int op = (int)(state >> 40) % 3;
+        if (op == 0) {
+            forestInsert(args->forest, key);
+            mine[key] = 1;
+        } else if (op == 1) {
+            forestDelete(args->forest, key);
+            mine[key] = 0;
+        } else if (forestContains(args->forest, key) != mine[key]) {
+            args->ok = false;
+        }
+    }
+    for (int key = args->id; key < args->range; key += args->threads)
+        if (forestContains(args->forest, key) != mine[key]) args->ok = false;
+    free(mine);
+    return NULL;
+}
+
+void run_all_forest_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING SHARDED FOREST TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== FOREST TEST 1: routing, contents and ordered scans across shards =====
+    {
+        int sample[1000];
+        for (int i = 0; i < 1000; i++) sample[i] = i * 10;
+        sharded_forest *forest = createShardedForest(8, sample, 1000);
+        assert(forest->count == 8 && forest->lo[0] == INT_MIN);
+        for (int i = 1; i < forest->count; i++) assert(forest->lo[i] > forest->lo[i - 1]);
+
+        for (int i = 0; i < 10000; i++) forestInsert(forest, i * 7919 % 10000);
+        for (int key = 0; key < 10000; key += 3) forestDelete(forest, key);
+        for (int key = 0; key < 10000; key++) assert(forestContains(forest, key) == (key % 3 != 0));
+        assert(!forestContains(forest, -5) && !forestContains(forest, 20000));
+        assert(forestSize(forest) == 6666);
+        assert(forest_check(forest));
+
+        // the scan crosses several shard boundaries and still comes out sorted
+        scan_state state = {{0}, 0, 64};
+        assert(forestRangeScan(forest, 2490, 2585, collect_key, &state) == 64);
+        for (int i = 1; i < state.n; i++) assert(state.keys[i] > state.keys[i - 1]);
+        assert(state.keys[0] == 2491 && state.keys[63] == 2585);
+        state = (scan_state){{0}, 0, 5};
+        assert(forestRangeScan(forest, 0, 9999, collect_key, &state) == 5 && state.keys[4] == 7);
+        state = (scan_state){{0}, 0, 64};
+        assert(forestRangeScan(forest, 5000, 4000, collect_key, &state) == 0);
+
+        // without a sample the int range is cut evenly
+        sharded_forest *even = createShardedForest(4, NULL, 0);
+        assert(even->count == 4 && even->lo[2] == 0);
+        destroyShardedForest(even);
+        destroyShardedForest(forest);
+        printf("✅ FOREST TEST 1 PASSED: Sample split points, lookups and ordered range scans\n");
+    }
+
+    // ===== FOREST TEST 2: a hot range gets split off =====
+    {
+        int sample[1000];
+        for (int i = 0; i < 1000; i++) sample[i] = i * 1000;
+        sharded_forest *forest = createShardedForest(4, sample, 1000);
+        for (int key = 0; key < 1000000; key += 100) forestInsert(forest, key);
+        int before = forest->count;
+
+        // every operation lands below 5000, all inside the first shard
+        for (int i = 0; i < 200000; i++) {
+            int key = i * 7919 % 5000;
+            if (i < 5000) forestInsert(forest, key);
+            else forestContains(forest, key);
+        }
+        assert(forest->resplits > 0 && forest->count > before);
+        assert(forest->lo[1] > 0 && forest->lo[1] <= 5000 && "The hot range is spread over several shards");
+
+        for (int key = 0; key < 1000000; key += 100) assert(forestContains(forest, key));
+        for (int key = 0; key < 5000; key++) assert(forestContains(forest, key));
+        assert(forestSize(forest) == 10000 + 5000 - 50);
+        assert(forest_check(forest));
+
+        // a single hot key cannot be split any further
+        sharded_forest *single = createShardedForest(1, NULL, 0);
+        for (int i = 0; i < 100; i++) forestInsert(single, 42);
+        assert(forestResplit(single) && single->count == 2 && single->lo[1] == 42);
+        for (int i = 0; i < 100; i++) forestContains(single, 42);
+        assert(!forestResplit(single) && single->count == 2);
+        destroyShardedForest(single);
+        destroyShardedForest(forest);
+        printf("✅ FOREST TEST 2 PASSED: Hot shards are resplit online\n");
+    }
+
+    // ===== FOREST TEST 3: threads on a skewed workload while shards split =====
+    {
+        sharded_forest *forest = createShardedForest(2, NULL, 0);
+        forest_args args[4];
+        pthread_t threads[4];
+        for (int i = 0; i < 4; i++) {
+            args[i] = (forest_args){forest, i, 4, 1 << 16, 100000, true};
+            pthread_create(&threads[i], NULL, forest_writer, &args[i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+            assert(args[i].ok && "A writer saw a wrong answer for its own keys");
+        }
+        assert(forest->resplits > 0);
+        assert(forest_check(forest));
+        destroyShardedForest(forest);
+        printf("✅ FOREST TEST 3 PASSED: Concurrent writers across resplits\n");
+    }
+}
+
+// same keys and same shape, heights included
+bool same_tree(binary_tree *a, binary_tree *b) {
+    if (!a || !b) return a == b;
+    return a->data == b->data && a->height == b->height && same_tree(a->left, b->left) && same_tree(a->right, b->right);
+}
+
+void run_all_serialize_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING SERIALIZATION TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== SERIALIZE TEST 1: round trip, extreme keys and the empty tree =====
+    {
+        binary_tree *tree = NULL;
+        int extremes[] = {INT_MIN, INT_MIN + 1, -1, 0, 1, 127, 128, 16384, INT_MAX - 1, INT_MAX};
+        for (int i = 0; i < 10; i++) tree = insertAvlTree(tree, extremes[i]);
+        for (int i = 0; i < 5000; i++) tree = insertAvlTree(tree, i * 7919 % 1000003 - 500000);
+
+        FILE *file = tmpfile();
+        assert(saveAvlTree(tree, file));
+        rewind(file);
+        binary_tree *loaded = NULL;
+        assert(loadAvlTree(file, &loaded));
+        fclose(file);
+
+        avl_cursor a, b;
+        int n = 0;
+        for (cursorFirst(&a, tree), cursorFirst(&b, loaded); cursorValid(&a); cursorNext(&a), cursorNext(&b), n++)
+            assert(cursorValid(&b) && cursorKey(&a) == cursorKey(&b));
+        assert(!cursorValid(&b) && n == 5010);
+        assert(validate_avl_tree(loaded, "SERIALIZE TEST 1: Loaded tree"));
+
+        file = tmpfile();
+        assert(saveAvlTree(NULL, file));
+        assert(ftell(file) == 20 && "Header and trailer only");
+        rewind(file);
+        binary_tree *empty = tree;
+        assert(loadAvlTree(file, &empty) && empty == NULL);
+        fclose(file);
+
+        freeTree(tree);
+        freeTree(loaded);
+        printf("✅ SERIALIZE TEST 1 PASSED: Round trip of extreme keys and the empty tree\n");
+    }
+
+    // ===== SERIALIZE TEST 2: dense keys are a byte each and load into the built shape =====
+    {
+        int n = 100000;
+        int *keys = malloc(n * sizeof(int));
+        for (int i = 0; i < n; i++) keys[i] = 3 * i;
+        binary_tree *tree = buildAvlFromSorted(keys, n);
+        binary_tree *reference = buildAvlFromSorted(keys, n);
+        for (int i = n - 1; i >= 0; i -= 2) tree = insertAvlTree(deleteNodeAvlTree(tree, keys[i]), keys[i]);
+
+        FILE *file = tmpfile();
+        assert(saveAvlTree(tree, file));
+        assert(ftell(file) == 16 + 5 + (n - 1) + 4);
+        rewind(file);
+        node_pool *pool = createNodePool(0);
+        binary_tree *loaded = NULL;
+        assert(loadAvlTreePool(pool, file, &loaded));
+        fclose(file);
+        assert(same_tree(loaded, reference) && "Loading gives the buildAvlFromSorted shape");
+        assert(validate_avl_tree(loaded, "Loaded tree"));
+
+        destroyNodePool(pool);
+        freeTree(tree);
+        freeTree(reference);
+        free(keys);
+        printf("✅ SERIALIZE TEST 2 PASSED: Compact encoding and rotation-free reload\n");
+    }
+
+    // ===== SERIALIZE TEST 3: damaged files are rejected without leaking =====
+    {
+        binary_tree *tree = NULL;
+        for (int i = 0; i < 2000; i++) tree = insertAvlTree(tree, i * 5);
+        FILE *file = tmpfile();
+        assert(saveAvlTree(tree, file));
+        long size = ftell(file);
+        unsigned char *bytes = malloc(size);
+        rewind(file);
+        assert(fread(bytes, 1, size, file) == (size_t)size);
+        fclose(file);
+
+        // a flipped bit in the magic, the count, the payload and the checksum, then every truncation length
+        long flips[] = {0, 9, 16, size / 2, size - 5, size - 1};
+        for (int i = 0; i < 6; i++) {
+            file = tmpfile();
+            bytes[flips[i]] ^= 0x04;
+            fwrite(bytes, 1, size, file);
+            bytes[flips[i]] ^= 0x04;
+            rewind(file);
+            binary_tree *loaded = tree;
+            assert(!loadAvlTree(file, &loaded) && loaded == NULL);
+            fclose(file);
+        }
+        for (long cut = 0; cut < size; cut += 97) {
+            file = tmpfile();
+            fwrite(bytes, 1, cut, file);
+            rewind(file);
+            binary_tree *loaded = NULL;
+            assert(!loadAvlTree(file, &loaded) && loaded == NULL);
+            fclose(file);
+        }
+
+        binary_tree *loaded = NULL;
+        assert(!loadAvlTreeFile("/nonexistent/dir/tree.avl", &loaded));
+        free(bytes);
+        freeTree(tree);
+        printf("✅ SERIALIZE TEST 3 PASSED: Corrupt and truncated input is rejected\n");
+    }
+}
+
+typedef struct wal_args { wal_tree *wal; int id; bool ok; } wal_args;
+
+void *wal_writer(void *arg) {
+    wal_args *args = arg;
+    for (int i = 0; i < 300; i++) args->ok &= walInsert(args->wal, args->id * 1000 + i);
+    return NULL;
+}
+
+typedef struct wal_sync_args { wal_tree *wal; _Atomic bool done; bool overflow; } wal_sync_args;
+
+void *wal_bulk_writer(void *arg) {
+    wal_args *args = arg;
+    for (int i = 0; i < 20000; i++) args->ok &= walInsert(args->wal, args->id * 100000 + i);
+    return NULL;
+}
+
+void *wal_syncer(void *arg) {
+    wal_sync_args *args = arg;
+    while (!atomic_load(&args->done)) {
+        // a writer that appended without room leaves used past the end until the next flush
+        pthread_mutex_lock(&args->wal->lock);
+        args->overflow |= args->wal->used > WAL_BUFFER;
+        pthread_mutex_unlock(&args->wal->lock);
+        walSync(args->wal);
+    }
+    return NULL;
+}
+
+long file_size(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+void remove_wal_files(const char *base) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s.log", base);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s.ckpt", base);
+    unlink(path);
+}
+
+void run_all_wal_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING WRITE-AHEAD LOG TEST SUITE\n");
+    printf("========================================\n\n");
+
+    char dir[] = "/tmp/avl_wal_XXXXXX";
+    assert(mkdtemp(dir));
+    char base[64], log[256], checkpoint[256];
+    snprintf(base, sizeof(base), "%s/tree", dir);
+    snprintf(log, sizeof(log), "%s.log", base);
+    snprintf(checkpoint, sizeof(checkpoint), "%s.ckpt", base);
+
+    // ===== WAL TEST 1: replay, checkpoint and truncation =====
+    {
+        wal_tree *wal = walOpen(base, NULL);
+        assert(wal && wal->root == NULL && wal->replayed == 0);
+        for (int key = 0; key < 1000; key++) assert(walInsert(wal, key));
+        for (int key = 0; key < 1000; key += 2) assert(walDelete(wal, key));
+        assert(walClose(wal));
+        assert(file_size(log) == 8 + 1500 * 9);
+
+        wal = walOpen(base, NULL);
+        assert(wal && wal->replayed == 1500);
+        for (int key = 0; key < 1000; key++) assert(walContains(wal, key) == (key % 2 == 1));
+        assert(validate_avl_tree(wal->root, "Replayed tree"));
+
+        assert(walCheckpoint(wal) && file_size(log) == 8);
+        assert(walInsert(wal, 5000) && walDelete(wal, 1));
+        assert(walClose(wal));
+
+        wal = walOpen(base, NULL);
+        assert(wal && wal->replayed == 2);
+        assert(walContains(wal, 5000) && !walContains(wal, 1) && walContains(wal, 3));
+        assert(walClose(wal));
+        remove_wal_files(base);
+        printf("✅ WAL TEST 1 PASSED: Log replay on top of the last checkpoint\n");
+    }
+
+    // ===== WAL TEST 2: crashes =====
+    {
+        // the child dies without closing, every update a WAL_SYNC call returned from has to be there
+        wal_options sync = {WAL_SYNC, 0, 0, 0};
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            wal_tree *wal = walOpen(base, &sync);
+            for (int key = 0; key < 200; key++) walInsert(wal, key);
+            _exit(0);
+        }
+        int status;
+        waitpid(child, &status, 0);
+
+        // a torn record at the end, as from a crash in the middle of a write
+        FILE *file = fopen(log, "ab");
+        fwrite("\x01\x07\x00", 1, 3, file);
+        fclose(file);
+
+        wal_tree *wal = walOpen(base, &sync);
+        assert(wal && wal->replayed == 200);
+        for (int key = 0; key < 200; key++) assert(walContains(wal, key));
+        assert(file_size(log) == 8 + 200 * 9 && "The torn record is cut off");
+
+        // a crash between writing the checkpoint and emptying the log replays the log twice over
+        for (int key = 0; key < 100; key++) walDelete(wal, key);
+        long size = file_size(log);
+        char *saved = malloc(size);
+        file = fopen(log, "rb");
+        assert(fread(saved, 1, size, file) == (size_t)size);
+        fclose(file);
+        assert(walCheckpoint(wal) && walClose(wal));
+        file = fopen(log, "wb");
+        fwrite(saved, 1, size, file);
+        fclose(file);
+        free(saved);
+
+        wal = walOpen(base, &sync);
+        assert(wal && wal->replayed == 300);
+        for (int key = 0; key < 200; key++) assert(walContains(wal, key) == (key >= 100));
+        assert(walClose(wal));
+
+        // a log that is not a log is an error, not an empty tree
+        file = fopen(log, "wb");
+        fwrite("not a log file", 1, 14, file);
+        fclose(file);
+        assert(walOpen(base, &sync) == NULL);
+        remove_wal_files(base);
+        printf("✅ WAL TEST 2 PASSED: Recovery after crashes and torn writes\n");
+    }
+
+    // ===== WAL TEST 3: group commit across threads and automatic checkpoints =====
+    {
+        wal_options sync = {WAL_SYNC, 0, 0, 500};
+        wal_tree *wal = walOpen(base, &sync);
+        wal_args args[4];
+        pthread_t threads[4];
+        for (int i = 0; i < 4; i++) {
+            args[i] = (wal_args){wal, i, true};
+            pthread_create(&threads[i], NULL, wal_writer, &args[i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+            assert(args[i].ok);
+        }
+        assert(wal->checkpoints >= 2 && wal->syncs <= 1200);
+        assert(walClose(wal));
+
+        wal_options group = {WAL_GROUP, 64, 1000000, 0};
+        wal = walOpen(base, &group);
+        assert(wal && wal->replayed < 500);
+        for (int i = 0; i < 4; i++)
+            for (int key = i * 1000; key < i * 1000 + 300; key++) assert(walContains(wal, key));
+        for (int key = 10000; key < 10640; key++) walInsert(wal, key);
+        assert(wal->syncs == 10 && "One fsync per group of 64");
+        assert(walClose(wal));
+        remove_wal_files(base);
+        printf("✅ WAL TEST 3 PASSED: Group commit and automatic checkpoints\n");
+    }
+
+    // ===== WAL TEST 4: writers fill the buffer while a sync is writing it out =====
+    {
+        // the flushing thread drops the lock for its write and fsync, the writers that wait for it
+        // find the buffer refilled by the others and have to flush again before appending
+        wal_options none = {WAL_NONE, 0, 0, 0};
+        wal_tree *wal = walOpen(base, &none);
+        wal_args args[6];
+        pthread_t threads[6], syncer;
+        wal_sync_args sync = {wal, false, false};
+        pthread_create(&syncer, NULL, wal_syncer, &sync);
+        for (int i = 0; i < 6; i++) {
+            args[i] = (wal_args){wal, i, true};
+            pthread_create(&threads[i], NULL, wal_bulk_writer, &args[i]);
+        }
+        for (int i = 0; i < 6; i++) {
+            pthread_join(threads[i], NULL);
+            assert(args[i].ok);
+        }
+        atomic_store(&sync.done, true);
+        pthread_join(syncer, NULL);
+        assert(!sync.overflow && wal->used <= WAL_BUFFER);
+        assert(walClose(wal));
+
+        wal = walOpen(base, &none);
+        assert(wal && wal->replayed == 6 * 20000);
+        for (int i = 0; i < 6; i++)
+            for (int key = i * 100000; key < i * 100000 + 20000; key++) assert(walContains(wal, key));
+        assert(walClose(wal));
+        remove_wal_files(base);
+        rmdir(dir);
+        printf("✅ WAL TEST 4 PASSED: Buffer refilled during a sync\n");
+    }
+}
+
+static void *stats_worker(void *arg) {
+    int first = *(int *)arg;
+    binary_tree *tree = NULL;
+    for (int key = first; key < first + 1000; key++) tree = insertAvlTree(tree, key);
+    for (int key = first; key < first + 1000; key++) assert(searchAvlTree(tree, key));
+    freeTree(tree);
+    return NULL;
+}
+
+void run_all_stats_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING OPERATION STATISTICS TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== STATS TEST 1: exact counts for a tiny tree =====
+    {
+        avl_stats stats;
+        avlStatsReset();
+        binary_tree *tree = NULL;
+        tree = insertAvlTree(tree, 1);
+        tree = insertAvlTree(tree, 2);
+        tree = insertAvlTree(tree, 3);
+        assert(searchAvlTree(tree, 1) == tree->left && !searchAvlTree(tree, 4));
+        avlStatsRead(&stats);
+#if AVL_STATS
+        assert(stats.inserts == 3 && stats.searches == 2 && stats.allocs == 3);
+        assert(stats.rrRotations == 1 && stats.llRotations + stats.lrRotations + stats.rlRotations == 0);
+        // insert 3 walks 1 -> 2, the search for 1 finds it under the root, 4 falls off below 3
+        assert(stats.pathLength == 0 + 1 + 2 + 2 + 2);
+        assert(stats.comparisons == 0 + 2 + 4 + 3 + 4);
+        assert(stats.depthHistogram[0] == 1 && stats.depthHistogram[1] == 1 && stats.depthHistogram[2] == 3);
+        assert(stats.retraceSteps == 0 + 1 + 2);
+#else
+        for (size_t i = 0; i < sizeof(stats) / sizeof(uint64_t); i++) assert(((uint64_t *)&stats)[i] == 0);
+#endif
+        tree = deleteNodeAvlTree(tree, 2);
+        tree = deleteNodeAvlTree(tree, 7);
+        freeTree(tree);
+        avlStatsRead(&stats);
+#if AVL_STATS
+        assert(stats.deletes == 2 && stats.frees == 3);
+#else
+        assert(stats.deletes == 0 && stats.frees == 0);
+#endif
+        printf("✅ STATS TEST 1 PASSED: Comparisons, paths, rotations and allocations counted exactly\n");
+    }
+
+    // ===== STATS TEST 2: threads that already exited still count =====
+    {
+        pthread_t threads[4];
+        int firsts[4] = {0, 1000, 2000, 3000};
+        avlStatsReset();
+        for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, stats_worker, &firsts[i]);
+        for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+        avl_stats stats;
+        avlStatsRead(&stats);
+#if AVL_STATS
+        assert(stats.inserts == 4000 && stats.searches == 4000);
+        assert(stats.allocs == 4000 && stats.frees == 4000);
+        // sequential inserts rotate once on every insert but the first two into a subtree
+        assert(stats.rrRotations > 3900 && stats.llRotations == 0);
+#else
+        assert(stats.inserts == 0 && stats.allocs == 0);
+#endif
+        avlStatsReset();
+        avlStatsRead(&stats);
+        assert(stats.inserts == 0 && stats.rrRotations == 0);
+        printf("✅ STATS TEST 2 PASSED: Per-thread counters aggregated across live and exited threads\n");
+    }
+
+    // ===== STATS TEST 3: the histogram agrees with the path totals =====
+    {
+        binary_tree *tree = NULL;
+        avlStatsReset();
+        for (int i = 0; i < 20000; i++) tree = insertAvlTree(tree, i * 7919 % 20000);
+        for (int key = -10; key < 20010; key++) searchAvlTree(tree, key);
+        for (int key = 0; key < 20000; key += 2) tree = deleteNodeAvlTree(tree, key);
+
+        avl_stats stats;
+        avlStatsRead(&stats);
+        uint64_t ops = 0, nodes = 0;
+        for (int d = 0; d < AVL_MAX_HEIGHT; d++) {
+            ops += stats.depthHistogram[d];
+            nodes += (uint64_t)d * stats.depthHistogram[d];
+        }
+        assert(ops == stats.searches + stats.inserts + stats.deletes);
+        assert(nodes == stats.pathLength);
+#if AVL_STATS
+        assert(ops == 20000 + 20020 + 10000);
+        // a 20000 node avl tree is at most 1.44 * log2 deep, well under 21 levels
+        for (int d = 21; d < AVL_MAX_HEIGHT; d++) assert(stats.depthHistogram[d] == 0);
+        assert(stats.allocs - stats.frees == 10000);
+#endif
+        freeTree(tree);
+        printf("✅ STATS TEST 3 PASSED: Depth histogram matches operation and path totals\n");
+    }
+}
+
+// walks a compact tree checking order and that every stored balance factor matches the real heights,
+// returns the node count and the height through *height (-1 for an empty subtree)
+static size_t compact_check(const compact_tree *tree, uint32_t i, long long lo, long long hi, int *height) {
+    if (!i) {
+        *height = -1;
+        return 0;
+    }
+    const compact_node *node = &tree->nodes[i];
+    assert(node->key > lo && node->key < hi);
+
+    int lh, rh;
+    size_t count = compact_check(tree, node->left, lo, node->key, &lh);
+    count += compact_check(tree, node->right, node->key, hi, &rh);
+    assert(lh - rh >= -1 && lh - rh <= 1);
+    unsigned expected = lh == rh ? COMPACT_BALANCED : lh > rh ? COMPACT_LEFT_HEAVY : COMPACT_RIGHT_HEAVY;
+    assert(compactBalance(tree, i) == expected);
+
+    *height = (lh > rh ? lh : rh) + 1;
+    return count + 1;
+}
+
+static int compact_height(const compact_tree *tree) {
+    int height;
+    assert(compact_check(tree, tree->root, (long long)INT_MIN - 1, (long long)INT_MAX + 1, &height) == compactSize(tree));
+    return height;
+}
+
+void run_all_compact_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING COMPACT NODE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== COMPACT TEST 1: every rotation case keeps the balance factors exact =====
+    {
+        assert(sizeof(compact_node) == 12);
+        compact_tree *tree = createCompactTree(4);
+
+        // ll, rr, lr and rl on three keys each, then growth past the initial capacity
+        int cases[4][3] = {{3, 2, 1}, {1, 2, 3}, {3, 1, 2}, {1, 3, 2}};
+        for (int c = 0; c < 4; c++) {
+            for (int k = 0; k < 3; k++) assert(compactInsert(tree, cases[c][k] + c * 10));
+            compact_height(tree);
+        }
+        assert(!compactInsert(tree, 12) && compactSize(tree) == 12);
+        for (int c = 0; c < 4; c++)
+            for (int k = 1; k <= 3; k++) assert(compactContains(tree, c * 10 + k));
+        assert(!compactContains(tree, 0) && !compactContains(tree, 40));
+
+        assert(compactInsert(tree, INT_MIN) && compactInsert(tree, INT_MAX) && compactInsert(tree, -7));
+        assert(compactContains(tree, INT_MIN) && compactContains(tree, INT_MAX));
+        assert(compact_height(tree) <= 4);
+
+        assert(!compactDelete(tree, 100));
+        assert(compactDelete(tree, 22) && compactDelete(tree, INT_MIN) && compactDelete(tree, 1));
+        assert(!compactContains(tree, 22) && compactSize(tree) == 12);
+        compact_height(tree);
+        destroyCompactTree(tree);
+        printf("✅ COMPACT TEST 1 PASSED: 12 byte nodes, all four rotations with exact balance factors\n");
+    }
+
+    // ===== COMPACT TEST 2: random inserts and deletes against a reference =====
+    {
+        compact_tree *tree = createCompactTree(0);
+        static bool present[20000];
+        size_t expected = 0;
+        uint64_t rng = 12345;
+
+        for (int step = 0; step < 200000; step++) {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            int key = (int)((rng >> 33) % 20000);
+            if ((rng >> 20) & 1) {
+                assert(compactInsert(tree, key) == !present[key]);
+                expected += !present[key];
+                present[key] = true;
+            } else {
+                assert(compactDelete(tree, key) == present[key]);
+                expected -= present[key];
+                present[key] = false;
+            }
+            if (step % 20000 == 0) compact_height(tree);
+        }
+        assert(compactSize(tree) == expected);
+        for (int key = 0; key < 20000; key++) assert(compactContains(tree, key) == present[key]);
+        compact_height(tree);
+
+        // deleted nodes are recycled, so refilling does not grow the array
+        size_t bytes = compactBytes(tree);
+        for (int key = 0; key < 20000; key++) if (present[key]) compactDelete(tree, key);
+        assert(compactSize(tree) == 0 && tree->root == COMPACT_NIL);
+        for (int key = 0; key < (int)expected; key++) assert(compactInsert(tree, key));
+        assert(compactBytes(tree) == bytes);
+        destroyCompactTree(tree);
+        printf("✅ COMPACT TEST 2 PASSED: Random updates match a reference and reuse freed nodes\n");
+    }
+
+    // ===== COMPACT TEST 3: heights stay within the avl bound =====
+    {
+        compact_tree *tree = createCompactTree(0);
+        for (int key = 0; key < 100000; key++) compactInsert(tree, key);
+        // 100000 sequential keys give a nearly perfect tree, log2 is about 16.6
+        assert(compact_height(tree) <= 17);
+        for (int key = 0; key < 100000; key += 3) compactDelete(tree, key);
+        assert(compactSize(tree) == 66666);
+        assert(compact_height(tree) <= 24);
+        assert(compactBytes(tree) < 100000 * 2 * sizeof(compact_node));
+        destroyCompactTree(tree);
+        printf("✅ COMPACT TEST 3 PASSED: Sequential and strided updates stay balanced\n");
+    }
+}
+
+// checks a bucket tree: sorted padded blocks, every block between its subtrees, avl heights.
+// returns the key count and the height through *height
+static size_t bucket_check(const bucket_node *node, long long lo, long long hi, int *height) {
+    if (!node) {
+        *height = -1;
+        return 0;
+    }
+    assert(node->count >= 1 && node->count <= BUCKET_KEYS);
+    assert(node->keys[0] > lo && node->keys[node->count - 1] < hi);
+    for (int i = 1; i < node->count; i++) assert(node->keys[i] > node->keys[i - 1]);
+    for (int i = node->count; i < BUCKET_KEYS; i++) assert(node->keys[i] == INT_MAX);
+
+    int lh, rh;
+    size_t count = bucket_check(node->left, lo, node->keys[0], &lh);
+    count += bucket_check(node->right, node->keys[node->count - 1], hi, &rh);
+    assert(lh - rh >= -1 && lh - rh <= 1);
+    *height = (lh > rh ? lh : rh) + 1;
+    assert(node->height == *height);
+    return count + node->count;
+}
+
+static int bucket_height(const bucket_node *root, size_t expected) {
+    int height;
+    assert(bucket_check(root, (long long)INT_MIN - 1, (long long)INT_MAX + 1, &height) == expected);
+    assert(bucketTreeSize(root) == expected);
+    return height;
+}
+
+void run_all_bucket_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING BUCKET TREE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== BUCKET TEST 1: full buckets push keys down, deletes refill and merge =====
+    {
+        bucket_node *root = NULL;
+        for (int key = 0; key < 1000; key++) root = insertBucketTree(root, key * 2);
+        bucket_height(root, 1000);
+        // odd keys land in full buckets and push their smallest keys down to the left
+        for (int key = 1; key < 2000; key += 2) root = insertBucketTree(root, key);
+        root = insertBucketTree(root, 500);
+        bucket_height(root, 2000);
+        for (int key = -1; key <= 2000; key++) assert(bucketContains(root, key) == (key >= 0 && key < 2000));
+
+        root = insertBucketTree(root, INT_MAX);
+        root = insertBucketTree(root, INT_MIN);
+        assert(bucketContains(root, INT_MAX) && bucketContains(root, INT_MIN) && !bucketContains(root, INT_MAX - 1));
+        bucket_height(root, 2002);
+
+        for (int key = 0; key < 2000; key += 3) root = deleteBucketTree(root, key);
+        root = deleteBucketTree(root, 3);
+        root = deleteBucketTree(root, 5000);
+        bucket_height(root, 2002 - 667);
+        for (int key = 0; key < 2000; key++) assert(bucketContains(root, key) == (key % 3 != 0));
+
+        for (int key = 0; key < 2000; key++) root = deleteBucketTree(root, key);
+        root = deleteBucketTree(root, INT_MAX);
+        root = deleteBucketTree(root, INT_MIN);
+        assert(root == NULL);
+        printf("✅ BUCKET TEST 1 PASSED: Overflow push-down, internal refill and leaf merging\n");
+    }
+
+    // ===== BUCKET TEST 2: random updates against a reference =====
+    {
+        bucket_node *root = NULL;
+        static bool present[50000];
+        size_t expected = 0;
+        uint64_t rng = 777;
+
+        for (int step = 0; step < 300000; step++) {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            int key = (int)((rng >> 33) % 50000);
+            if ((rng >> 20) % 3) {
+                expected += !present[key];
+                present[key] = true;
+                root = insertBucketTree(root, key);
+            } else {
+                expected -= present[key];
+                present[key] = false;
+                root = deleteBucketTree(root, key);
+            }
+            if (step % 30000 == 0) bucket_height(root, expected);
+        }
+        bucket_height(root, expected);
+        for (int key = 0; key < 50000; key++) assert(bucketContains(root, key) == present[key]);
+        freeBucketTree(root);
+        printf("✅ BUCKET TEST 2 PASSED: Random inserts and deletes match a reference\n");
+    }
+
+    // ===== BUCKET TEST 3: the tree is several levels shorter than a one key per node tree =====
+    {
+        bucket_node *buckets = NULL;
+        binary_tree *tree = NULL;
+        for (int i = 0; i < 100000; i++) {
+            int key = i * 7919 % 100000;
+            buckets = insertBucketTree(buckets, key);
+            tree = insertAvlTree(tree, key);
+        }
+        int height = bucket_height(buckets, 100000);
+        int avlHeight = tree->height;
+        assert(height + 3 <= avlHeight);
+        freeBucketTree(buckets);
+        freeTree(tree);
+        printf("✅ BUCKET TEST 3 PASSED: Bucket tree height %d against %d for one key per node\n", height, avlHeight);
+    }
+}
+
+// the finger must be a real root to node path ending on key, with bounds that hold for every node on it
+void finger_check(binary_tree *root, avl_finger *finger, int key) {
+    assert(finger->depth > 0 && finger->path[0] == root);
+    for (int i = 0; i < finger->depth; i++) {
+        binary_tree *node = finger->path[i];
+        assert(finger->lo[i] < node->data && node->data < finger->hi[i]);
+        if (i) assert(finger->path[i - 1]->left == node || finger->path[i - 1]->right == node);
+    }
+    assert(finger->path[finger->depth - 1]->data == key);
+}
+
+int count_tree_nodes(binary_tree *root) {
+    return root ? 1 + count_tree_nodes(root->left) + count_tree_nodes(root->right) : 0;
+}
+
+void run_all_finger_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING FINGER INSERT TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== FINGER TEST 1: ascending, descending and jittered streams =====
+    {
+        for (int pattern = 0; pattern < 3; pattern++) {
+            binary_tree *root = NULL;
+            avl_finger finger;
+            fingerReset(&finger);
+            uint64_t rng = 99;
+
+            for (int i = 0; i < 5000; i++) {
+                int key = pattern == 0 ? i : pattern == 1 ? 5000 - i : i * 4;
+                if (pattern == 2) {
+                    rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+                    key += (int)(rng >> 33) % 40;
+                }
+                root = insertAvlTreeHinted(root, &finger, key);
+                finger_check(root, &finger, key);
+            }
+            assert(validate_avl_tree(root, "FINGER TEST 1: Streams"));
+
+            // the same keys through the plain insert give the same key set
+            binary_tree *plain = NULL;
+            rng = 99;
+            for (int i = 0; i < 5000; i++) {
+                int key = pattern == 0 ? i : pattern == 1 ? 5000 - i : i * 4;
+                if (pattern == 2) {
+                    rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+                    key += (int)(rng >> 33) % 40;
+                }
+                plain = insertAvlTree(plain, key);
+            }
+            assert(count_tree_nodes(root) == count_tree_nodes(plain));
+            for (int key = -1; key < 20050; key++) assert(search(root, key) == search(plain, key));
+            freeTree(plain);
+            freeTree(root);
+        }
+        printf("✅ FINGER TEST 1 PASSED: Ascending, descending and jittered streams\n");
+    }
+
+    // ===== FINGER TEST 2: far jumps, duplicates and a stale finger =====
+    {
+        binary_tree *root = NULL;
+        avl_finger finger;
+        fingerReset(&finger);
+
+        for (int i = 0; i < 1000; i++) {
+            // alternate between both ends so the finger has to climb to the root and back
+            int key = i % 2 ? 100000 - i : i;
+            root = insertAvlTreeHinted(root, &finger, key);
+            finger_check(root, &finger, key);
+        }
+        root = insertAvlTreeHinted(root, &finger, 500);
+        finger_check(root, &finger, 500);
+        root = insertAvlTreeHinted(root, &finger, 99999);
+        finger_check(root, &finger, 99999);
+        assert(count_tree_nodes(root) == 1000);
+
+        // a delete can rotate the root away, the finger notices and starts over
+        for (int key = 0; key < 1000; key += 2) root = deleteNodeAvlTree(root, key);
+        root = insertAvlTreeHinted(root, &finger, 50000);
+        finger_check(root, &finger, 50000);
+        assert(validate_avl_tree(root, "FINGER TEST 2: Jumps") && count_tree_nodes(root) == 501);
+
+        // and a reset finger always does
+        fingerReset(&finger);
+        root = insertAvlTreeHinted(root, &finger, 1);
+        finger_check(root, &finger, 1);
+        assert(validate_avl_tree(root, "FINGER TEST 2: Reset") && count_tree_nodes(root) == 502);
+        freeTree(root);
+        printf("✅ FINGER TEST 2 PASSED: Far jumps, duplicates and stale fingers\n");
+    }
+
+    // ===== FINGER TEST 3: append fast path, pooled =====
+    {
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        avl_finger finger;
+        fingerReset(&finger);
+
+        for (int key = 0; key < 10000; key++) {
+            root = appendAvlTreePool(pool, root, &finger, key);
+            finger_check(root, &finger, key);
+        }
+        assert(validate_avl_tree(root, "FINGER TEST 3: Append"));
+        assert(root->height <= 14);
+
+        // keys that are not above the maximum fall back to the hinted insert
+        root = appendAvlTreePool(pool, root, &finger, 5000);
+        root = appendAvlTreePool(pool, root, &finger, -5);
+        finger_check(root, &finger, -5);
+        root = appendAvlTreePool(pool, root, &finger, 20000);
+        finger_check(root, &finger, 20000);
+        assert(count_tree_nodes(root) == 10002 && search(root, -5) && search(root, 20000));
+        assert(validate_avl_tree(root, "FINGER TEST 3: Fallback inserts"));
+
+        // an insert elsewhere moves the finger, append finds the maximum again
+        root = insertAvlTreeHintedPool(pool, root, &finger, 7777);
+        root = appendAvlTreePool(pool, root, &finger, 20001);
+        finger_check(root, &finger, 20001);
+        assert(count_tree_nodes(root) == 10003);
+        destroyNodePool(pool);
+        printf("✅ FINGER TEST 3 PASSED: Append fast path and fallback\n");
+    }
+}
+
+typedef struct level_trace {
+    int keys[64];
+    int levels[64];
+    int count;
+} level_trace;
+
+void trace_level(binary_tree *node, int level, void *ctx) {
+    level_trace *trace = ctx;
+    trace->keys[trace->count] = node->data;
+    trace->levels[trace->count++] = level;
+}
+
+bool keep_multiple_of_7(int key, void *ctx) {
+    return key % 7 == 0;
+}
+
+int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// a custom reduction: the number of leaves
+void leaf_visit(binary_tree *node, void *acc, void *ctx) {
+    if (!node->left && !node->right) (*(long *)acc)++;
+}
+
+void leaf_merge(void *acc, const void *part, void *ctx) {
+    *(long *)acc += *(const long *)part;
+}
+
+void run_all_traverse_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING TRAVERSAL TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== TRAVERSE TEST 1: ring buffer breadth first walks =====
+    {
+        binary_tree *root = NULL;
+        for (int key = 1; key <= 15; key++) root = insertAvlTree(root, key);
+
+        // a perfect tree of 15 keys, level by level and left to right
+        level_trace trace = {{0}, {0}, 0};
+        assert(levelOrderVisit(root, trace_level, &trace) && trace.count == 15);
+        int expected[15] = {8, 4, 12, 2, 6, 10, 14, 1, 3, 5, 7, 9, 11, 13, 15};
+        for (int i = 0; i < 15; i++) {
+            assert(trace.keys[i] == expected[i]);
+            assert(trace.levels[i] == (i < 1 ? 0 : i < 3 ? 1 : i < 7 ? 2 : 3));
+        }
+        trace.count = 0;
+        assert(levelOrderVisit(NULL, trace_level, &trace) && trace.count == 0);
+
+        // levelOrder used to queue the NULL children and read through them
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            dup2(open("/dev/null", O_WRONLY), STDOUT_FILENO);
+            levelOrder(root);
+            levelOrder(NULL);
+            _exit(0);
+        }
+        int status;
+        waitpid(child, &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        // a wide level moves the ring from its inline slots to the heap
+        queue q;
+        queueInit(&q);
+        for (int i = 0; i < 1000; i++) {
+            assert(enQueue(&q, (binary_tree *)(size_t)(i + 1)));
+            if (i % 3 == 0) assert(deQueue(&q) == (binary_tree *)(size_t)(i / 3 + 1));
+        }
+        assert(q.count == 666 && q.capacity == 1024);
+        for (int i = 335; i <= 1000; i++) assert(deQueue(&q) == (binary_tree *)(size_t)i);
+        assert(queueEmpty(&q) && deQueue(&q) == NULL);
+        queueFree(&q);
+
+        freeTree(root);
+        printf("✅ TRAVERSE TEST 1 PASSED: Level order over a ring buffer\n");
+    }
+
+    // ===== TRAVERSE TEST 2: parallel reductions against a sequential walk =====
+    {
+        binary_tree *root = NULL;
+        uint64_t rng = 4242;
+        for (int i = 0; i < 200000; i++) {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            root = insertAvlTree(root, (int)(rng >> 35));
+        }
+        int size = count_tree_nodes(root);
+        long long sum = 0;
+        int *all = NULL;
+        size_t got = parallelCollectAvlTree(root, 1, NULL, NULL, &all);
+        assert(got == (size_t)size);
+        for (int i = 0; i < size; i++) sum += all[i];
+
+        for (int threads = 0; threads <= 8; threads += 4) {
+            assert(parallelCountAvlTree(root, threads, NULL, NULL) == (size_t)size);
+            assert(parallelSumAvlTree(root, threads) == sum);
+
+            size_t sevens = 0;
+            for (int i = 0; i < size; i++) sevens += all[i] % 7 == 0;
+            assert(parallelCountAvlTree(root, threads, keep_multiple_of_7, NULL) == sevens);
+
+            int *kept = NULL;
+            assert(parallelCollectAvlTree(root, threads, keep_multiple_of_7, NULL, &kept) == sevens);
+            qsort(kept, sevens, sizeof(int), compare_ints);
+            for (size_t i = 1; i < sevens; i++) assert(kept[i - 1] < kept[i] && kept[i] % 7 == 0);
+            free(kept);
+
+            long leaves = 0, expectedLeaves = 0;
+            parallelVisitAvlTree(root, 1, leaf_visit, leaf_merge, &expectedLeaves, sizeof(long), NULL);
+            parallelVisitAvlTree(root, threads, leaf_visit, leaf_merge, &leaves, sizeof(long), NULL);
+            assert(leaves == expectedLeaves && leaves > size / 4);
+        }
+
+        int *none = all;
+        assert(parallelCollectAvlTree(NULL, 4, NULL, NULL, &none) == 0 && none == NULL);
+        assert(parallelSumAvlTree(NULL, 4) == 0);
+        free(all);
+        freeTree(root);
+        printf("✅ TRAVERSE TEST 2 PASSED: Parallel count, sum, collect and custom reductions\n");
+    }
+
+    // ===== TRAVERSE TEST 3: parallel teardown =====
+    {
+        // run under valgrind or asan to see every node go
+        for (int threads = 1; threads <= 8; threads *= 2) {
+            binary_tree *root = NULL;
+            for (int key = 0; key < 100000; key++) root = insertAvlTree(root, key);
+            parallelFreeTree(root, threads);
+        }
+        parallelFreeTree(NULL, 4);
+
+        binary_tree *small = insertAvlTree(insertAvlTree(NULL, 1), 2);
+        parallelFreeTree(small, 4);
+        printf("✅ TRAVERSE TEST 3 PASSED: Parallel teardown\n");
+    }
+}
+
+void run_all_validate_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING VALIDATOR TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== VALIDATE TEST 1: valid trees over the whole int range =====
+    {
+        avl_check report;
+        assert(checkAvlTree(NULL, &report) == AVL_OK && report.nodes == 0 && report.height == -1);
+
+        binary_tree *root = NULL;
+        int keys[] = {INT_MIN, -1, 0, 1, INT_MAX, -1000, 1000, INT_MIN + 1, INT_MAX - 1};
+        for (int i = 0; i < 9; i++) root = insertAvlTree(root, keys[i]);
+        assert(checkAvlTree(root, &report) == AVL_OK && report.nodes == 9 && report.height == root->height);
+
+        for (int key = -5000; key < 5000; key += 3) root = insertAvlTree(root, key);
+        assert(checkAvlTree(root, &report) == AVL_OK && report.nodes == (size_t)count_tree_nodes(root));
+        for (int key = -5000; key < 5000; key += 7) {
+            root = deleteNodeAvlTree(root, key);
+            assert(checkAvlPath(root, key, &report) == AVL_OK);
+        }
+        assert(checkAvlTree(root, &report) == AVL_OK);
+        freeTree(root);
+        printf("✅ VALIDATE TEST 1 PASSED: Single pass check over the whole int range\n");
+    }
+
+    // ===== VALIDATE TEST 2: every kind of corruption is caught and located =====
+    {
+        binary_tree *root = NULL;
+        for (int key = 0; key < 127; key++) root = insertAvlTree(root, key);
+        avl_check report;
+
+        // a key out of place deep down, where each parent child pair still looks right
+        binary_tree *node = root->left;
+        while (node->right) node = node->right;
+        int saved = node->data;
+        node->data = root->data + 1;
+        assert(checkAvlTree(root, &report) == AVL_ORDER && report.node == node);
+        assert(checkAvlPath(root, saved, &report) == AVL_ORDER && report.node == node);
+        node->data = saved;
+
+        node = root->right->left;
+        node->height++;
+        assert(checkAvlTree(root, &report) == AVL_HEIGHT && report.node == node);
+        // on the path the parent is checked first and already disagrees with it
+        assert(checkAvlPath(root, node->data, &report) == AVL_HEIGHT && report.node == root->right);
+        node->height--;
+
+        // a whole subtree cut off leaves its parent out of balance
+        binary_tree *cut = root->right->right;
+        root->right->right = NULL;
+        root->right->height = cut->height + 1;
+        assert(checkAvlTree(root, &report) == AVL_BALANCE && report.node == root->right);
+        root->right->right = cut;
+        root->right->height = cut->height + 1;
+
+#if AVL_AUGMENT
+        node = root->left->left->left;
+        node->size++;
+        assert(checkAvlTree(root, &report) == AVL_AUGMENT_BAD && report.node == node);
+        assert(checkAvlPath(root, node->data, &report) == AVL_AUGMENT_BAD);
+        // off the path of an unrelated key it stays unseen, that check is O(log n)
+        assert(checkAvlPath(root, 126, &report) == AVL_OK);
+        node->size--;
+#endif
+
+        // a cycle never reaches a leaf
+        node = root;
+        while (node->left) node = node->left;
+        node->left = root;
+        assert(checkAvlTree(root, &report) != AVL_OK);
+        node->left = NULL;
+
+        assert(checkAvlTree(root, &report) == AVL_OK);
+        assert(strcmp(avlViolationName(AVL_BALANCE), "balance factor") == 0);
+        freeTree(root);
+        printf("✅ VALIDATE TEST 2 PASSED: Order, height, balance, augmentation and cycles detected\n");
+    }
+
+    // ===== VALIDATE TEST 3: path checks keep up with random updates =====
+    {
+        binary_tree *root = NULL;
+        avl_check report;
+        uint64_t rng = 31337;
+        for (int i = 0; i < 100000; i++) {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            int key = (int)(rng >> 52) - 2048;
+            if ((rng >> 20) % 3) root = insertAvlTree(root, key);
+            else root = deleteNodeAvlTree(root, key);
+            assert(checkAvlPath(root, key, &report) == AVL_OK);
+            if (i % 5000 == 0) assert(checkAvlTree(root, &report) == AVL_OK);
+        }
+        assert(validate_avl_tree(root, "VALIDATE TEST 3: Random updates"));
+        freeTree(root);
+        printf("✅ VALIDATE TEST 3 PASSED: Path checks after random updates\n");
+    }
+}
+
+void run_all_image_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING MAPPED IMAGE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    char dir[] = "/tmp/avl_image_XXXXXX";
+    assert(mkdtemp(dir));
+    char path[256], bad[256];
+    snprintf(path, sizeof(path), "%s/tree.img", dir);
+    snprintf(bad, sizeof(bad), "%s/bad.img", dir);
+
+    binary_tree *tree = NULL;
+    int extremes[] = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+    for (int i = 0; i < 7; i++) tree = insertAvlTree(tree, extremes[i]);
+    for (int i = 0; i < 20000; i++) tree = insertAvlTree(tree, i * 7919 % 1000003 - 500000);
+    int n = count_tree_nodes(tree);
+
+    // ===== IMAGE TEST 1: lookups, floor and range scans in place =====
+    {
+        assert(saveAvlImageFile(tree, path));
+        avl_image *image = openAvlImage(path);
+        assert(image && image->count == (uint32_t)n && image->height == (uint32_t)tree->height);
+        assert(verifyAvlImage(image));
+
+        for (int i = 0; i < 7; i++) assert(imageContains(image, extremes[i]));
+        for (int i = -600000; i < 600000; i += 37) {
+            assert(imageContains(image, i) == search(tree, i));
+            int a = 0, b = 0;
+            bool fa = imageFloor(image, i, &a), fb = floorAvlTree(tree, i, &b);
+            assert(fa == fb && (!fa || a == b));
+        }
+
+        scan_state in_image = {{0}, 0, 64}, in_tree = {{0}, 0, 64};
+        assert(imageRangeScan(image, -1000, 100000, collect_key, &in_image) == 64);
+        rangeScanAvlTree(tree, -1000, 100000, collect_key, &in_tree);
+        assert(memcmp(in_image.keys, in_tree.keys, sizeof(in_image.keys)) == 0);
+        in_image.n = 0;
+        in_image.limit = 64;
+        assert(imageRangeScan(image, INT_MAX - 1, INT_MAX, collect_key, &in_image) == 2);
+        assert(in_image.keys[0] == INT_MAX - 1 && in_image.keys[1] == INT_MAX);
+        in_image.n = 0;
+        assert(imageRangeScan(image, INT_MIN, INT_MIN, collect_key, &in_image) == 1 && in_image.keys[0] == INT_MIN);
+        assert(imageRangeScan(image, 5, 4, collect_key, &in_image) == 0);
+        closeAvlImage(image);
+
+        // the empty tree is a header and a trailer
+        assert(saveAvlImageFile(NULL, bad));
+        image = openAvlImage(bad);
+        assert(image && image->count == 0 && verifyAvlImage(image));
+        assert(!imageContains(image, 0) && imageRangeScan(image, INT_MIN, INT_MAX, collect_key, &in_image) == 0);
+        closeAvlImage(image);
+        printf("✅ IMAGE TEST 1 PASSED: Search, floor and range scan in place\n");
+    }
+
+    // ===== IMAGE TEST 2: damaged files =====
+    {
+        FILE *file = fopen(path, "rb");
+        fseek(file, 0, SEEK_END);
+        long length = ftell(file);
+        rewind(file);
+        unsigned char *bytes = malloc(length);
+        assert(fread(bytes, 1, length, file) == (size_t)length);
+        fclose(file);
+
+        // a truncated file and a wrong magic are refused at open
+        file = fopen(bad, "wb");
+        fwrite(bytes, 1, length - 1, file);
+        fclose(file);
+        assert(openAvlImage(bad) == NULL);
+        bytes[0] = 'X';
+        file = fopen(bad, "wb");
+        fwrite(bytes, 1, length, file);
+        fclose(file);
+        assert(openAvlImage(bad) == NULL);
+        bytes[0] = 'A';
+        assert(openAvlImage("/nonexistent/tree.img") == NULL);
+
+        // links that point back up or out of the file open (the nodes are not read then) but fail
+        // verification, and lookups through them still end inside the mapping
+        image_node *nodes = (image_node *)(bytes + 64);
+        nodes[n - 1].left = n - 1;
+        nodes[n - 2].right = 0xfffffff0u;
+        file = fopen(bad, "wb");
+        fwrite(bytes, 1, length, file);
+        fclose(file);
+        avl_image *image = openAvlImage(bad);
+        assert(image && !verifyAvlImage(image));
+        int floor_key;
+        imageContains(image, INT_MIN);
+        imageFloor(image, INT_MAX, &floor_key);
+        scan_state all = {{0}, 0, 64};
+        imageRangeScan(image, INT_MIN, INT_MAX, collect_key, &all);
+        closeAvlImage(image);
+        free(bytes);
+        printf("✅ IMAGE TEST 2 PASSED: Truncated, foreign and corrupt images\n");
+    }
+
+    // ===== IMAGE TEST 3: other processes read the same file =====
+    {
+        fflush(stdout);
+        pid_t children[3];
+        for (int c = 0; c < 3; c++) {
+            children[c] = fork();
+            if (children[c] == 0) {
+                avl_image *image = openAvlImage(path);
+                int found = 0;
+                for (int i = 0; i < 20000; i++) found += imageContains(image, i * 7919 % 1000003 - 500000);
+                _exit(image && found == 20000 ? 0 : 1);
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            int status;
+            waitpid(children[c], &status, 0);
+            assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        printf("✅ IMAGE TEST 3 PASSED: Images shared between processes\n");
+    }
+
+    freeTree(tree);
+    unlink(path);
+    unlink(bad);
+    rmdir(dir);
+}
+
+// real height, the height field holds a rank under the wavl and red-black policies
+static int real_tree_height(binary_tree *node) {
+    if (!node) return -1;
+    int hl = real_tree_height(node->left);
+    int hr = real_tree_height(node->right);
+    return (hl > hr ? hl : hr) + 1;
+}
+
+void run_all_policy_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING BALANCING POLICY TEST SUITE (%s)\n", avlBalancePolicyName());
+    printf("========================================\n\n");
+
+    // ===== POLICY TEST 1: random updates keep the policy's rules and height bound =====
+    {
+        binary_tree *root = NULL;
+        avl_check report;
+        unsigned state = 12345;
+
+        for (int i = 0; i < 20000; i++) {
+            state = state * 1103515245 + 12345;
+            root = insertAvlTree(root, (int)(state >> 8) % 40000);
+        }
+        for (int i = 0; i < 20000; i++) {
+            state = state * 1103515245 + 12345;
+            int key = (int)(state >> 8) % 40000;
+            root = deleteNodeAvlTree(root, key);
+            assert(checkAvlPath(root, key, &report) == AVL_OK);
+        }
+        assert(checkAvlTree(root, &report) == AVL_OK);
+        int count = count_tree_nodes(root);
+
+        int height = real_tree_height(root);
+        assert(height <= AVL_HEIGHT_BOUND(root->height));
+        // 2*log2(n+1), what every policy promises
+        int bound = 0;
+        while ((1 << bound) < count + 1) bound++;
+        assert(height <= 2 * bound);
+        freeTree(root);
+        printf("✅ POLICY TEST 1 PASSED: Random updates keep the rank rules, height %d for %d keys\n", height, count);
+    }
+
+    // ===== POLICY TEST 2: rotations per update stay constant =====
+    {
+        binary_tree *root = NULL;
+        unsigned long before = avlRotationCount();
+        for (int key = 0; key < 4096; key++) root = insertAvlTree(root, key);
+        unsigned long inserts = avlRotationCount() - before;
+        int height = real_tree_height(root);
+
+        before = avlRotationCount();
+        for (int key = 0; key < 4096; key += 2) root = deleteNodeAvlTree(root, key);
+        unsigned long deletes = avlRotationCount() - before;
+        avl_check report;
+        assert(checkAvlTree(root, &report) == AVL_OK && report.nodes == 2048);
+        freeTree(root);
+
+#if AVL_STATS
+        // an insert rotates at most once (a double rotation counts once), ascending keys rotate a lot
+        assert(inserts > 0 && inserts <= 4096);
+#if AVL_POLICY == AVL_POLICY_AVL
+        // an avl delete may rotate on every level it retraces through
+        assert(deletes <= 2048UL * height);
+#else
+        // wavl rotates at most once per delete, red-black twice
+        assert(deletes <= 2 * 2048);
+#endif
+        printf("✅ POLICY TEST 2 PASSED: %lu rotations for 4096 inserts, %lu for 2048 deletes\n", inserts, deletes);
+#else
+        // the counts come from the statistics, make test-stats runs this with them
+        (void)inserts;
+        (void)deletes;
+        (void)height;
+        printf("✅ POLICY TEST 2 PASSED: Updates stay valid (rotation counts skipped, no AVL_STATS)\n");
+#endif
+    }
+}
+
+void run_all_cache_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING HOT KEY CACHE TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== CACHE TEST 1: hits return the tree's node, misses are not cached =====
+    {
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        for (int key = 0; key < 1000; key += 2) root = insertAvlTreePool(pool, root, key);
+        // only a pool backed tree can have a cache
+        assert(!createAvlCache(NULL, 256));
+        avl_cache *cache = createAvlCache(pool, 256);
+        assert(cache && avlCacheHitRate(cache) == 0);
+
+        for (int round = 0; round < 3; round++) {
+            for (int key = 0; key < 64; key++) {
+                binary_tree *node = searchAvlTreeCached(cache, root, key);
+                assert(node == searchAvlTree(root, key));
+            }
+        }
+        // 32 present keys miss once, the 32 absent ones miss every time
+        assert(cache->misses == 32 + 3 * 32 && cache->hits == 2 * 32);
+        assert(avlCacheHitRate(cache) > 0.33 && avlCacheHitRate(cache) < 0.34);
+
+        // inserts and their rotations leave every cached key in its node
+        for (int key = 1; key < 64; key += 2) root = insertAvlTreePool(pool, root, key);
+        for (int key = 0; key < 64; key++) assert(searchAvlTreeCached(cache, root, key)->data == key);
+        destroyAvlCache(cache);
+        destroyNodePool(pool);
+        printf("✅ CACHE TEST 1 PASSED: Hits, misses and inserts\n");
+    }
+
+    // ===== CACHE TEST 2: deletes invalidate the key and the key moved into the deleted node =====
+    {
+        // a pool hands freed nodes straight back, so a stale entry would point at a live node
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        for (int key = 0; key < 500; key++) root = insertAvlTreePool(pool, root, key);
+        avl_cache *cache = createAvlCache(pool, 4096);
+        for (int key = 0; key < 500; key++) searchAvlTreeCached(cache, root, key);
+
+        for (int i = 0; i < 200; i++) {
+            // the root always has two children, its key is replaced by a neighbour's
+            int key = root->data;
+            root = deleteNodeAvlTreeCached(cache, root, key);
+            root = insertAvlTreePool(pool, root, 1000 + i);
+            assert(!searchAvlTreeCached(cache, root, key));
+        }
+        assert(cache->invalidations >= 200);
+
+        for (int key = 0; key < 1200; key++) {
+            binary_tree *node = searchAvlTreeCached(cache, root, key);
+            assert(node == searchAvlTree(root, key));
+            assert(!node || node->data == key);
+        }
+        assert(validate_avl_tree(root, "CACHE TEST 2: Deletes"));
+        destroyAvlCache(cache);
+        destroyNodePool(pool);
+        printf("✅ CACHE TEST 2 PASSED: Deletes and moved keys invalidated\n");
+    }
+
+    // ===== CACHE TEST 3: one set evicts the least recent way, clear drops everything =====
+    {
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        for (int key = 0; key < 100; key++) root = insertAvlTreePool(pool, root, key);
+        avl_cache *cache = createAvlCache(pool, 1);
+        assert(cache->mask == 0);
+
+        // a recent key survives a few misses of other keys, a longer run of them evicts it
+        for (int i = 0; i < 10; i++) searchAvlTreeCached(cache, root, 7);
+        for (int key = 20; key < 22; key++) searchAvlTreeCached(cache, root, key);
+        uint64_t hits = cache->hits;
+        searchAvlTreeCached(cache, root, 7);
+        assert(cache->hits == hits + 1);
+        for (int key = 30; key < 40; key++) searchAvlTreeCached(cache, root, key);
+        searchAvlTreeCached(cache, root, 7);
+        assert(cache->hits == hits + 1);
+
+        // a reset pool gives its memory back, the cache has to be cleared first
+        avlCacheClear(cache);
+        resetNodePool(pool);
+        root = insertAvlTreePool(pool, NULL, 7);
+        hits = cache->hits;
+        assert(searchAvlTreeCached(cache, root, 7) == root && cache->hits == hits);
+        destroyAvlCache(cache);
+        destroyNodePool(pool);
+        printf("✅ CACHE TEST 3 PASSED: Eviction and clear\n");
+    }
+
+    // ===== CACHE TEST 4: plain deletes on a pool tree, the recycled nodes are caught on the hit =====
+    {
+        node_pool *pool = createNodePool(0);
+        binary_tree *root = NULL;
+        for (int key = 0; key < 200; key++) root = insertAvlTreePool(pool, root, key);
+        avl_cache *cache = createAvlCache(pool, 1024);
+        for (int key = 0; key < 200; key++) searchAvlTreeCached(cache, root, key);
+
+        // deleteNodeAvlTreePool knows nothing of the cache, the freed nodes come back for other keys
+        for (int key = 0; key < 200; key += 2) {
+            root = deleteNodeAvlTreePool(pool, root, key);
+            root = insertAvlTreePool(pool, root, 1000 + key);
+        }
+        for (int key = 0; key < 200; key++) {
+            binary_tree *node = searchAvlTreeCached(cache, root, key);
+            assert(node == searchAvlTree(root, key) && (!node || node->data == key));
+        }
+        assert(cache->invalidations > 0);
+
+        // and the ones still sitting free in the pool, with their old key in them
+        for (int key = 1; key < 200; key += 2) searchAvlTreeCached(cache, root, key);
+        for (int key = 1; key < 100; key += 2) root = deleteNodeAvlTreePool(pool, root, key);
+        for (int key = 1; key < 200; key += 2) assert((searchAvlTreeCached(cache, root, key) != NULL) == (key > 100));
+        destroyAvlCache(cache);
+        destroyNodePool(pool);
+        printf("✅ CACHE TEST 4 PASSED: Recycled nodes never answer for their old key\n");
+    }
+}
+
+void run_all_set_tests() {
+    printf("\n========================================\n");
+    printf("🚀 STARTING JOIN / SET OPERATION TEST SUITE\n");
+    printf("========================================\n\n");
+
+    // ===== SET TEST 1: join trees of very different heights =====
+    {
+        for (int small = 0; small < 40; small += 3) {
+            binary_tree *left = NULL, *right = NULL;
+            for (int i = 0; i < small; i++) left = insertAvlTree(left, i);
+            for (int i = 1000; i < 1500; i++) right = insertAvlTree(right, i);
+            binary_tree *pivot = insertAvlTree(NULL, 500);
+
+            binary_tree *root = joinAvlTree(left, pivot, right);
+            assert(validate_avl_tree(root, "SET TEST 1: Join (short left)"));
+            root = joinAvlTree(root, insertAvlTree(NULL, 5000), NULL);
+            assert(validate_avl_tree(root, "SET TEST 1: Join (empty right)"));
+            assert(search(root, 500) && search(root, 5000) && search(root, 1499));
+            freeTree(root);
+        }
+        printf("✅ SET TEST 1 PASSED: Join\n");
+    }
+
+    // ===== SET TEST 2: split at present and absent keys =====
+    {
+        for (int key = -1; key <= 201; key += 7) {
+            binary_tree *root = NULL, *left, *found, *right;
+            for (int i = 0; i < 200; i += 2) root = insertAvlTree(root, i);
+            splitAvlTree(root, key, &left, &found, &right);
+            assert(validate_avl_tree(left, "SET TEST 2: Split left"));
+            assert(validate_avl_tree(right, "SET TEST 2: Split right"));
+            assert((found != NULL) == (key >= 0 && key < 200 && key % 2 == 0));
+            for (int i = 0; i < 200; i += 2) {
+                if (i < key) assert(search(left, i) && !search(right, i));
+                if (i > key) assert(search(right, i) && !search(left, i));
+            }
+            freeTree(left);
+            freeTree(right);
+            freeTree(found);
+        }
+        printf("✅ SET TEST 2 PASSED: Split\n");
+    }
+
+    // ===== SET TEST 3: union, intersection, difference against a reference =====
+    {
+        for (int round = 0; round < 3; round++) {
+            int n = round == 2 ? 100000 : 300;  // the big round goes through the threaded path
+            binary_tree *a[3] = {NULL, NULL, NULL}, *b[3] = {NULL, NULL, NULL};
+            char *inA = calloc(4 * n, 1), *inB = calloc(4 * n, 1);
+            for (int i = 0; i < n; i++) {
+                int ka = (i * 7 + round) % (4 * n), kb = (i * 13 + 5) % (4 * n);
+                inA[ka] = inB[kb] = 1;
+                for (int t = 0; t < 3; t++) {
+                    a[t] = insertAvlTree(a[t], ka);
+                    b[t] = insertAvlTree(b[t], kb);
+                }
+            }
+            binary_tree *u = unionAvlTree(a[0], b[0]);
+            binary_tree *x = intersectAvlTree(a[1], b[1]);
+            binary_tree *d = differenceAvlTree(a[2], b[2]);
+            assert(validate_avl_tree(u, "SET TEST 3: Union"));
+            assert(validate_avl_tree(x, "SET TEST 3: Intersection"));
+            assert(validate_avl_tree(d, "SET TEST 3: Difference"));
+            for (int k = 0; k < 4 * n; k++) {
+                assert(search(u, k) == (inA[k] || inB[k]));
+                assert(search(x, k) == (inA[k] && inB[k]));
+                assert(search(d, k) == (inA[k] && !inB[k]));
+            }
+            freeTree(u);
+            freeTree(x);
+            freeTree(d);
+            free(inA);
+            free(inB);
+        }
+        printf("✅ SET TEST 3 PASSED: Union, intersection, difference\n");
+    }
+
+    // ===== SET TEST 4: batch insert and delete =====
+    {
+        binary_tree *root = NULL;
+        for (int i = 0; i < 100; i++) root = insertAvlTree(root, i);
+        int add[] = {150, 120, 99, 101};
+        int drop[] = {0, 50, 120, 7, 7, 1000};
+        root = insertKeysAvlTree(root, add, 4);
+        root = deleteKeysAvlTree(root, drop, 6);
+        assert(validate_avl_tree(root, "SET TEST 4: Batch updates"));
+        assert(search(root, 150) && search(root, 101) && search(root, 99));
+        assert(!search(root, 0) && !search(root, 50) && !search(root, 120) && !search(root, 7));
+        freeTree(root);
+        printf("✅ SET TEST 4 PASSED: Batch insert and delete\n");
+    }
+
+    // ===== SET TEST 5: range erase and extract =====
+    {
+        int ranges[][2] = {{100, 200}, {99, 201}, {-50, 10}, {990, 5000}, {300, 300}, {301, 301}, {500, 400}, {INT_MIN, INT_MAX}};
+        for (int r = 0; r < 8; r++) {
+            int lo = ranges[r][0], hi = ranges[r][1];
+            binary_tree *root = NULL;
+            for (int i = 0; i < 1000; i += 2) root = insertAvlTree(root, i);
+            root = eraseRangeAvlTree(root, lo, hi);
+            assert(validate_avl_tree(root, "SET TEST 5: Erase range"));
+            for (int i = 0; i < 1000; i += 2) assert(search(root, i) == (i < lo || i > hi));
+            freeTree(root);
+        }
+
+        binary_tree *root = NULL, *range = NULL;
+        for (int i = 0; i < 10000; i++) root = insertAvlTree(root, i);
+        root = extractRangeAvlTree(root, 2500, 7499, &range);
+        assert(validate_avl_tree(root, "SET TEST 5: Extract rest"));
+        assert(validate_avl_tree(range, "SET TEST 5: Extract range"));
+        for (int i = 0; i < 10000; i++) {
+            assert(search(root, i) == (i < 2500 || i > 7499));
+            assert(search(range, i) == (i >= 2500 && i <= 7499));
+        }
+#if AVL_AUGMENT
+        assert(root->size == 5000 && range->size == 5000);
+#endif
+        freeTree(range);
+        freeTree(root);
+        printf("✅ SET TEST 5 PASSED: Range erase and extract\n");
+    }
+}
+
 int main () {
   int test_array [] = {30, 20, 10, 25, 5, 15, 40, 50, 35, 45, 60, 55, 1, 2, 3};
   int length = 15;
@@ -385,6 +2608,31 @@ int main () {
   printf("\n1, 2, 3, 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60\n");
   
   run_all_deletion_tests();
+  run_all_pool_tests();
+  run_all_build_tests();
+  run_all_set_tests();
+  run_all_generic_tests();
+#if AVL_AUGMENT
+  run_all_augment_tests();
+#endif
+  run_all_cursor_tests();
+  run_all_snapshot_tests();
+  run_all_batch_tests();
+  run_all_persistent_tests();
+  run_all_concurrent_tests();
+  run_all_forest_tests();
+  run_all_serialize_tests();
+  run_all_wal_tests();
+  run_all_stats_tests();
+  run_all_compact_tests();
+  run_all_bucket_tests();
+  run_all_finger_tests();
+  run_all_traverse_tests();
+  run_all_validate_tests();
+  run_all_image_tests();
+  run_all_policy_tests();
+  run_all_cache_tests();
+  freeTree(root);
   return 0;
 
 }
@@ -0,0 +1,147 @@
+#include "../include/augment.h"
+
+#include <limits.h>
+#include <stddef.h>
+
+#if AVL_AUGMENT
+
+static int subtreeSize (binary_tree *node) {
+  return node ? node -> size : 0;
+}
+
+int sizeAvlTree (binary_tree *root) {
+  return subtreeSize(root);
+}
+
+int rankAvlTree (binary_tree *root, int key) {
+  int rank = 0;
+
+  // every time the descent goes right, the left subtree and the node itself are below key
+  while(root)
+  {
+    if(root -> data < key)
+    {
+      rank += subtreeSize(root -> left) + 1;
+      root = root -> right;
+    }
+    else root = root -> left;
+  }
+
+  return rank;
+}
+
+// keys <= key, kept apart from rankAvlTree so hi = INT_MAX needs no key + 1
+static int rankLessEqual (binary_tree *root, int key) {
+  int rank = 0;
+
+  while(root)
+  {
+    if(root -> data <= key)
+    {
+      rank += subtreeSize(root -> left) + 1;
+      root = root -> right;
+    }
+    else root = root -> left;
+  }
+
+  return rank;
+}
+
+binary_tree *selectAvlTree (binary_tree *root, int k) {
+  if(k < 0 || k >= subtreeSize(root)) return NULL;
+
+  while(root)
+  {
+    int leftSize = subtreeSize(root -> left);
+
+    if(k == leftSize) return root;
+    if(k < leftSize) root = root -> left;
+    else
+    {
+      k -= leftSize + 1;
+      root = root -> right;
+    }
+  }
+
+  return NULL;
+}
+
+binary_tree *percentileAvlTree (binary_tree *root, double p) {
+  int n = subtreeSize(root);
+  if(!n) return NULL;
+
+  if(p < 0) p = 0;
+  if(p > 1) p = 1;
+
+  // nearest rank: the smallest key with at least p of the keys at or below it
+  double target = p * n;
+  int k = (int)target;
+  if(k < target) k++;
+  return selectAvlTree(root, k > 0 ? k - 1 : 0);
+}
+
+int countRangeAvlTree (binary_tree *root, int lo, int hi) {
+  if(lo > hi) return 0;
+  return rankLessEqual(root, hi) - rankAvlTree(root, lo);
+}
+
+static void addKey (avl_aggregate *acc, int key) {
+  acc -> sum += key;
+  if(key < acc -> min) acc -> min = key;
+  if(key > acc -> max) acc -> max = key;
+}
+
+static void addSubtree (avl_aggregate *acc, int *count, binary_tree *node) {
+  if(!node) return;
+
+  acc -> sum += node -> agg.sum;
+  if(node -> agg.min < acc -> min) acc -> min = node -> agg.min;
+  if(node -> agg.max > acc -> max) acc -> max = node -> agg.max;
+  *count += node -> size;
+}
+
+avl_aggregate aggregateRangeAvlTree (binary_tree *root, int lo, int hi, int *count) {
+  avl_aggregate acc = {0, INT_MAX, INT_MIN};
+  int n = 0;
+
+  // first node inside the range, above it the two range ends share one path
+  while(root && (root -> data < lo || root -> data > hi))
+    root = root -> data < lo ? root -> right : root -> left;
+
+  if(root && lo <= hi)
+  {
+    addKey(&acc, root -> data);
+    n++;
+
+    // left boundary: a node >= lo brings its whole right subtree along
+    for (binary_tree *node = root -> left; node; )
+    {
+      if(node -> data >= lo)
+      {
+        addKey(&acc, node -> data);
+        addSubtree(&acc, &n, node -> right);
+        n++;
+        node = node -> left;
+      }
+      else node = node -> right;
+    }
+
+    // right boundary, mirrored
+    for (binary_tree *node = root -> right; node; )
+    {
+      if(node -> data <= hi)
+      {
+        addKey(&acc, node -> data);
+        addSubtree(&acc, &n, node -> left);
+        n++;
+        node = node -> right;
+      }
+      else node = node -> left;
+    }
+  }
+
+  if(count) *count = n;
+  return acc;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "../include/batch.h"
+#include "../include/tree.h"
+
+// lookups in flight at once, enough to cover memory latency without running out of fill buffers
+#define BATCH_LANES 16
+// descents queued up before they are run through the lanes
+#define BATCH_CHUNK 256
+// below this height (~100k nodes) the tree mostly sits in cache and plain descents are cheaper
+#define BATCH_MIN_HEIGHT 20
+
+typedef struct batch_lane {
+  binary_tree *node;
+  size_t index;
+}batch_lane;
+
+// finishes the descents in work, each one from its own start node (never NULL).
+// round robin over the lanes: one level per visit with the next node prefetched,
+// and a finished lane takes the next queued descent right away
+static void runLanes (const batch_lane *work, size_t count, const int *keys, binary_tree **results) {
+  batch_lane lanes[BATCH_LANES];
+  size_t next = 0;
+  int active = 0;
+
+  if(count && work[0].node -> height < BATCH_MIN_HEIGHT)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      binary_tree *node = work[i].node;
+      int key = keys[work[i].index];
+
+      while(node && node -> data != key) node = key < node -> data ? node -> left : node -> right;
+      results[work[i].index] = node;
+    }
+    return;
+  }
+
+  while(active < BATCH_LANES && next < count) lanes[active++] = work[next++];
+
+  while(active)
+  {
+    for (int j = 0; j < active; j++)
+    {
+      batch_lane *lane = &lanes[j];
+      binary_tree *node = lane -> node;
+      int key = keys[lane -> index];
+      binary_tree *child;
+
+      if(node -> data == key) child = NULL;
+      else child = key < node -> data ? node -> left : node -> right;
+
+      if(child)
+      {
+        __builtin_prefetch(child);
+        lane -> node = child;
+        continue;
+      }
+
+      results[lane -> index] = node -> data == key ? node : NULL;
+
+      // retire the lane by refilling it, or by moving the last lane into its place and looking at that one
+      if(next < count) *lane = work[next++];
+      else lanes[j--] = lanes[--active];
+    }
+  }
+}
+
+void searchBatchAvlTree (binary_tree *root, const int *keys, size_t n, binary_tree **results) {
+  batch_lane work[BATCH_CHUNK];
+
+  if(!root)
+  {
+    for (size_t i = 0; i < n; i++) results[i] = NULL;
+    return;
+  }
+
+  for (size_t start = 0; start < n; start += BATCH_CHUNK)
+  {
+    size_t count = n - start < BATCH_CHUNK ? n - start : BATCH_CHUNK;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      work[i].node = root;
+      work[i].index = start + i;
+    }
+    runLanes(work, count, keys, results);
+  }
+}
+
+typedef struct sorted_batch {
+  const int *keys;
+  binary_tree **results;
+  batch_lane work[BATCH_CHUNK];
+  size_t count;
+}sorted_batch;
+
+// first index in [lo, hi) whose key is >= key
+static size_t lowerBound (const int *keys, size_t lo, size_t hi, int key) {
+  while(lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if(keys[mid] < key) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static void queueDescent (sorted_batch *batch, binary_tree *node, size_t index) {
+  batch -> work[batch -> count].node = node;
+  batch -> work[batch -> count].index = index;
+
+  if(++batch -> count == BATCH_CHUNK)
+  {
+    runLanes(batch -> work, batch -> count, batch -> keys, batch -> results);
+    batch -> count = 0;
+  }
+}
+
+// walks the part of the tree shared by several keys once, a key that ends up alone in a subtree
+// continues as an ordinary interleaved descent from there
+static void sortedBatch (sorted_batch *batch, binary_tree *node, size_t lo, size_t hi) {
+  const int *keys = batch -> keys;
+
+  while(lo < hi)
+  {
+    if(!node)
+    {
+      for (size_t i = lo; i < hi; i++) batch -> results[i] = NULL;
+      return;
+    }
+
+    if(hi - lo == 1 || keys[lo] == keys[hi - 1])
+    {
+      for (size_t i = lo; i < hi; i++) queueDescent(batch, node, i);
+      return;
+    }
+
+    // keys below node -> data go left, equal ones hit this node, the rest go right
+    size_t split = lowerBound(keys, lo, hi, node -> data);
+    size_t after = split;
+    while(after < hi && keys[after] == node -> data) batch -> results[after++] = node;
+
+    sortedBatch(batch, node -> left, lo, split);
+    node = node -> right;
+    lo = after;
+  }
+}
+
+void searchSortedBatchAvlTree (binary_tree *root, const int *keys, size_t n, binary_tree **results) {
+  sorted_batch batch;
+
+  batch.keys = keys;
+  batch.results = results;
+  batch.count = 0;
+
+  sortedBatch(&batch, root, 0, n);
+  runLanes(batch.work, batch.count, keys, results);
+}
@@ -0,0 +1,290 @@
+#include "../include/bucket.h"
+#include "../include/tree.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// one node is two cache lines, kept on a line boundary
+#define BUCKET_NODE_BYTES 128
+
+static bucket_node *newBucket (int key) {
+  bucket_node *node = aligned_alloc(64, BUCKET_NODE_BYTES);
+  if(!node) return NULL;
+
+  for (int i = 0; i < BUCKET_KEYS; i++) node -> keys[i] = INT_MAX;
+  node -> keys[0] = key;
+  node -> count = 1;
+  node -> left = node -> right = NULL;
+  node -> height = 0;
+
+  return node;
+}
+
+// number of keys in the block below key, the INT_MAX padding never counts
+static int rankInBucket (const bucket_node *node, int key) {
+#ifdef __SSE2__
+  __m128i target = _mm_set1_epi32(key);
+  __m128i below = _mm_setzero_si128();
+
+  // every lane of a compare is -1 where the key is smaller, subtracting them counts per lane
+  for (int i = 0; i < BUCKET_KEYS; i += 4)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)(node -> keys + i));
+    below = _mm_sub_epi32(below, _mm_cmplt_epi32(block, target));
+  }
+  below = _mm_add_epi32(below, _mm_shuffle_epi32(below, _MM_SHUFFLE(1, 0, 3, 2)));
+  below = _mm_add_epi32(below, _mm_shuffle_epi32(below, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(below);
+#else
+  int rank = 0;
+  for (int i = 0; i < node -> count; i++) rank += node -> keys[i] < key;
+  return rank;
+#endif
+}
+
+static void insertAt (bucket_node *node, int pos, int key) {
+  memmove(node -> keys + pos + 1, node -> keys + pos, (node -> count - pos) * sizeof(int));
+  node -> keys[pos] = key;
+  node -> count++;
+}
+
+static void removeAt (bucket_node *node, int pos) {
+  memmove(node -> keys + pos, node -> keys + pos + 1, (node -> count - pos - 1) * sizeof(int));
+  node -> keys[--node -> count] = INT_MAX;
+}
+
+static int heightOf (const bucket_node *node) {
+  return node ? node -> height : -1;
+}
+
+static void fixHeight (bucket_node *node) {
+  int hl = heightOf(node -> left);
+  int hr = heightOf(node -> right);
+  node -> height = (hl > hr ? hl : hr) + 1;
+}
+
+static bucket_node *rotateRight (bucket_node *root) {
+  bucket_node *newRoot = root -> left;
+  root -> left = newRoot -> right;
+  newRoot -> right = root;
+  fixHeight(root);
+  fixHeight(newRoot);
+  return newRoot;
+}
+
+static bucket_node *rotateLeft (bucket_node *root) {
+  bucket_node *newRoot = root -> right;
+  root -> right = newRoot -> left;
+  newRoot -> left = root;
+  fixHeight(root);
+  fixHeight(newRoot);
+  return newRoot;
+}
+
+// same four cases as balanceNode, on whole buckets (the keys never move between nodes here)
+static bucket_node *rebalance (bucket_node *node) {
+  fixHeight(node);
+  int balanceFactor = heightOf(node -> left) - heightOf(node -> right);
+
+  if(balanceFactor > 1)
+  {
+    if(heightOf(node -> left -> left) < heightOf(node -> left -> right)) node -> left = rotateLeft(node -> left);
+    return rotateRight(node);
+  }
+  if(balanceFactor < -1)
+  {
+    if(heightOf(node -> right -> right) < heightOf(node -> right -> left)) node -> right = rotateRight(node -> right);
+    return rotateLeft(node);
+  }
+
+  return node;
+}
+
+// bottom up over the path after a node was added or removed below path[depth - 1], stops once a subtree
+// comes out at its old height since nothing above it can change then
+static bucket_node *retrace (bucket_node *root, bucket_node **path, int depth) {
+  for (int i = depth - 1; i >= 0; i--)
+  {
+    bucket_node *curr = path[i];
+    int oldHeight = curr -> height;
+    bucket_node *top = rebalance(curr);
+
+    if(!i) root = top;
+    else if(path[i - 1] -> left == curr) path[i - 1] -> left = top;
+    else path[i - 1] -> right = top;
+
+    if(top -> height == oldHeight) break;
+  }
+
+  return root;
+}
+
+bucket_node *insertBucketTree (bucket_node *root, int key) {
+  bucket_node *path[AVL_MAX_HEIGHT];
+  bucket_node *spare = NULL;
+  int depth = 0;
+  int dir;
+
+  if(!root) return newBucket(key);
+
+  bucket_node *curr = root;
+  while(1)
+  {
+    if(key < curr -> keys[0]) dir = 0;
+    else if(key > curr -> keys[curr -> count - 1]) dir = 1;
+    else
+    {
+      // the bounding bucket: the key goes here, a full bucket pushes its smallest key down to the
+      // greatest lower bound (the end of the descent through the left subtree)
+      int pos = rankInBucket(curr, key);
+      if(curr -> keys[pos] == key) return root;
+
+      if(curr -> count < BUCKET_KEYS)
+      {
+        insertAt(curr, pos, key);
+        return root;
+      }
+
+      // the node the pushed down key may need is taken first, so running out of memory changes nothing
+      spare = newBucket(0);
+      if(!spare) return root;
+
+      int smallest = curr -> keys[0];
+      removeAt(curr, 0);
+      insertAt(curr, pos - 1, key);
+      key = smallest;
+      dir = 0;
+    }
+
+    bucket_node *next = dir ? curr -> right : curr -> left;
+    if(!next) break;
+    path[depth++] = curr;
+    curr = next;
+  }
+
+  // the key lies just past the end of curr on the dir side
+  if(curr -> count < BUCKET_KEYS)
+  {
+    insertAt(curr, dir ? curr -> count : 0, key);
+    free(spare);
+    return root;
+  }
+
+  bucket_node *node = spare ? spare : newBucket(key);
+  if(!node) return root;
+  node -> keys[0] = key;
+
+  if(dir) curr -> right = node;
+  else curr -> left = node;
+  path[depth++] = curr;
+
+  return retrace(root, path, depth);
+}
+
+// a node with one child that is a leaf takes the leaf's keys when they fit, so half empty leaves
+// left behind by deletions do not pile up
+static bucket_node *mergeLeafChild (bucket_node *root, bucket_node **path, int depth, bucket_node *curr) {
+  bucket_node *child = curr -> left ? curr -> left : curr -> right;
+  if(!child || child -> left || child -> right || curr -> count + child -> count > BUCKET_KEYS) return root;
+
+  if(child == curr -> left)
+  {
+    memmove(curr -> keys + child -> count, curr -> keys, curr -> count * sizeof(int));
+    memcpy(curr -> keys, child -> keys, child -> count * sizeof(int));
+    curr -> left = NULL;
+  }
+  else
+  {
+    memcpy(curr -> keys + curr -> count, child -> keys, child -> count * sizeof(int));
+    curr -> right = NULL;
+  }
+  curr -> count += child -> count;
+  free(child);
+
+  path[depth++] = curr;
+  return retrace(root, path, depth);
+}
+
+bucket_node *deleteBucketTree (bucket_node *root, int key) {
+  bucket_node *path[AVL_MAX_HEIGHT];
+  int depth = 0;
+  bucket_node *curr = root;
+
+  while(curr && (key < curr -> keys[0] || key > curr -> keys[curr -> count - 1]))
+  {
+    path[depth++] = curr;
+    curr = key < curr -> keys[0] ? curr -> left : curr -> right;
+  }
+  if(!curr) return root;
+
+  int pos = rankInBucket(curr, key);
+  if(curr -> keys[pos] != key) return root;
+  removeAt(curr, pos);
+
+  if(curr -> left && curr -> right)
+  {
+    if(curr -> count >= BUCKET_MIN_KEYS) return root;
+
+    // an internal bucket refills from the largest key of its greatest lower bound, which has no right child
+    path[depth++] = curr;
+    bucket_node *glb = curr -> left;
+    while(glb -> right)
+    {
+      path[depth++] = glb;
+      glb = glb -> right;
+    }
+
+    insertAt(curr, 0, glb -> keys[glb -> count - 1]);
+    removeAt(glb, glb -> count - 1);
+    if(glb -> count) return root;
+    curr = glb;
+  }
+  else if(curr -> count) return mergeLeafChild(root, path, depth, curr);
+
+  // curr is empty and has at most one child, which takes its place
+  bucket_node *child = curr -> left ? curr -> left : curr -> right;
+  if(!depth) root = child;
+  else if(path[depth - 1] -> left == curr) path[depth - 1] -> left = child;
+  else path[depth - 1] -> right = child;
+  free(curr);
+
+  return retrace(root, path, depth);
+}
+
+bool bucketContains (const bucket_node *root, int key) {
+  const bucket_node *node = root;
+  const bucket_node *candidate = NULL;
+
+  // one comparison a level and no early exit, the select is done with masks since gcc turns a ternary
+  // here into a branch that mispredicts half the time (measured 1.5x slower at 10M keys)
+  while(node)
+  {
+    uintptr_t right = -(uintptr_t)(key >= node -> keys[0]);
+    candidate = (const bucket_node *)(((uintptr_t)candidate & ~right) | ((uintptr_t)node & right));
+    node = (const bucket_node *)(((uintptr_t)node -> left & ~right) | ((uintptr_t)node -> right & right));
+  }
+  if(!candidate) return false;
+
+  int pos = rankInBucket(candidate, key);
+  return pos < candidate -> count && candidate -> keys[pos] == key;
+}
+
+size_t bucketTreeSize (const bucket_node *root) {
+  if(!root) return 0;
+  return root -> count + bucketTreeSize(root -> left) + bucketTreeSize(root -> right);
+}
+
+void freeBucketTree (bucket_node *root) {
+  if(root)
+  {
+    freeBucketTree(root -> left);
+    freeBucketTree(root -> right);
+    free(root);
+  }
+}
@@ -0,0 +1,103 @@
+#include "../include/build.h"
+#include "../include/tree.h"
+#include "../include/pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a built tree carries subtree heights, which break the red-black rank rule
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "the bulk builds need the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+// middle key becomes the root, so every subtree is as balanced as it can get and no rotation is ever needed
+static binary_tree *buildRange (node_pool *pool, const int *keys, size_t lo, size_t hi) {
+  if(lo >= hi) return NULL;
+
+  size_t mid = lo + (hi - lo) / 2;
+  binary_tree *node = newTreeNode(pool, keys[mid]);
+  if(!node) return NULL;
+
+  node -> left = buildRange(pool, keys, lo, mid);
+  node -> right = buildRange(pool, keys, mid + 1, hi);
+
+  // a missing child means an allocation failed somewhere below, give back what was built
+  if((!node -> left && lo < mid) || (!node -> right && mid + 1 < hi))
+  {
+    freeTreePool(pool, node);
+    return NULL;
+  }
+
+  updateNode(node);
+  return node;
+}
+
+binary_tree *buildAvlFromSortedPool (node_pool *pool, const int *keys, size_t n) {
+  return buildRange(pool, keys, 0, n);
+}
+
+binary_tree *buildAvlFromSorted (const int *keys, size_t n) {
+  return buildAvlFromSortedPool(NULL, keys, n);
+}
+
+size_t sortUniqueKeys (int *keys, size_t n) {
+  if(n < 2) return n;
+
+  uint32_t *src = (uint32_t *)keys;
+  uint32_t *dst = malloc(n * sizeof(uint32_t));
+  if(!dst) return AVL_SORT_FAILED;
+
+  // flipping the sign bit makes the unsigned order match the signed one
+  for (size_t i = 0; i < n; i++) src[i] ^= 0x80000000u;
+
+  // lsd radix sort, four 8 bit passes, an even number so the result ends up back in keys
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    size_t count[256] = {0};
+
+    for (size_t i = 0; i < n; i++) count[(src[i] >> shift) & 0xff]++;
+
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++)
+    {
+      size_t c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+
+    for (size_t i = 0; i < n; i++) dst[count[(src[i] >> shift) & 0xff]++] = src[i];
+
+    uint32_t *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  free(dst);
+
+  size_t unique = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    uint32_t key = src[i] ^ 0x80000000u;
+    if(!unique || (int)key != keys[unique - 1]) keys[unique++] = (int)key;
+  }
+
+  return unique;
+}
+
+binary_tree *buildAvlFromUnsortedPool (node_pool *pool, const int *keys, size_t n) {
+  if(!n) return NULL;
+
+  int *scratch = malloc(n * sizeof(int));
+  if(!scratch) return NULL;
+  memcpy(scratch, keys, n * sizeof(int));
+
+  size_t unique = sortUniqueKeys(scratch, n);
+  binary_tree *root = unique == AVL_SORT_FAILED ? NULL : buildAvlFromSortedPool(pool, scratch, unique);
+
+  free(scratch);
+  return root;
+}
+
+binary_tree *buildAvlFromUnsorted (const int *keys, size_t n) {
+  return buildAvlFromUnsortedPool(NULL, keys, n);
+}
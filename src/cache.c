@@ -0,0 +1,120 @@
+#include "../include/cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+// fibonacci hashing, the top bits of key * 2^32/phi pick the set so nearby keys spread out
+static avl_cache_entry *setOf (const avl_cache *cache, int key) {
+  uint64_t hash = (uint32_t)key * 2654435769u;
+  return cache -> sets + (size_t)(hash >> cache -> shift) * AVL_CACHE_WAYS;
+}
+
+avl_cache *createAvlCache (node_pool *pool, size_t entries) {
+  if(!pool) return NULL;
+
+  avl_cache *cache = malloc(sizeof(avl_cache));
+  if(!cache) return NULL;
+
+  size_t sets = 1;
+  int bits = 0;
+  while(sets * AVL_CACHE_WAYS < entries && bits < 31)
+  {
+    sets <<= 1;
+    bits++;
+  }
+
+  size_t bytes = sets * AVL_CACHE_WAYS * sizeof(avl_cache_entry);
+  cache -> sets = aligned_alloc(CACHE_LINE, bytes < CACHE_LINE ? CACHE_LINE : bytes);
+  if(!cache -> sets)
+  {
+    free(cache);
+    return NULL;
+  }
+
+  cache -> pool = pool;
+  cache -> mask = (uint32_t)(sets - 1);
+  cache -> shift = 32 - bits;
+  cache -> hits = cache -> misses = cache -> invalidations = 0;
+  avlCacheClear(cache);
+  return cache;
+}
+
+void destroyAvlCache (avl_cache *cache) {
+  if(!cache) return;
+  free(cache -> sets);
+  free(cache);
+}
+
+void avlCacheClear (avl_cache *cache) {
+  memset(cache -> sets, 0, ((size_t)cache -> mask + 1) * AVL_CACHE_WAYS * sizeof(avl_cache_entry));
+}
+
+// a hit moves one way up, so a key that keeps hitting settles in way 0 and a miss evicts the last way
+binary_tree *searchAvlTreeCached (avl_cache *cache, binary_tree *root, int key) {
+  avl_cache_entry *set = setOf(cache, key);
+
+  for (int way = 0; way < AVL_CACHE_WAYS; way++)
+  {
+    if(set[way].node && set[way].key == key)
+    {
+      binary_tree *node = set[way].node;
+      // a node freed behind the cache's back is still pool memory, marked free or holding another key
+      // once the pool has handed it out again
+      if(node -> height < 0 || node -> data != key)
+      {
+        set[way].node = NULL;
+        cache -> invalidations++;
+        break;
+      }
+      cache -> hits++;
+      if(way)
+      {
+        set[way] = set[way - 1];
+        set[way - 1].key = key;
+        set[way - 1].node = node;
+      }
+      return node;
+    }
+  }
+
+  cache -> misses++;
+  binary_tree *node = searchAvlTree(root, key);
+  if(node)
+  {
+    memmove(set + 1, set, (AVL_CACHE_WAYS - 1) * sizeof(avl_cache_entry));
+    set[0].key = key;
+    set[0].node = node;
+  }
+  return node;
+}
+
+void avlCacheInvalidate (avl_cache *cache, int key) {
+  avl_cache_entry *set = setOf(cache, key);
+
+  for (int way = 0; way < AVL_CACHE_WAYS; way++)
+  {
+    if(set[way].node && set[way].key == key)
+    {
+      set[way].node = NULL;
+      cache -> invalidations++;
+    }
+  }
+}
+
+binary_tree *deleteNodeAvlTreeCached (avl_cache *cache, binary_tree *root, int key) {
+  binary_tree *moved;
+
+  avlCacheInvalidate(cache, key);
+  root = refactorTree(cache -> pool, root, key, &moved);
+  // the key moved in from a predecessor or successor whose node is now free
+  if(moved) avlCacheInvalidate(cache, moved -> data);
+
+  return root;
+}
+
+double avlCacheHitRate (const avl_cache *cache) {
+  uint64_t lookups = cache -> hits + cache -> misses;
+  return lookups ? (double)cache -> hits / lookups : 0;
+}
@@ -0,0 +1,295 @@
+#include "../include/compact.h"
+#include "../include/tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define COMPACT_DEFAULT_CAPACITY 1024
+
+// dir 0 is the left side and 1 the right one, heavy(dir) the balance factor leaning that way
+static inline unsigned heavy (int dir) {
+  return dir ? COMPACT_RIGHT_HEAVY : COMPACT_LEFT_HEAVY;
+}
+
+static inline uint32_t childOf (const compact_tree *tree, uint32_t i, int dir) {
+  return dir ? tree -> nodes[i].right : tree -> nodes[i].left;
+}
+
+static inline void setChild (compact_tree *tree, uint32_t i, int dir, uint32_t child) {
+  if(dir) tree -> nodes[i].right = child;
+  else tree -> nodes[i].left = child;
+}
+
+static inline unsigned balanceOf (const compact_tree *tree, uint32_t i) {
+  return compactBalance(tree, i);
+}
+
+static inline void setBalance (compact_tree *tree, uint32_t i, unsigned balance) {
+  uint8_t *byte = &tree -> balance[i >> 2];
+  int shift = (i & 3) * 2;
+  *byte = (uint8_t)((*byte & ~(3u << shift)) | balance << shift);
+}
+
+static size_t balanceBytes (uint32_t capacity) {
+  return ((size_t)capacity + 3) / 4;
+}
+
+compact_tree *createCompactTree (size_t capacity) {
+  compact_tree *tree = malloc(sizeof(compact_tree));
+  if(!tree) return NULL;
+
+  if(!capacity) capacity = COMPACT_DEFAULT_CAPACITY;
+  if(capacity > COMPACT_MAX_NODES) capacity = COMPACT_MAX_NODES;
+
+  // slot 0 is the null link and never handed out
+  tree -> capacity = (uint32_t)capacity + 1;
+  tree -> nodes = malloc(tree -> capacity * sizeof(compact_node));
+  tree -> balance = calloc(balanceBytes(tree -> capacity), 1);
+  if(!tree -> nodes || !tree -> balance)
+  {
+    free(tree -> nodes);
+    free(tree -> balance);
+    free(tree);
+    return NULL;
+  }
+
+  tree -> used = 1;
+  tree -> freeList = COMPACT_NIL;
+  tree -> root = COMPACT_NIL;
+  tree -> count = 0;
+
+  return tree;
+}
+
+void destroyCompactTree (compact_tree *tree) {
+  if(!tree) return;
+  free(tree -> nodes);
+  free(tree -> balance);
+  free(tree);
+}
+
+static uint32_t allocNode (compact_tree *tree, int key) {
+  uint32_t i = tree -> freeList;
+
+  if(i) tree -> freeList = tree -> nodes[i].right;
+  else
+  {
+    if(tree -> used == tree -> capacity)
+    {
+      if(tree -> capacity > COMPACT_MAX_NODES) return COMPACT_NIL;
+      size_t capacity = (size_t)tree -> capacity * 2;
+      if(capacity > (size_t)COMPACT_MAX_NODES + 1) capacity = (size_t)COMPACT_MAX_NODES + 1;
+
+      compact_node *grown = realloc(tree -> nodes, capacity * sizeof(compact_node));
+      if(!grown) return COMPACT_NIL;
+      tree -> nodes = grown;
+
+      uint8_t *balance = realloc(tree -> balance, balanceBytes((uint32_t)capacity));
+      if(!balance) return COMPACT_NIL;
+      memset(balance + balanceBytes(tree -> capacity), 0, balanceBytes((uint32_t)capacity) - balanceBytes(tree -> capacity));
+      tree -> balance = balance;
+      tree -> capacity = (uint32_t)capacity;
+    }
+    i = tree -> used++;
+  }
+
+  tree -> nodes[i].left = COMPACT_NIL;
+  tree -> nodes[i].right = COMPACT_NIL;
+  tree -> nodes[i].key = key;
+  setBalance(tree, i, COMPACT_BALANCED);
+  return i;
+}
+
+static void freeNode (compact_tree *tree, uint32_t i) {
+  tree -> nodes[i].left = COMPACT_NIL;
+  tree -> nodes[i].right = tree -> freeList;
+  tree -> freeList = i;
+}
+
+// lifts the side child of x above it (side 0 is the ll case, 1 the rr case), returns the new subtree root
+static uint32_t rotate (compact_tree *tree, uint32_t x, int side) {
+  uint32_t z = childOf(tree, x, side);
+
+  setChild(tree, x, side, childOf(tree, z, !side));
+  setChild(tree, z, !side, x);
+
+  return z;
+}
+
+// x leans two levels to side: rotates it back and sets the balance factors from the ones before the rotation
+// instead of from heights. shrunk tells whether the subtree lost a level, which only a deletion can keep
+// from happening (a balanced child, single rotation)
+static uint32_t rebalance (compact_tree *tree, uint32_t x, int side, bool *shrunk) {
+  uint32_t z = childOf(tree, x, side);
+  unsigned zBalance = balanceOf(tree, z);
+
+  // the lr/rl case, the grandchild y ends up on top and its old lean decides the other two
+  if(zBalance == heavy(!side))
+  {
+    uint32_t y = childOf(tree, z, !side);
+    unsigned yBalance = balanceOf(tree, y);
+
+    setChild(tree, x, side, rotate(tree, z, !side));
+    rotate(tree, x, side);
+
+    setBalance(tree, x, yBalance == heavy(side) ? heavy(!side) : COMPACT_BALANCED);
+    setBalance(tree, z, yBalance == heavy(!side) ? heavy(side) : COMPACT_BALANCED);
+    setBalance(tree, y, COMPACT_BALANCED);
+    *shrunk = true;
+    return y;
+  }
+
+  rotate(tree, x, side);
+
+  if(zBalance == COMPACT_BALANCED)
+  {
+    setBalance(tree, x, heavy(side));
+    setBalance(tree, z, heavy(!side));
+    *shrunk = false;
+  }
+  else
+  {
+    setBalance(tree, x, COMPACT_BALANCED);
+    setBalance(tree, z, COMPACT_BALANCED);
+    *shrunk = true;
+  }
+
+  return z;
+}
+
+// hangs a rotated subtree back under the parent at depth - 1 on the path, or makes it the root
+static void relink (compact_tree *tree, const uint32_t *path, const unsigned char *dirs, int depth, uint32_t top) {
+  if(depth) setChild(tree, path[depth - 1], dirs[depth - 1], top);
+  else tree -> root = top;
+}
+
+bool compactInsert (compact_tree *tree, int key) {
+  uint32_t path[AVL_MAX_HEIGHT];
+  unsigned char dirs[AVL_MAX_HEIGHT];
+  int depth = 0;
+  uint32_t i = tree -> root;
+
+  while(i)
+  {
+    int nodeKey = tree -> nodes[i].key;
+    if(nodeKey == key) return false;
+
+    path[depth] = i;
+    dirs[depth] = nodeKey < key;
+    i = childOf(tree, i, dirs[depth++]);
+  }
+
+  uint32_t node = allocNode(tree, key);
+  if(!node) return false;
+  relink(tree, path, dirs, depth, node);
+  tree -> count++;
+
+  // a balanced node now leans and its subtree grew, a node leaning the other way is now balanced and
+  // nothing above changes, a node leaning the same way is rotated back to its old height
+  for (int d = depth - 1; d >= 0; d--)
+  {
+    uint32_t x = path[d];
+    unsigned balance = balanceOf(tree, x);
+
+    if(balance == COMPACT_BALANCED)
+    {
+      setBalance(tree, x, heavy(dirs[d]));
+      continue;
+    }
+    if(balance != heavy(dirs[d]))
+    {
+      setBalance(tree, x, COMPACT_BALANCED);
+      break;
+    }
+
+    bool shrunk;
+    relink(tree, path, dirs, d, rebalance(tree, x, dirs[d], &shrunk));
+    break;
+  }
+
+  return true;
+}
+
+bool compactDelete (compact_tree *tree, int key) {
+  uint32_t path[AVL_MAX_HEIGHT];
+  unsigned char dirs[AVL_MAX_HEIGHT];
+  int depth = 0;
+  uint32_t i = tree -> root;
+
+  while(i && tree -> nodes[i].key != key)
+  {
+    path[depth] = i;
+    dirs[depth] = tree -> nodes[i].key < key;
+    i = childOf(tree, i, dirs[depth++]);
+  }
+  if(!i) return false;
+
+  // two children: the inorder successor's key moves up and the successor (no left child) is unlinked
+  if(tree -> nodes[i].left && tree -> nodes[i].right)
+  {
+    uint32_t target = i;
+    path[depth] = i;
+    dirs[depth++] = 1;
+    i = tree -> nodes[i].right;
+
+    while(tree -> nodes[i].left)
+    {
+      path[depth] = i;
+      dirs[depth++] = 0;
+      i = tree -> nodes[i].left;
+    }
+    tree -> nodes[target].key = tree -> nodes[i].key;
+  }
+
+  uint32_t child = tree -> nodes[i].left ? tree -> nodes[i].left : tree -> nodes[i].right;
+  relink(tree, path, dirs, depth, child);
+  freeNode(tree, i);
+  tree -> count--;
+
+  // the dirs[d] side lost a level: a node leaning that way is now balanced and shrank too, a balanced one
+  // now leans the other way at its old height, one already leaning the other way needs a rotation
+  for (int d = depth - 1; d >= 0; d--)
+  {
+    uint32_t x = path[d];
+    unsigned balance = balanceOf(tree, x);
+
+    if(balance == heavy(dirs[d]))
+    {
+      setBalance(tree, x, COMPACT_BALANCED);
+      continue;
+    }
+    if(balance == COMPACT_BALANCED)
+    {
+      setBalance(tree, x, heavy(!dirs[d]));
+      break;
+    }
+
+    bool shrunk;
+    relink(tree, path, dirs, d, rebalance(tree, x, !dirs[d], &shrunk));
+    if(!shrunk) break;
+  }
+
+  return true;
+}
+
+bool compactContains (const compact_tree *tree, int key) {
+  const compact_node *nodes = tree -> nodes;
+  uint32_t i = tree -> root;
+
+  while(i)
+  {
+    int nodeKey = nodes[i].key;
+    if(nodeKey == key) return true;
+    i = nodeKey < key ? nodes[i].right : nodes[i].left;
+  }
+
+  return false;
+}
+
+size_t compactSize (const compact_tree *tree) {
+  return tree -> count;
+}
+
+size_t compactBytes (const compact_tree *tree) {
+  return (size_t)tree -> capacity * sizeof(compact_node) + balanceBytes(tree -> capacity);
+}
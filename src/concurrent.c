@@ -0,0 +1,852 @@
+#include "../include/concurrent.h"
+
+#include <stdlib.h>
+
+// version word of a node: bit 0 is set while a rotation is moving it down (searches below it may be
+// looking at the wrong subtree), every finished rotation bumps the count above the two low bits and an
+// unlinked node is frozen at exactly OVL_UNLINKED. growing a subtree never invalidates a search in it,
+// so only shrinking changes the version
+#define OVL_SHRINKING 1UL
+#define OVL_UNLINKED 2UL
+
+#define THREAD_FREE 0
+#define THREAD_IDLE 1
+
+// an operation tries to advance the global epoch once every this many calls
+#define EPOCH_PERIOD 64
+
+// outcomes of a single optimistic attempt, the real answers are 0 and 1
+#define RETRY -1
+
+// what a node needs after its children changed, anything >= 0 is the height it should have
+#define UNLINK_REQUIRED -1
+#define REBALANCE_REQUIRED -2
+#define NOTHING_REQUIRED -3
+
+static bool isShrinking (unsigned long version) {
+  return (version & OVL_SHRINKING) != 0;
+}
+
+static unsigned long beginChange (unsigned long version) {
+  return version | OVL_SHRINKING;
+}
+
+static unsigned long endChange (unsigned long version) {
+  return (version | 3) + 1;
+}
+
+static void nodeLock (concurrent_node *node) {
+  pthread_mutex_lock(&node -> lock);
+}
+
+static void nodeUnlock (concurrent_node *node) {
+  pthread_mutex_unlock(&node -> lock);
+}
+
+static concurrent_node *childOf (concurrent_node *node, int dir) {
+  return atomic_load(dir < 0 ? &node -> left : &node -> right);
+}
+
+static int heightOf (concurrent_node *node) {
+  return node ? atomic_load(&node -> height) : 0;
+}
+
+static int max2 (int a, int b) {
+  return a > b ? a : b;
+}
+
+// rotations hold the node's lock for their whole duration, so once the lock is free it is done
+static void waitUntilNotChanging (concurrent_node *node) {
+  for (int i = 0; i < 32; i++)
+  {
+    if(!isShrinking(atomic_load(&node -> version))) return;
+  }
+  nodeLock(node);
+  nodeUnlock(node);
+}
+
+static concurrent_node *newNode (int key, concurrent_node *parent) {
+  concurrent_node *node = malloc(sizeof(concurrent_node));
+  if(!node) return NULL;
+
+  atomic_init(&node -> left, NULL);
+  atomic_init(&node -> right, NULL);
+  atomic_init(&node -> parent, parent);
+  atomic_init(&node -> version, 0);
+  atomic_init(&node -> height, 1);
+  atomic_init(&node -> present, 1);
+  pthread_mutex_init(&node -> lock, NULL);
+  node -> key = key;
+  node -> retiredNext = NULL;
+
+  return node;
+}
+
+static void freeChain (concurrent_node *node) {
+  while(node)
+  {
+    concurrent_node *next = node -> retiredNext;
+    pthread_mutex_destroy(&node -> lock);
+    free(node);
+    node = next;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// epoch based reclamation: a node unlinked during epoch e may still be under a search that entered in
+// e or e - 1, the global epoch only moves on once every active thread has seen the current one, so
+// by e + 2 all of them are gone
+
+// frees the limbo lists this thread filled at least two epochs before the one it is running in
+static void reclaim (concurrent_thread *self, unsigned long epoch) {
+  for (int i = 0; i < 3; i++)
+  {
+    if(self -> limbo[i] && self -> limboEpoch[i] + 2 <= epoch)
+    {
+      freeChain(self -> limbo[i]);
+      self -> limbo[i] = NULL;
+    }
+  }
+}
+
+static void tryAdvance (concurrent_avl *tree) {
+  unsigned long epoch = atomic_load(&tree -> epoch);
+
+  for (int i = 0; i < CONCURRENT_MAX_THREADS; i++)
+  {
+    unsigned long state = atomic_load(&tree -> threads[i].state);
+    if(state > THREAD_IDLE && state - 2 != epoch) return;
+  }
+
+  atomic_compare_exchange_strong(&tree -> epoch, &epoch, epoch + 1);
+}
+
+static void enterOperation (concurrent_avl *tree, concurrent_thread *self) {
+  if(++self -> ops % EPOCH_PERIOD == 0) tryAdvance(tree);
+
+  // the store has to be visible before any node is read, which the seq_cst store and the re-check give
+  unsigned long epoch = atomic_load(&tree -> epoch);
+  atomic_store(&self -> state, epoch + 2);
+  while(atomic_load(&tree -> epoch) != epoch)
+  {
+    epoch = atomic_load(&tree -> epoch);
+    atomic_store(&self -> state, epoch + 2);
+  }
+
+  reclaim(self, epoch);
+}
+
+static void exitOperation (concurrent_thread *self) {
+  atomic_store(&self -> state, THREAD_IDLE);
+}
+
+// node is already unreachable from the root. it is tagged with the global epoch read now rather than the
+// one this thread entered in, which may be one behind: a search that entered after the advance could
+// still be standing on it
+static void retire (concurrent_thread *self, concurrent_node *node) {
+  unsigned long epoch = atomic_load(self -> epoch);
+  int i = epoch % 3;
+
+  // a list still sitting in this bucket is from three or more epochs ago
+  if(self -> limbo[i] && self -> limboEpoch[i] != epoch)
+  {
+    freeChain(self -> limbo[i]);
+    self -> limbo[i] = NULL;
+  }
+
+  node -> retiredNext = self -> limbo[i];
+  self -> limbo[i] = node;
+  self -> limboEpoch[i] = epoch;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// rebalancing, every function ending in Locked is called with the locks of the nodes it names held
+// and returns the next node that may need fixing (NULL when nothing is left)
+
+static int nodeCondition (concurrent_node *node) {
+  concurrent_node *left = atomic_load(&node -> left);
+  concurrent_node *right = atomic_load(&node -> right);
+
+  if((!left || !right) && !atomic_load(&node -> present)) return UNLINK_REQUIRED;
+
+  int hl = heightOf(left);
+  int hr = heightOf(right);
+  int balance = hl - hr;
+  if(balance < -1 || balance > 1) return REBALANCE_REQUIRED;
+
+  int height = 1 + max2(hl, hr);
+  return atomic_load(&node -> height) != height ? height : NOTHING_REQUIRED;
+}
+
+static concurrent_node *fixHeightLocked (concurrent_node *node) {
+  int condition = nodeCondition(node);
+
+  if(condition == UNLINK_REQUIRED || condition == REBALANCE_REQUIRED) return node;
+  if(condition == NOTHING_REQUIRED) return NULL;
+
+  atomic_store(&node -> height, condition);
+  return atomic_load(&node -> parent);
+}
+
+// splices out a routing node with at most one child
+static bool attemptUnlinkLocked (concurrent_thread *self, concurrent_node *parent, concurrent_node *node) {
+  concurrent_node *parentLeft = atomic_load(&parent -> left);
+  concurrent_node *parentRight = atomic_load(&parent -> right);
+  if(parentLeft != node && parentRight != node) return false;
+
+  concurrent_node *left = atomic_load(&node -> left);
+  concurrent_node *right = atomic_load(&node -> right);
+  if(left && right) return false;
+
+  concurrent_node *splice = left ? left : right;
+  if(parentLeft == node) atomic_store(&parent -> left, splice);
+  else atomic_store(&parent -> right, splice);
+  if(splice)
+  {
+    // same rule as the rotations, a parent pointer only changes under the child's lock
+    nodeLock(splice);
+    atomic_store(&splice -> parent, parent);
+    nodeUnlock(splice);
+  }
+
+  atomic_store(&node -> version, OVL_UNLINKED);
+  atomic_store(&node -> present, 0);
+  retire(self, node);
+  return true;
+}
+
+// the single rotations move node below its child, the heights handed in are the ones the caller
+// validated under the locks and the return value points at whichever node still looks damaged.
+// while something below is still damaged the new subtree root keeps the height parent was computed
+// from: whoever repairs the damage then finds a mismatch there and carries the change up to parent,
+// where storing the final height now would end that walk one level too early
+static concurrent_node *rotateRightLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *left,
+                                           int hr, int hll, concurrent_node *leftRight, int hlr) {
+  unsigned long version = atomic_load(&node -> version);
+  int hOld = atomic_load(&node -> height);
+  int hn = 1 + max2(hlr, hr);
+  int balance = hlr - hr;
+
+  concurrent_node *damaged = NULL;
+  if(balance < -1 || balance > 1 || ((!leftRight || hr == 0) && !atomic_load(&node -> present))) damaged = node;
+  else if(hll - hn < -1 || hll - hn > 1 || (hll == 0 && !atomic_load(&left -> present))) damaged = left;
+
+  atomic_store(&node -> version, beginChange(version));
+
+  atomic_store(&node -> left, leftRight);
+  if(leftRight) atomic_store(&leftRight -> parent, node);
+  atomic_store(&left -> right, node);
+  atomic_store(&node -> parent, left);
+  if(atomic_load(&parent -> left) == node) atomic_store(&parent -> left, left);
+  else atomic_store(&parent -> right, left);
+  atomic_store(&left -> parent, parent);
+
+  atomic_store(&node -> height, hn);
+  atomic_store(&left -> height, damaged ? hOld : 1 + max2(hll, hn));
+
+  atomic_store(&node -> version, endChange(version));
+
+  return damaged ? damaged : fixHeightLocked(parent);
+}
+
+static concurrent_node *rotateLeftLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *right,
+                                          int hl, int hrr, concurrent_node *rightLeft, int hrl) {
+  unsigned long version = atomic_load(&node -> version);
+  int hOld = atomic_load(&node -> height);
+  int hn = 1 + max2(hl, hrl);
+  int balance = hrl - hl;
+
+  concurrent_node *damaged = NULL;
+  if(balance < -1 || balance > 1 || ((!rightLeft || hl == 0) && !atomic_load(&node -> present))) damaged = node;
+  else if(hrr - hn < -1 || hrr - hn > 1 || (hrr == 0 && !atomic_load(&right -> present))) damaged = right;
+
+  atomic_store(&node -> version, beginChange(version));
+
+  atomic_store(&node -> right, rightLeft);
+  if(rightLeft) atomic_store(&rightLeft -> parent, node);
+  atomic_store(&right -> left, node);
+  atomic_store(&node -> parent, right);
+  if(atomic_load(&parent -> left) == node) atomic_store(&parent -> left, right);
+  else atomic_store(&parent -> right, right);
+  atomic_store(&right -> parent, parent);
+
+  atomic_store(&node -> height, hn);
+  atomic_store(&right -> height, damaged ? hOld : 1 + max2(hn, hrr));
+
+  atomic_store(&node -> version, endChange(version));
+
+  return damaged ? damaged : fixHeightLocked(parent);
+}
+
+// lr case in one step: leftRight rises above both left and node
+static concurrent_node *rotateRightOverLeftLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *left,
+                                                   int hr, int hll, concurrent_node *leftRight, int hlrl) {
+  unsigned long nodeVersion = atomic_load(&node -> version);
+  unsigned long leftVersion = atomic_load(&left -> version);
+  concurrent_node *lrl = atomic_load(&leftRight -> left);
+  concurrent_node *lrr = atomic_load(&leftRight -> right);
+  int hOld = atomic_load(&node -> height);
+  int hlrr = heightOf(lrr);
+  int hn = 1 + max2(hlrr, hr);
+  int hl = 1 + max2(hll, hlrl);
+  int balance = hlrr - hr;
+
+  concurrent_node *damaged = NULL;
+  if(balance < -1 || balance > 1 || ((!lrr || hr == 0) && !atomic_load(&node -> present))) damaged = node;
+  else if(hll - hlrl < -1 || hll - hlrl > 1 || ((hll == 0 || hlrl == 0) && !atomic_load(&left -> present))) damaged = left;
+  else if(hl - hn < -1 || hl - hn > 1) damaged = leftRight;
+
+  atomic_store(&node -> version, beginChange(nodeVersion));
+  atomic_store(&left -> version, beginChange(leftVersion));
+
+  atomic_store(&node -> left, lrr);
+  if(lrr) atomic_store(&lrr -> parent, node);
+  atomic_store(&left -> right, lrl);
+  if(lrl) atomic_store(&lrl -> parent, left);
+  atomic_store(&leftRight -> left, left);
+  atomic_store(&left -> parent, leftRight);
+  atomic_store(&leftRight -> right, node);
+  atomic_store(&node -> parent, leftRight);
+  if(atomic_load(&parent -> left) == node) atomic_store(&parent -> left, leftRight);
+  else atomic_store(&parent -> right, leftRight);
+  atomic_store(&leftRight -> parent, parent);
+
+  atomic_store(&node -> height, hn);
+  atomic_store(&left -> height, hl);
+  atomic_store(&leftRight -> height, damaged ? hOld : 1 + max2(hl, hn));
+
+  atomic_store(&node -> version, endChange(nodeVersion));
+  atomic_store(&left -> version, endChange(leftVersion));
+
+  return damaged ? damaged : fixHeightLocked(parent);
+}
+
+static concurrent_node *rotateLeftOverRightLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *right,
+                                                   int hl, int hrr, concurrent_node *rightLeft, int hrlr) {
+  unsigned long nodeVersion = atomic_load(&node -> version);
+  unsigned long rightVersion = atomic_load(&right -> version);
+  concurrent_node *rll = atomic_load(&rightLeft -> left);
+  concurrent_node *rlr = atomic_load(&rightLeft -> right);
+  int hOld = atomic_load(&node -> height);
+  int hrll = heightOf(rll);
+  int hn = 1 + max2(hl, hrll);
+  int hr = 1 + max2(hrlr, hrr);
+  int balance = hrll - hl;
+
+  concurrent_node *damaged = NULL;
+  if(balance < -1 || balance > 1 || ((!rll || hl == 0) && !atomic_load(&node -> present))) damaged = node;
+  else if(hrr - hrlr < -1 || hrr - hrlr > 1 || ((hrr == 0 || hrlr == 0) && !atomic_load(&right -> present))) damaged = right;
+  else if(hr - hn < -1 || hr - hn > 1) damaged = rightLeft;
+
+  atomic_store(&node -> version, beginChange(nodeVersion));
+  atomic_store(&right -> version, beginChange(rightVersion));
+
+  atomic_store(&node -> right, rll);
+  if(rll) atomic_store(&rll -> parent, node);
+  atomic_store(&right -> left, rlr);
+  if(rlr) atomic_store(&rlr -> parent, right);
+  atomic_store(&rightLeft -> right, right);
+  atomic_store(&right -> parent, rightLeft);
+  atomic_store(&rightLeft -> left, node);
+  atomic_store(&node -> parent, rightLeft);
+  if(atomic_load(&parent -> left) == node) atomic_store(&parent -> left, rightLeft);
+  else atomic_store(&parent -> right, rightLeft);
+  atomic_store(&rightLeft -> parent, parent);
+
+  atomic_store(&node -> height, hn);
+  atomic_store(&right -> height, hr);
+  atomic_store(&rightLeft -> height, damaged ? hOld : 1 + max2(hn, hr));
+
+  atomic_store(&node -> version, endChange(nodeVersion));
+  atomic_store(&right -> version, endChange(rightVersion));
+
+  return damaged ? damaged : fixHeightLocked(parent);
+}
+
+// node is left heavy, parent and node are locked. every node whose parent pointer a rotation rewrites is
+// locked first (always top down), a thread repairing its height reads the parent under that same lock
+// and so either walks up to the new parent or has finished before the rotation reads its height
+static concurrent_node *rebalanceToRightLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *left, int hr0) {
+  nodeLock(left);
+
+  // the heights were read without the lock on left, recheck them now that it cannot change
+  int hl = atomic_load(&left -> height);
+  if(hl - hr0 <= 1)
+  {
+    nodeUnlock(left);
+    return node;
+  }
+
+  concurrent_node *leftRight = atomic_load(&left -> right);
+  if(leftRight) nodeLock(leftRight);
+
+  int hll0 = heightOf(atomic_load(&left -> left));
+  int hlr = heightOf(leftRight);
+  if(hll0 >= hlr)
+  {
+    concurrent_node *next = rotateRightLocked(parent, node, left, hr0, hll0, leftRight, hlr);
+    if(leftRight) nodeUnlock(leftRight);
+    nodeUnlock(left);
+    return next;
+  }
+
+  // leftRight is the taller one so it rises two levels. whatever this leaves damaged (left becoming a
+  // routing node with one child, or a subtree whose heights were stale) is handed back to the walk
+  concurrent_node *lrl = atomic_load(&leftRight -> left);
+  concurrent_node *lrr = atomic_load(&leftRight -> right);
+  if(lrl) nodeLock(lrl);
+  if(lrr) nodeLock(lrr);
+
+  concurrent_node *next = rotateRightOverLeftLocked(parent, node, left, hr0, hll0, leftRight, heightOf(lrl));
+
+  if(lrr) nodeUnlock(lrr);
+  if(lrl) nodeUnlock(lrl);
+  nodeUnlock(leftRight);
+  nodeUnlock(left);
+  return next;
+}
+
+// node is right heavy, parent and node are locked
+static concurrent_node *rebalanceToLeftLocked (concurrent_node *parent, concurrent_node *node, concurrent_node *right, int hl0) {
+  nodeLock(right);
+
+  int hr = atomic_load(&right -> height);
+  if(hl0 - hr >= -1)
+  {
+    nodeUnlock(right);
+    return node;
+  }
+
+  concurrent_node *rightLeft = atomic_load(&right -> left);
+  if(rightLeft) nodeLock(rightLeft);
+
+  int hrr0 = heightOf(atomic_load(&right -> right));
+  int hrl = heightOf(rightLeft);
+  if(hrr0 >= hrl)
+  {
+    concurrent_node *next = rotateLeftLocked(parent, node, right, hl0, hrr0, rightLeft, hrl);
+    if(rightLeft) nodeUnlock(rightLeft);
+    nodeUnlock(right);
+    return next;
+  }
+
+  concurrent_node *rll = atomic_load(&rightLeft -> left);
+  concurrent_node *rlr = atomic_load(&rightLeft -> right);
+  if(rll) nodeLock(rll);
+  if(rlr) nodeLock(rlr);
+
+  concurrent_node *next = rotateLeftOverRightLocked(parent, node, right, hl0, hrr0, rightLeft, heightOf(rlr));
+
+  if(rlr) nodeUnlock(rlr);
+  if(rll) nodeUnlock(rll);
+  nodeUnlock(rightLeft);
+  nodeUnlock(right);
+  return next;
+}
+
+static concurrent_node *rebalanceLocked (concurrent_thread *self, concurrent_node *parent, concurrent_node *node) {
+  concurrent_node *left = atomic_load(&node -> left);
+  concurrent_node *right = atomic_load(&node -> right);
+
+  if((!left || !right) && !atomic_load(&node -> present))
+  {
+    if(attemptUnlinkLocked(self, parent, node)) return fixHeightLocked(parent);
+    return node;
+  }
+
+  int hl0 = heightOf(left);
+  int hr0 = heightOf(right);
+  int balance = hl0 - hr0;
+
+  if(balance > 1) return rebalanceToRightLocked(parent, node, left, hr0);
+  if(balance < -1) return rebalanceToLeftLocked(parent, node, right, hl0);
+
+  int height = 1 + max2(hl0, hr0);
+  if(atomic_load(&node -> height) != height)
+  {
+    atomic_store(&node -> height, height);
+    return fixHeightLocked(parent);
+  }
+
+  return NULL;
+}
+
+// walks up from node repairing heights, rotating and unlinking routing nodes until nothing is left to do,
+// the holder (the only node without a parent) ends the walk. the condition is always decided under the
+// node's lock: heights of children are written under their own locks only, so an unlocked look could miss
+// a child that changed right after another thread recomputed this node from the old value
+static void fixHeightAndRebalance (concurrent_thread *self, concurrent_node *node) {
+  while(node && atomic_load(&node -> parent))
+  {
+    if(atomic_load(&node -> version) == OVL_UNLINKED) return;
+
+    nodeLock(node);
+    int condition = nodeCondition(node);
+    if(condition == NOTHING_REQUIRED)
+    {
+      nodeUnlock(node);
+      return;
+    }
+    if(condition != UNLINK_REQUIRED && condition != REBALANCE_REQUIRED)
+    {
+      atomic_store(&node -> height, condition);
+      concurrent_node *next = atomic_load(&node -> parent);
+      nodeUnlock(node);
+      node = next;
+      continue;
+    }
+    nodeUnlock(node);
+
+    // rotations and unlinks change the parent's child pointer, its lock has to be taken first
+    concurrent_node *parent = atomic_load(&node -> parent);
+    nodeLock(parent);
+    if(atomic_load(&parent -> version) != OVL_UNLINKED && atomic_load(&node -> parent) == parent)
+    {
+      nodeLock(node);
+      concurrent_node *next = rebalanceLocked(self, parent, node);
+      nodeUnlock(node);
+      nodeUnlock(parent);
+      node = next;
+    }
+    else
+    {
+      nodeUnlock(parent);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// optimistic descents: node was reached with version nodeVersion and the search continues into its dir
+// side, a changed version means node may no longer cover key and the caller has to back up a level
+
+static int attemptGet (int key, concurrent_node *node, int dir, unsigned long nodeVersion) {
+  for (;;)
+  {
+    concurrent_node *child = childOf(node, dir);
+    if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+    if(!child) return 0;
+
+    int cmp = (key > child -> key) - (key < child -> key);
+    if(cmp == 0) return atomic_load(&child -> present);
+
+    unsigned long childVersion = atomic_load(&child -> version);
+    if(isShrinking(childVersion))
+    {
+      waitUntilNotChanging(child);
+    }
+    else if(childVersion != OVL_UNLINKED && child == childOf(node, dir))
+    {
+      if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+
+      int found = attemptGet(key, child, cmp, childVersion);
+      if(found != RETRY) return found;
+    }
+  }
+}
+
+static int attemptInsertLeaf (concurrent_thread *self, int key, concurrent_node *node, int dir, unsigned long nodeVersion) {
+  nodeLock(node);
+  if(atomic_load(&node -> version) != nodeVersion || childOf(node, dir))
+  {
+    nodeUnlock(node);
+    return RETRY;
+  }
+
+  concurrent_node *leaf = newNode(key, node);
+  if(!leaf)
+  {
+    nodeUnlock(node);
+    return 0;
+  }
+  if(dir < 0) atomic_store(&node -> left, leaf);
+  else atomic_store(&node -> right, leaf);
+  nodeUnlock(node);
+
+  fixHeightAndRebalance(self, node);
+  return 1;
+}
+
+// key is already in the tree as node, possibly as a routing node that only needs its flag back
+static int attemptRevive (concurrent_node *node) {
+  nodeLock(node);
+  if(atomic_load(&node -> version) == OVL_UNLINKED)
+  {
+    nodeUnlock(node);
+    return RETRY;
+  }
+
+  int added = !atomic_load(&node -> present);
+  atomic_store(&node -> present, 1);
+  nodeUnlock(node);
+
+  return added;
+}
+
+static int attemptInsert (concurrent_thread *self, int key, concurrent_node *node, int dir, unsigned long nodeVersion) {
+  int result;
+  do
+  {
+    result = RETRY;
+
+    concurrent_node *child = childOf(node, dir);
+    if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+
+    if(!child)
+    {
+      result = attemptInsertLeaf(self, key, node, dir, nodeVersion);
+      continue;
+    }
+
+    int cmp = (key > child -> key) - (key < child -> key);
+    if(cmp == 0)
+    {
+      result = attemptRevive(child);
+      continue;
+    }
+
+    unsigned long childVersion = atomic_load(&child -> version);
+    if(isShrinking(childVersion))
+    {
+      waitUntilNotChanging(child);
+    }
+    else if(childVersion != OVL_UNLINKED && child == childOf(node, dir))
+    {
+      if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+      result = attemptInsert(self, key, child, cmp, childVersion);
+    }
+  }while(result == RETRY);
+
+  return result;
+}
+
+// a node with two children is only marked absent, one with fewer is unlinked right away under the
+// locks of both it and its parent
+static int attemptRemoveNode (concurrent_thread *self, concurrent_node *parent, concurrent_node *node) {
+  if(!atomic_load(&node -> present)) return 0;
+
+  if(atomic_load(&node -> left) && atomic_load(&node -> right))
+  {
+    nodeLock(node);
+    if(atomic_load(&node -> version) == OVL_UNLINKED || !atomic_load(&node -> left) || !atomic_load(&node -> right))
+    {
+      nodeUnlock(node);
+      return RETRY;
+    }
+
+    int removed = atomic_load(&node -> present);
+    atomic_store(&node -> present, 0);
+    nodeUnlock(node);
+
+    return removed;
+  }
+
+  nodeLock(parent);
+  if(atomic_load(&parent -> version) == OVL_UNLINKED || atomic_load(&node -> parent) != parent ||
+     atomic_load(&node -> version) == OVL_UNLINKED)
+  {
+    nodeUnlock(parent);
+    return RETRY;
+  }
+
+  nodeLock(node);
+  if(!atomic_load(&node -> present))
+  {
+    nodeUnlock(node);
+    nodeUnlock(parent);
+    return 0;
+  }
+
+  atomic_store(&node -> present, 0);
+  if(!attemptUnlinkLocked(self, parent, node))
+  {
+    // it gained a second child since the check, it stays as a routing node instead
+    nodeUnlock(node);
+    nodeUnlock(parent);
+    return 1;
+  }
+  nodeUnlock(node);
+  nodeUnlock(parent);
+
+  fixHeightAndRebalance(self, parent);
+  return 1;
+}
+
+static int attemptDelete (concurrent_thread *self, int key, concurrent_node *node, int dir, unsigned long nodeVersion) {
+  int result;
+  do
+  {
+    result = RETRY;
+
+    concurrent_node *child = childOf(node, dir);
+    if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+
+    if(!child) return 0;
+
+    int cmp = (key > child -> key) - (key < child -> key);
+    if(cmp == 0)
+    {
+      result = attemptRemoveNode(self, node, child);
+      continue;
+    }
+
+    unsigned long childVersion = atomic_load(&child -> version);
+    if(isShrinking(childVersion))
+    {
+      waitUntilNotChanging(child);
+    }
+    else if(childVersion != OVL_UNLINKED && child == childOf(node, dir))
+    {
+      if(atomic_load(&node -> version) != nodeVersion) return RETRY;
+      result = attemptDelete(self, key, child, cmp, childVersion);
+    }
+  }while(result == RETRY);
+
+  return result;
+}
+
+// ---------------------------------------------------------------------------------------------------
+
+concurrent_avl *createConcurrentAvl (void) {
+  concurrent_avl *tree = malloc(sizeof(concurrent_avl));
+  if(!tree) return NULL;
+
+  atomic_init(&tree -> holder.left, NULL);
+  atomic_init(&tree -> holder.right, NULL);
+  atomic_init(&tree -> holder.parent, NULL);
+  atomic_init(&tree -> holder.version, 0);
+  atomic_init(&tree -> holder.height, 0);
+  atomic_init(&tree -> holder.present, 0);
+  pthread_mutex_init(&tree -> holder.lock, NULL);
+  tree -> holder.key = 0;
+  tree -> holder.retiredNext = NULL;
+
+  atomic_init(&tree -> epoch, 0);
+  for (int i = 0; i < CONCURRENT_MAX_THREADS; i++)
+  {
+    atomic_init(&tree -> threads[i].state, THREAD_FREE);
+    tree -> threads[i].epoch = &tree -> epoch;
+    for (int j = 0; j < 3; j++)
+    {
+      tree -> threads[i].limbo[j] = NULL;
+      tree -> threads[i].limboEpoch[j] = 0;
+    }
+    tree -> threads[i].ops = 0;
+  }
+
+  pthread_mutex_init(&tree -> orphanLock, NULL);
+  tree -> orphans = NULL;
+
+  return tree;
+}
+
+static void freeNodes (concurrent_node *node) {
+  while(node)
+  {
+    concurrent_node *right = atomic_load(&node -> right);
+    freeNodes(atomic_load(&node -> left));
+    pthread_mutex_destroy(&node -> lock);
+    free(node);
+    node = right;
+  }
+}
+
+void destroyConcurrentAvl (concurrent_avl *tree) {
+  if(!tree) return;
+
+  freeNodes(atomic_load(&tree -> holder.right));
+  for (int i = 0; i < CONCURRENT_MAX_THREADS; i++)
+  {
+    for (int j = 0; j < 3; j++) freeChain(tree -> threads[i].limbo[j]);
+  }
+  freeChain(tree -> orphans);
+
+  pthread_mutex_destroy(&tree -> holder.lock);
+  pthread_mutex_destroy(&tree -> orphanLock);
+  free(tree);
+}
+
+int concurrentRegisterThread (concurrent_avl *tree) {
+  for (int i = 0; i < CONCURRENT_MAX_THREADS; i++)
+  {
+    unsigned long expected = THREAD_FREE;
+    if(atomic_compare_exchange_strong(&tree -> threads[i].state, &expected, THREAD_IDLE)) return i;
+  }
+  return -1;
+}
+
+// whatever the thread still has in limbo is handed to the tree and freed when it is destroyed
+void concurrentUnregisterThread (concurrent_avl *tree, int slot) {
+  concurrent_thread *self = &tree -> threads[slot];
+
+  pthread_mutex_lock(&tree -> orphanLock);
+  for (int i = 0; i < 3; i++)
+  {
+    while(self -> limbo[i])
+    {
+      concurrent_node *node = self -> limbo[i];
+      self -> limbo[i] = node -> retiredNext;
+      node -> retiredNext = tree -> orphans;
+      tree -> orphans = node;
+    }
+  }
+  pthread_mutex_unlock(&tree -> orphanLock);
+
+  self -> ops = 0;
+  atomic_store(&self -> state, THREAD_FREE);
+}
+
+bool concurrentContains (concurrent_avl *tree, int slot, int key) {
+  concurrent_thread *self = &tree -> threads[slot];
+  int found;
+
+  enterOperation(tree, self);
+  do
+  {
+    found = attemptGet(key, &tree -> holder, 1, atomic_load(&tree -> holder.version));
+  }while(found == RETRY);
+  exitOperation(self);
+
+  return found;
+}
+
+bool concurrentInsert (concurrent_avl *tree, int slot, int key) {
+  concurrent_thread *self = &tree -> threads[slot];
+  int added;
+
+  enterOperation(tree, self);
+  do
+  {
+    added = attemptInsert(self, key, &tree -> holder, 1, atomic_load(&tree -> holder.version));
+  }while(added == RETRY);
+  exitOperation(self);
+
+  return added;
+}
+
+bool concurrentDelete (concurrent_avl *tree, int slot, int key) {
+  concurrent_thread *self = &tree -> threads[slot];
+  int removed;
+
+  enterOperation(tree, self);
+  do
+  {
+    removed = attemptDelete(self, key, &tree -> holder, 1, atomic_load(&tree -> holder.version));
+  }while(removed == RETRY);
+  exitOperation(self);
+
+  return removed;
+}
+
+static size_t countPresent (concurrent_node *node) {
+  size_t count = 0;
+  while(node)
+  {
+    count += atomic_load(&node -> present) + countPresent(atomic_load(&node -> left));
+    node = atomic_load(&node -> right);
+  }
+  return count;
+}
+
+size_t concurrentSize (concurrent_avl *tree) {
+  return countPresent(atomic_load(&tree -> holder.right));
+}
@@ -0,0 +1,229 @@
+#include "../include/cursor.h"
+
+static void pushLeftSpine (avl_cursor *cursor, binary_tree *node) {
+  while(node)
+  {
+    cursor -> path[cursor -> depth++] = node;
+    node = node -> left;
+  }
+}
+
+static void pushRightSpine (avl_cursor *cursor, binary_tree *node) {
+  while(node)
+  {
+    cursor -> path[cursor -> depth++] = node;
+    node = node -> right;
+  }
+}
+
+void cursorFirst (avl_cursor *cursor, binary_tree *root) {
+  cursor -> depth = 0;
+  pushLeftSpine(cursor, root);
+}
+
+void cursorLast (avl_cursor *cursor, binary_tree *root) {
+  cursor -> depth = 0;
+  pushRightSpine(cursor, root);
+}
+
+// the answer is always on the search path, so the cursor path is the search path cut at the last match
+static void seek (avl_cursor *cursor, binary_tree *root, int key, bool inclusive, bool upward) {
+  int best = 0;
+  cursor -> depth = 0;
+
+  while(root)
+  {
+    cursor -> path[cursor -> depth++] = root;
+
+    if(root -> data == key && inclusive)
+    {
+      best = cursor -> depth;
+      break;
+    }
+
+    if(upward)
+    {
+      if(root -> data > key)
+      {
+        best = cursor -> depth;
+        root = root -> left;
+      }
+      else root = root -> right;
+    }
+    else
+    {
+      if(root -> data < key)
+      {
+        best = cursor -> depth;
+        root = root -> right;
+      }
+      else root = root -> left;
+    }
+  }
+
+  cursor -> depth = best;
+}
+
+void cursorLowerBound (avl_cursor *cursor, binary_tree *root, int key) {
+  seek(cursor, root, key, true, true);
+}
+
+void cursorUpperBound (avl_cursor *cursor, binary_tree *root, int key) {
+  seek(cursor, root, key, false, true);
+}
+
+void cursorFloor (avl_cursor *cursor, binary_tree *root, int key) {
+  seek(cursor, root, key, true, false);
+}
+
+bool cursorValid (const avl_cursor *cursor) {
+  return cursor -> depth > 0;
+}
+
+binary_tree *cursorNode (const avl_cursor *cursor) {
+  return cursor -> depth ? cursor -> path[cursor -> depth - 1] : NULL;
+}
+
+int cursorKey (const avl_cursor *cursor) {
+  return cursor -> path[cursor -> depth - 1] -> data;
+}
+
+bool cursorNext (avl_cursor *cursor) {
+  if(!cursor -> depth) return false;
+
+  binary_tree *node = cursor -> path[cursor -> depth - 1];
+
+  // leftmost node of the right subtree, or else the first ancestor we are in the left subtree of
+  if(node -> right)
+  {
+    pushLeftSpine(cursor, node -> right);
+    return true;
+  }
+
+  while(--cursor -> depth > 0)
+  {
+    binary_tree *parent = cursor -> path[cursor -> depth - 1];
+    if(parent -> left == node) return true;
+    node = parent;
+  }
+
+  return false;
+}
+
+bool cursorPrev (avl_cursor *cursor) {
+  if(!cursor -> depth) return false;
+
+  binary_tree *node = cursor -> path[cursor -> depth - 1];
+
+  if(node -> left)
+  {
+    pushRightSpine(cursor, node -> left);
+    return true;
+  }
+
+  while(--cursor -> depth > 0)
+  {
+    binary_tree *parent = cursor -> path[cursor -> depth - 1];
+    if(parent -> right == node) return true;
+    node = parent;
+  }
+
+  return false;
+}
+
+// the point queries only need the best node, not a path
+bool floorAvlTree (binary_tree *root, int key, int *out) {
+  binary_tree *best = NULL;
+
+  while(root)
+  {
+    if(root -> data == key)
+    {
+      best = root;
+      break;
+    }
+    if(root -> data < key)
+    {
+      best = root;
+      root = root -> right;
+    }
+    else root = root -> left;
+  }
+
+  if(best) *out = best -> data;
+  return best != NULL;
+}
+
+bool ceilAvlTree (binary_tree *root, int key, int *out) {
+  binary_tree *best = NULL;
+
+  while(root)
+  {
+    if(root -> data == key)
+    {
+      best = root;
+      break;
+    }
+    if(root -> data > key)
+    {
+      best = root;
+      root = root -> left;
+    }
+    else root = root -> right;
+  }
+
+  if(best) *out = best -> data;
+  return best != NULL;
+}
+
+bool predecessorAvlTree (binary_tree *root, int key, int *out) {
+  binary_tree *best = NULL;
+
+  while(root)
+  {
+    if(root -> data < key)
+    {
+      best = root;
+      root = root -> right;
+    }
+    else root = root -> left;
+  }
+
+  if(best) *out = best -> data;
+  return best != NULL;
+}
+
+bool successorAvlTree (binary_tree *root, int key, int *out) {
+  binary_tree *best = NULL;
+
+  while(root)
+  {
+    if(root -> data > key)
+    {
+      best = root;
+      root = root -> left;
+    }
+    else root = root -> right;
+  }
+
+  if(best) *out = best -> data;
+  return best != NULL;
+}
+
+size_t rangeScanAvlTree (binary_tree *root, int lo, int hi, avl_visit visit, void *ctx) {
+  avl_cursor cursor;
+  size_t visited = 0;
+
+  if(lo > hi) return 0;
+
+  for (cursorLowerBound(&cursor, root, lo); cursorValid(&cursor); cursorNext(&cursor))
+  {
+    int key = cursorKey(&cursor);
+    if(key > hi) break;
+
+    visited++;
+    if(!visit(key, ctx)) break;
+  }
+
+  return visited;
+}
@@ -0,0 +1,167 @@
+#include "../include/finger.h"
+#include "../include/pool.h"
+#include "../include/stats.h"
+
+#include <limits.h>
+
+// the retrace after a hinted insert is the avl one and stores real heights
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "finger inserts need the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+void fingerReset (avl_finger *finger) {
+  finger -> depth = 0;
+}
+
+static void push (avl_finger *finger, binary_tree *node, long long lo, long long hi) {
+  finger -> path[finger -> depth] = node;
+  finger -> lo[finger -> depth] = lo;
+  finger -> hi[finger -> depth] = hi;
+  finger -> depth++;
+}
+
+// a finger left over from another tree (or from before the root changed) starts again at the root
+static void startAt (avl_finger *finger, binary_tree *root) {
+  if(finger -> depth && finger -> path[0] == root) return;
+
+  finger -> depth = 0;
+  push(finger, root, LLONG_MIN, LLONG_MAX);
+}
+
+// extends the finger from its last node towards key, the node holding key or NULL when the last node
+// on the finger is the one the key hangs under
+static binary_tree *descend (avl_finger *finger, int key) {
+  int last = finger -> depth - 1;
+  binary_tree *curr = finger -> path[last];
+  long long lo = finger -> lo[last];
+  long long hi = finger -> hi[last];
+  int steps = 1;
+
+  while(curr -> data != key)
+  {
+    binary_tree *next;
+
+    if(curr -> data < key)
+    {
+      lo = curr -> data;
+      next = curr -> right;
+    }
+    else
+    {
+      hi = curr -> data;
+      next = curr -> left;
+    }
+    if(!next) break;
+
+    push(finger, next, lo, hi);
+    curr = next;
+    steps++;
+  }
+  AVL_STAT_ADD(comparisons, 2 * steps);
+  AVL_STAT_ADD(pathLength, steps);
+
+  return curr -> data == key ? curr : NULL;
+}
+
+// hangs key under the last node on the finger and moves the finger onto it
+static binary_tree *attach (node_pool *pool, binary_tree *root, avl_finger *finger, int key) {
+  int last = finger -> depth - 1;
+  binary_tree *parent = finger -> path[last];
+  binary_tree *node = newTreeNode(pool, key);
+  bool rotated;
+  int stop;
+
+  if(!node) return root;
+  AVL_STAT_DEPTH(finger -> depth);
+
+  if(parent -> data < key)
+  {
+    parent -> right = node;
+    push(finger, node, parent -> data, finger -> hi[last]);
+  }
+  else
+  {
+    parent -> left = node;
+    push(finger, node, finger -> lo[last], parent -> data);
+  }
+
+  root = retraceInsertPath(root, finger -> path, finger -> depth - 1, &stop, &rotated);
+
+#if AVL_AUGMENT
+  // the subtrees above only gained key, folding it in is cheaper than recomputing from the children
+  // (those loads made this loop cost about as much as the whole descent)
+  for (int i = stop - 1; i >= 0; i--)
+  {
+    binary_tree *above = finger -> path[i];
+    above -> size++;
+    above -> agg.sum += key;
+    if(key < above -> agg.min) above -> agg.min = key;
+    if(key > above -> agg.max) above -> agg.max = key;
+  }
+#endif
+
+  // everything on the finger above a rotation is still in place
+  if(!rotated) return root;
+
+  // the rotated subtree covers the same key range as before, so the bounds at its level still hold
+  // and only the part below has to be walked again (a rotation low in the tree is the common case)
+  finger -> depth = stop + 1;
+  if(!stop) finger -> path[0] = root;
+  else
+  {
+    binary_tree *above = finger -> path[stop - 1];
+    finger -> path[stop] = above -> data < key ? above -> right : above -> left;
+  }
+  descend(finger, key);
+
+  return root;
+}
+
+binary_tree *insertAvlTreeHintedPool (node_pool *pool, binary_tree *root, avl_finger *finger, int key) {
+  AVL_STAT_ADD(inserts, 1);
+
+  if(!root)
+  {
+    root = newTreeNode(pool, key);
+    finger -> depth = 0;
+    if(root) push(finger, root, LLONG_MIN, LLONG_MAX);
+    return root;
+  }
+
+  startAt(finger, root);
+
+  // climb to the lowest subtree whose key range holds key, the root's range holds every key
+  while(finger -> depth > 1 && (key <= finger -> lo[finger -> depth - 1] || key >= finger -> hi[finger -> depth - 1]))
+    finger -> depth--;
+
+  if(descend(finger, key)) return root;
+  return attach(pool, root, finger, key);
+}
+
+binary_tree *insertAvlTreeHinted (binary_tree *root, avl_finger *finger, int key) {
+
+  return insertAvlTreeHintedPool(NULL, root, finger, key);
+
+}
+
+binary_tree *appendAvlTreePool (node_pool *pool, binary_tree *root, avl_finger *finger, int key) {
+  if(!root) return insertAvlTreeHintedPool(pool, root, finger, key);
+
+  startAt(finger, root);
+
+  // the maximum ends the right spine, which is the part of the finger with no upper bound
+  while(finger -> depth > 1 && finger -> hi[finger -> depth - 1] != LLONG_MAX) finger -> depth--;
+  for (binary_tree *last = finger -> path[finger -> depth - 1]; last -> right; last = last -> right)
+    push(finger, last -> right, last -> data, LLONG_MAX);
+
+  if(key <= finger -> path[finger -> depth - 1] -> data) return insertAvlTreeHintedPool(pool, root, finger, key);
+
+  AVL_STAT_ADD(inserts, 1);
+  return attach(pool, root, finger, key);
+}
+
+binary_tree *appendAvlTree (binary_tree *root, avl_finger *finger, int key) {
+
+  return appendAvlTreePool(NULL, root, finger, key);
+
+}
@@ -0,0 +1,357 @@
+// writer preferring rwlocks are a glibc extension, without them a steady stream of operations starves a resplit
+#define _GNU_SOURCE
+
+#include "../include/forest.h"
+#include "../include/join.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// resplits and merges go through split/join, which write real heights next to the policy's own inserts
+// and deletes in the same shard
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "the sharded forest needs the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+// a shard runs the hot check every this many of its operations
+#define FOREST_CHECK_PERIOD 4096
+
+static int compareInts (const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+// one cache line or more per shard, so two busy shards never share one
+static forest_shard *newShard (void) {
+  size_t size = (sizeof(forest_shard) + 63) & ~(size_t)63;
+  forest_shard *shard = aligned_alloc(64, size);
+  if(!shard) return NULL;
+
+  pthread_mutex_init(&shard -> lock, NULL);
+  shard -> root = NULL;
+  atomic_init(&shard -> hits, 0);
+  memset(shard -> recent, 0, sizeof(shard -> recent));
+
+  return shard;
+}
+
+static void freeShard (forest_shard *shard) {
+  freeTree(shard -> root);
+  pthread_mutex_destroy(&shard -> lock);
+  free(shard);
+}
+
+static void insertShardAt (sharded_forest *forest, int index, int lo, forest_shard *shard) {
+  for (int i = forest -> count; i > index; i--)
+  {
+    forest -> lo[i] = forest -> lo[i - 1];
+    forest -> shards[i] = forest -> shards[i - 1];
+  }
+  forest -> lo[index] = lo;
+  forest -> shards[index] = shard;
+  forest -> count++;
+}
+
+static void removeShardAt (sharded_forest *forest, int index) {
+  forest -> count--;
+  for (int i = index; i < forest -> count; i++)
+  {
+    forest -> lo[i] = forest -> lo[i + 1];
+    forest -> shards[i] = forest -> shards[i + 1];
+  }
+}
+
+sharded_forest *createShardedForest (int shards, const int *sample, size_t n) {
+  sharded_forest *forest = malloc(sizeof(sharded_forest));
+  if(!forest) return NULL;
+
+  if(shards < 1) shards = 1;
+  if(shards > FOREST_MAX_SHARDS) shards = FOREST_MAX_SHARDS;
+
+  int cuts[FOREST_MAX_SHARDS];
+  int count = 1;
+  cuts[0] = INT_MIN;
+
+  int *keys = n ? malloc(n * sizeof(int)) : NULL;
+  if(keys)
+  {
+    memcpy(keys, sample, n * sizeof(int));
+    qsort(keys, n, sizeof(int), compareInts);
+
+    size_t distinct = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+      if(!distinct || keys[i] != keys[distinct - 1]) keys[distinct++] = keys[i];
+    }
+
+    // shard i starts at the i/shards quantile, quantiles landing on the same key collapse
+    for (int i = 1; i < shards; i++)
+    {
+      int cut = keys[distinct * i / shards];
+      if(cut > cuts[count - 1]) cuts[count++] = cut;
+    }
+    free(keys);
+  }
+  else
+  {
+    for (int i = 1; i < shards; i++) cuts[count++] = (int)(INT_MIN + (4294967296LL * i) / shards);
+  }
+
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init(&attr);
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&forest -> tableLock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+
+  forest -> count = 0;
+  atomic_flag_clear(&forest -> resplitting);
+  forest -> resplits = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    forest_shard *shard = newShard();
+    if(!shard)
+    {
+      destroyShardedForest(forest);
+      return NULL;
+    }
+    insertShardAt(forest, i, cuts[i], shard);
+  }
+
+  return forest;
+}
+
+void destroyShardedForest (sharded_forest *forest) {
+  if(!forest) return;
+
+  for (int i = 0; i < forest -> count; i++) freeShard(forest -> shards[i]);
+  pthread_rwlock_destroy(&forest -> tableLock);
+  free(forest);
+}
+
+// last shard whose lower bound is <= key
+static int route (sharded_forest *forest, int key) {
+  int lo = 0, hi = forest -> count - 1;
+
+  while(lo < hi)
+  {
+    int mid = (lo + hi + 1) / 2;
+    if(forest -> lo[mid] <= key) lo = mid;
+    else hi = mid - 1;
+  }
+  return lo;
+}
+
+// index of a shard taking at least 1.5 times its share of the operations, -1 when the load is even enough.
+// a single shard is always hot, there is nothing to share its lock with
+static int hotShard (sharded_forest *forest) {
+  unsigned long total = 0, most = 0;
+  int hot = 0;
+
+  for (int i = 0; i < forest -> count; i++)
+  {
+    unsigned long hits = atomic_load_explicit(&forest -> shards[i] -> hits, memory_order_relaxed);
+    total += hits;
+    if(hits > most)
+    {
+      most = hits;
+      hot = i;
+    }
+  }
+
+  // the split point comes from the recent ring, which is only meaningful once it is full
+  if(most < FOREST_RECENT_KEYS) return -1;
+  if(forest -> count > 1 && 2 * most * forest -> count < 3 * total) return -1;
+  return hot;
+}
+
+// median of the keys the shard saw lately, moved up past its lower bound so both halves get some of them
+static bool pickSplit (sharded_forest *forest, int index, int *split) {
+  int keys[FOREST_RECENT_KEYS];
+
+  memcpy(keys, forest -> shards[index] -> recent, sizeof(keys));
+  qsort(keys, FOREST_RECENT_KEYS, sizeof(int), compareInts);
+
+  for (int i = FOREST_RECENT_KEYS / 2; i < FOREST_RECENT_KEYS; i++)
+  {
+    if(keys[i] > forest -> lo[index])
+    {
+      *split = keys[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+// every key of left is below every key of right, the minimum of right becomes the pivot
+static binary_tree *concatTrees (binary_tree *left, binary_tree *right) {
+  if(!left) return right;
+  if(!right) return left;
+
+  binary_tree *min = right;
+  while(min -> left) min = min -> left;
+
+  binary_tree *below, *pivot, *rest;
+  splitAvlTree(right, min -> data, &below, &pivot, &rest);
+  return joinAvlTree(left, pivot, rest);
+}
+
+// frees a slot by merging the coldest neighbouring pair, unless that pair is busy enough to become
+// the next hot spot. *hot follows the shift of the table
+static bool mergeColdest (sharded_forest *forest, int *hot) {
+  unsigned long coldest = ULONG_MAX;
+  int best = -1;
+
+  for (int i = 0; i + 1 < forest -> count; i++)
+  {
+    if(i == *hot || i + 1 == *hot) continue;
+
+    unsigned long hits = atomic_load_explicit(&forest -> shards[i] -> hits, memory_order_relaxed) +
+                         atomic_load_explicit(&forest -> shards[i + 1] -> hits, memory_order_relaxed);
+    if(hits < coldest)
+    {
+      coldest = hits;
+      best = i;
+    }
+  }
+
+  unsigned long hotHits = atomic_load_explicit(&forest -> shards[*hot] -> hits, memory_order_relaxed);
+  if(best < 0 || 2 * coldest > hotHits) return false;
+
+  forest_shard *left = forest -> shards[best];
+  forest_shard *right = forest -> shards[best + 1];
+  left -> root = concatTrees(left -> root, right -> root);
+  right -> root = NULL;
+  freeShard(right);
+  removeShardAt(forest, best + 1);
+
+  if(*hot > best) (*hot)--;
+  return true;
+}
+
+// called with the table held exclusively, so no shard is locked by anyone
+static bool splitShard (sharded_forest *forest, int hot) {
+  int split;
+
+  if(!pickSplit(forest, hot, &split)) return false;
+  if(forest -> count == FOREST_MAX_SHARDS && !mergeColdest(forest, &hot)) return false;
+
+  forest_shard *right = newShard();
+  if(!right) return false;
+
+  forest_shard *shard = forest -> shards[hot];
+  binary_tree *below, *found, *above;
+  splitAvlTree(shard -> root, split, &below, &found, &above);
+  shard -> root = below;
+  right -> root = found ? joinAvlTree(NULL, found, above) : above;
+  insertShardAt(forest, hot + 1, split, right);
+
+  return true;
+}
+
+bool forestResplit (sharded_forest *forest) {
+  // one resplit at a time, whoever loses the race just carries on
+  if(atomic_flag_test_and_set(&forest -> resplitting)) return false;
+  pthread_rwlock_wrlock(&forest -> tableLock);
+
+  int hot = hotShard(forest);
+  bool split = hot >= 0 && splitShard(forest, hot);
+  if(split) forest -> resplits++;
+
+  // counting starts over either way, a hot shard that could not be split is not retried right away
+  for (int i = 0; i < forest -> count; i++) atomic_store_explicit(&forest -> shards[i] -> hits, 0, memory_order_relaxed);
+
+  pthread_rwlock_unlock(&forest -> tableLock);
+  atomic_flag_clear(&forest -> resplitting);
+  return split;
+}
+
+// takes the table shared and locks the shard owning key, which also records the key for the hot check
+static forest_shard *enterShard (sharded_forest *forest, int key) {
+  pthread_rwlock_rdlock(&forest -> tableLock);
+  forest_shard *shard = forest -> shards[route(forest, key)];
+  pthread_mutex_lock(&shard -> lock);
+
+  unsigned long hits = atomic_load_explicit(&shard -> hits, memory_order_relaxed);
+  shard -> recent[hits % FOREST_RECENT_KEYS] = key;
+  atomic_store_explicit(&shard -> hits, hits + 1, memory_order_relaxed);
+
+  return shard;
+}
+
+static void leaveShard (sharded_forest *forest, forest_shard *shard) {
+  bool due = atomic_load_explicit(&shard -> hits, memory_order_relaxed) % FOREST_CHECK_PERIOD == 0;
+  pthread_mutex_unlock(&shard -> lock);
+
+  // a cheap look first, the table is only taken exclusively when a split is likely
+  due = due && hotShard(forest) >= 0;
+  pthread_rwlock_unlock(&forest -> tableLock);
+
+  if(due) forestResplit(forest);
+}
+
+bool forestContains (sharded_forest *forest, int key) {
+  forest_shard *shard = enterShard(forest, key);
+  binary_tree *node = shard -> root;
+
+  while(node && node -> data != key) node = key < node -> data ? node -> left : node -> right;
+
+  leaveShard(forest, shard);
+  return node != NULL;
+}
+
+void forestInsert (sharded_forest *forest, int key) {
+  forest_shard *shard = enterShard(forest, key);
+  shard -> root = insertAvlTree(shard -> root, key);
+  leaveShard(forest, shard);
+}
+
+void forestDelete (sharded_forest *forest, int key) {
+  forest_shard *shard = enterShard(forest, key);
+  shard -> root = deleteNodeAvlTree(shard -> root, key);
+  leaveShard(forest, shard);
+}
+
+typedef struct scan_state {
+  avl_visit visit;
+  void *ctx;
+  bool stopped;
+}scan_state;
+
+static bool scanVisit (int key, void *ctx) {
+  scan_state *state = ctx;
+  if(!state -> visit(key, state -> ctx)) state -> stopped = true;
+  return !state -> stopped;
+}
+
+size_t forestRangeScan (sharded_forest *forest, int lo, int hi, avl_visit visit, void *ctx) {
+  scan_state state = {visit, ctx, false};
+  size_t visited = 0;
+
+  if(lo > hi) return 0;
+
+  pthread_rwlock_rdlock(&forest -> tableLock);
+  for (int i = route(forest, lo); i < forest -> count && forest -> lo[i] <= hi && !state.stopped; i++)
+  {
+    forest_shard *shard = forest -> shards[i];
+    pthread_mutex_lock(&shard -> lock);
+    visited += rangeScanAvlTree(shard -> root, lo, hi, scanVisit, &state);
+    pthread_mutex_unlock(&shard -> lock);
+  }
+  pthread_rwlock_unlock(&forest -> tableLock);
+
+  return visited;
+}
+
+static size_t countNodes (binary_tree *node) {
+  if(!node) return 0;
+  return 1 + countNodes(node -> left) + countNodes(node -> right);
+}
+
+size_t forestSize (sharded_forest *forest) {
+  size_t size = 0;
+
+  for (int i = 0; i < forest -> count; i++) size += countNodes(forest -> shards[i] -> root);
+  return size;
+}
@@ -0,0 +1,282 @@
+#include "../include/image.h"
+#include "../include/tree.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HEADER_BYTES 64
+#define NODE_BYTES 12
+#define TRAILER_BYTES 4
+#define WRITE_NODES 4096
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+static const unsigned char magic[4] = {'A', 'V', 'L', 'I'};
+
+static uint32_t fnv1a (uint32_t hash, const unsigned char *bytes, size_t n) {
+  for (size_t i = 0; i < n; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+  return hash;
+}
+
+static void putLittleEndian (unsigned char *bytes, uint64_t value, int n) {
+  for (int i = 0; i < n; i++) bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t getLittleEndian (const unsigned char *bytes, int n) {
+  uint64_t value = 0;
+  for (int i = 0; i < n; i++) value |= (uint64_t)bytes[i] << (8 * i);
+  return value;
+}
+
+static uint64_t countNodes (binary_tree *root) {
+#if AVL_AUGMENT
+  return root ? (uint64_t)root -> size : 0;
+#else
+  if(!root) return 0;
+  return 1 + countNodes(root -> left) + countNodes(root -> right);
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------
+// writing
+
+typedef struct image_writer {
+  FILE *out;
+  unsigned char *buffer;
+  size_t used;
+  uint32_t next;
+  uint32_t checksum;
+  bool ok;
+}image_writer;
+
+static void flushWriter (image_writer *writer) {
+  writer -> checksum = fnv1a(writer -> checksum, writer -> buffer, writer -> used * NODE_BYTES);
+  if(writer -> used && fwrite(writer -> buffer, NODE_BYTES, writer -> used, writer -> out) != writer -> used)
+    writer -> ok = false;
+  writer -> used = 0;
+}
+
+// postorder, so both child indices are known by the time a node is written. returns the node's index
+static uint32_t writeSubtree (image_writer *writer, binary_tree *node) {
+  if(!node) return AVL_IMAGE_NONE;
+
+  uint32_t left = writeSubtree(writer, node -> left);
+  uint32_t right = writeSubtree(writer, node -> right);
+  unsigned char *record = writer -> buffer + writer -> used * NODE_BYTES;
+
+  putLittleEndian(record, (uint32_t)node -> data, 4);
+  putLittleEndian(record + 4, left, 4);
+  putLittleEndian(record + 8, right, 4);
+  if(++writer -> used == WRITE_NODES) flushWriter(writer);
+
+  return writer -> next++;
+}
+
+bool saveAvlImage (binary_tree *root, FILE *out) {
+  uint64_t count = countNodes(root);
+  unsigned char header[HEADER_BYTES] = {0};
+  unsigned char trailer[TRAILER_BYTES];
+
+  if(count >= AVL_IMAGE_NONE) return false;
+
+  memcpy(header, magic, 4);
+  putLittleEndian(header + 4, AVL_IMAGE_VERSION, 4);
+  putLittleEndian(header + 8, count, 8);
+  putLittleEndian(header + 16, root ? AVL_HEIGHT_BOUND(root -> height) : 0, 4);
+  putLittleEndian(header + 20, NODE_BYTES, 4);
+  if(fwrite(header, 1, HEADER_BYTES, out) != HEADER_BYTES) return false;
+
+  image_writer writer = {out, malloc(WRITE_NODES * NODE_BYTES), 0, 0, FNV_OFFSET, true};
+  if(!writer.buffer) return false;
+
+  writeSubtree(&writer, root);
+  flushWriter(&writer);
+  free(writer.buffer);
+
+  putLittleEndian(trailer, writer.checksum, 4);
+  return writer.ok && fwrite(trailer, 1, TRAILER_BYTES, out) == TRAILER_BYTES;
+}
+
+bool saveAvlImageFile (binary_tree *root, const char *path) {
+  FILE *out = fopen(path, "wb");
+  if(!out) return false;
+
+  bool ok = saveAvlImage(root, out);
+  return fclose(out) == 0 && ok;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// opening
+
+static bool littleEndianHost (void) {
+  const uint16_t probe = 1;
+  return *(const unsigned char *)&probe == 1;
+}
+
+avl_image *openAvlImage (const char *path) {
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) return NULL;
+
+  struct stat st;
+  void *base = MAP_FAILED;
+  if(!fstat(fd, &st) && st.st_size >= HEADER_BYTES + TRAILER_BYTES)
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED) return NULL;
+
+  // the header alone decides, the nodes are not touched so opening stays O(1)
+  const unsigned char *header = base;
+  uint64_t count = getLittleEndian(header + 8, 8);
+  uint64_t height = getLittleEndian(header + 16, 4);
+  avl_image *image = NULL;
+
+  if(littleEndianHost() && !memcmp(header, magic, 4) && getLittleEndian(header + 4, 4) == AVL_IMAGE_VERSION &&
+     getLittleEndian(header + 20, 4) == NODE_BYTES && count < AVL_IMAGE_NONE && height < AVL_MAX_HEIGHT &&
+     (uint64_t)st.st_size == HEADER_BYTES + count * NODE_BYTES + TRAILER_BYTES)
+    image = malloc(sizeof(avl_image));
+
+  if(!image)
+  {
+    munmap(base, st.st_size);
+    return NULL;
+  }
+
+  image -> base = base;
+  image -> length = st.st_size;
+  image -> nodes = (const image_node *)(header + HEADER_BYTES);
+  image -> count = (uint32_t)count;
+  image -> height = (uint32_t)height;
+  image -> checksum = (uint32_t)getLittleEndian(header + HEADER_BYTES + count * NODE_BYTES, 4);
+  return image;
+}
+
+void closeAvlImage (avl_image *image) {
+  if(!image) return;
+
+  munmap(image -> base, image -> length);
+  free(image);
+}
+
+// ---------------------------------------------------------------------------------------------------
+// reading in place
+
+// a link of a damaged image can point anywhere, anything past the end counts as no child
+static bool valid (const avl_image *image, uint32_t link) {
+  return link < image -> count;
+}
+
+bool imageContains (const avl_image *image, int key) {
+  uint32_t i = image -> count - 1;
+
+  for (uint32_t steps = 0; valid(image, i) && steps <= image -> height; steps++)
+  {
+    const image_node *node = image -> nodes + i;
+    if(node -> key == key) return true;
+    i = node -> key < key ? node -> right : node -> left;
+  }
+
+  return false;
+}
+
+bool imageFloor (const avl_image *image, int key, int *out) {
+  uint32_t i = image -> count - 1;
+  bool found = false;
+
+  for (uint32_t steps = 0; valid(image, i) && steps <= image -> height; steps++)
+  {
+    const image_node *node = image -> nodes + i;
+    if(node -> key <= key)
+    {
+      *out = node -> key;
+      found = true;
+      if(node -> key == key) break;
+      i = node -> right;
+    }
+    else i = node -> left;
+  }
+
+  return found;
+}
+
+size_t imageRangeScan (const avl_image *image, int lo, int hi, avl_visit visit, void *ctx) {
+  uint32_t stack[AVL_MAX_HEIGHT + 1];
+  int depth = 0;
+  size_t visited = 0;
+
+  if(lo > hi) return 0;
+
+  // the nodes at or above lo on its search path are, bottom up, the first keys to visit
+  for (uint32_t i = image -> count - 1; valid(image, i) && depth <= (int)image -> height;)
+  {
+    const image_node *node = image -> nodes + i;
+
+    if(node -> key >= lo)
+    {
+      stack[depth++] = i;
+      if(node -> key == lo) break;
+      i = node -> left;
+    }
+    else i = node -> right;
+  }
+
+  while(depth)
+  {
+    const image_node *node = image -> nodes + stack[--depth];
+    if(node -> key > hi) break;
+
+    visited++;
+    if(!visit(node -> key, ctx)) break;
+
+    // then the left spine of its right subtree
+    for (uint32_t i = node -> right; valid(image, i) && depth <= (int)image -> height; i = image -> nodes[i].left)
+      stack[depth++] = i;
+  }
+
+  return visited;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// verification
+
+bool verifyAvlImage (const avl_image *image) {
+  const unsigned char *bytes = (const unsigned char *)image -> nodes;
+  if(fnv1a(FNV_OFFSET, bytes, (size_t)image -> count * NODE_BYTES) != image -> checksum) return false;
+  if(!image -> count) return true;
+
+  // postorder puts every child before its parent, which also rules out cycles
+  for (uint32_t i = 0; i < image -> count; i++)
+  {
+    const image_node *node = image -> nodes + i;
+    if((node -> left != AVL_IMAGE_NONE && node -> left >= i) || (node -> right != AVL_IMAGE_NONE && node -> right >= i))
+      return false;
+  }
+
+  // in order the keys have to rise strictly and every node has to come up exactly once
+  uint32_t stack[AVL_MAX_HEIGHT + 1];
+  int depth = 0;
+  uint32_t seen = 0;
+  long long previous = (long long)INT32_MIN - 1;
+  uint32_t i = image -> count - 1;
+
+  while(i != AVL_IMAGE_NONE || depth)
+  {
+    for (; i != AVL_IMAGE_NONE; i = image -> nodes[i].left)
+    {
+      if(depth > (int)image -> height) return false;
+      stack[depth++] = i;
+    }
+
+    const image_node *node = image -> nodes + stack[--depth];
+    if(node -> key <= previous) return false;
+    previous = node -> key;
+    seen++;
+    i = node -> right;
+  }
+
+  return seen == image -> count;
+}
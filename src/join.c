@@ -0,0 +1,299 @@
+#include "../include/join.h"
+#include "../include/tree.h"
+#include "../include/pool.h"
+#include "../include/build.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// join, split and everything built on them compare and store real heights, not ranks
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "join/split and the set operations need the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+// below this height a subtree is merged on the current thread, a thread is not worth ~2^10 nodes
+#define PARALLEL_MIN_HEIGHT 10
+
+static int treeHeight (binary_tree *node) {
+  return node ? node -> height : -1;
+}
+
+static binary_tree *makeNode (binary_tree *left, binary_tree *pivot, binary_tree *right) {
+  pivot -> left = left;
+  pivot -> right = right;
+  updateNode(pivot);
+  return pivot;
+}
+
+// left is taller: walk down its right spine to a subtree of about right's height and hang right there,
+// the way back up fixes balance with the same rotations the insertion uses
+static binary_tree *joinRight (binary_tree *left, binary_tree *pivot, binary_tree *right) {
+  binary_tree *l = left -> left;
+  binary_tree *c = left -> right;
+
+  if(treeHeight(c) <= treeHeight(right) + 1)
+  {
+    makeNode(c, pivot, right);
+    makeNode(l, left, pivot);
+    if(pivot -> height <= treeHeight(l) + 1) return left;
+    return rlRotation(left, left);
+  }
+
+  makeNode(l, left, joinRight(c, pivot, right));
+  if(calculateBalanceFactor(left) >= -1) return left;
+  return rrRotation(left, left);
+}
+
+static binary_tree *joinLeft (binary_tree *left, binary_tree *pivot, binary_tree *right) {
+  binary_tree *c = right -> left;
+  binary_tree *r = right -> right;
+
+  if(treeHeight(c) <= treeHeight(left) + 1)
+  {
+    makeNode(left, pivot, c);
+    makeNode(pivot, right, r);
+    if(pivot -> height <= treeHeight(r) + 1) return right;
+    return lrRotation(right, right);
+  }
+
+  makeNode(joinLeft(left, pivot, c), right, r);
+  if(calculateBalanceFactor(right) <= 1) return right;
+  return llRotation(right, right);
+}
+
+binary_tree *joinAvlTree (binary_tree *left, binary_tree *pivot, binary_tree *right) {
+  int hl = treeHeight(left);
+  int hr = treeHeight(right);
+
+  if(hl > hr + 1) return joinRight(left, pivot, right);
+  if(hr > hl + 1) return joinLeft(left, pivot, right);
+  return makeNode(left, pivot, right);
+}
+
+// detaches the maximum node of root and returns the rest
+static binary_tree *splitLast (binary_tree *root, binary_tree **last) {
+  if(!root -> right)
+  {
+    *last = root;
+    return root -> left;
+  }
+
+  binary_tree *rest = splitLast(root -> right, last);
+  return joinAvlTree(root -> left, root, rest);
+}
+
+// join without a pivot, the maximum of left is borrowed for it
+static binary_tree *joinTwo (binary_tree *left, binary_tree *right) {
+  if(!left) return right;
+  if(!right) return left;
+
+  binary_tree *pivot = NULL;
+  left = splitLast(left, &pivot);
+  return joinAvlTree(left, pivot, right);
+}
+
+void splitAvlTree (binary_tree *root, int key, binary_tree **left, binary_tree **found, binary_tree **right) {
+  if(!root)
+  {
+    *left = *right = *found = NULL;
+    return;
+  }
+
+  binary_tree *l = root -> left;
+  binary_tree *r = root -> right;
+
+  if(root -> data == key)
+  {
+    *left = l;
+    *right = r;
+    root -> left = root -> right = NULL;
+    updateNode(root);
+    *found = root;
+  }
+  else if(key < root -> data)
+  {
+    binary_tree *lr = NULL;
+    splitAvlTree(l, key, left, found, &lr);
+    *right = joinAvlTree(lr, root, r);
+  }
+  else
+  {
+    binary_tree *rl = NULL;
+    splitAvlTree(r, key, &rl, found, right);
+    *left = joinAvlTree(l, root, rl);
+  }
+}
+
+binary_tree *extractRangeAvlTree (binary_tree *root, int lo, int hi, binary_tree **range) {
+  binary_tree *left, *loNode, *rest, *middle, *hiNode, *right;
+
+  if(lo > hi)
+  {
+    *range = NULL;
+    return root;
+  }
+
+  splitAvlTree(root, lo, &left, &loNode, &rest);
+  splitAvlTree(rest, hi, &middle, &hiNode, &right);
+
+  // the split keys themselves are part of the range, lo below all of middle and hi above it
+  if(loNode) middle = joinAvlTree(NULL, loNode, middle);
+  if(hiNode) middle = joinAvlTree(middle, hiNode, NULL);
+  *range = middle;
+
+  return joinTwo(left, right);
+}
+
+binary_tree *eraseRangeAvlTreePool (node_pool *pool, binary_tree *root, int lo, int hi) {
+  binary_tree *range;
+  root = extractRangeAvlTree(root, lo, hi, &range);
+  freeTreePool(pool, range);
+  return root;
+}
+
+binary_tree *eraseRangeAvlTree (binary_tree *root, int lo, int hi) {
+  return eraseRangeAvlTreePool(NULL, root, lo, hi);
+}
+
+
+// set operations
+
+typedef enum set_op { SET_UNION, SET_INTERSECT, SET_DIFFERENCE } set_op;
+
+typedef struct set_task {
+  node_pool *pool;
+  set_op op;
+  binary_tree *a;
+  binary_tree *b;
+  int forks;
+  binary_tree *result;
+}set_task;
+
+static binary_tree *setOperation (node_pool *pool, set_op op, binary_tree *a, binary_tree *b, int forks);
+
+static void *setTaskRun (void *arg) {
+  set_task *task = arg;
+  task -> result = setOperation(task -> pool, task -> op, task -> a, task -> b, task -> forks);
+  return NULL;
+}
+
+// runs the two recursive halves, the left one on a new thread while forks remain and both halves are big
+// enough. otherwise they run one after the other and keep the forks, so a big half can still fork further down
+static void setRecurse (node_pool *pool, set_op op, binary_tree *la, binary_tree *lb, binary_tree *ra,
+                        binary_tree *rb, int forks, binary_tree **left, binary_tree **right) {
+  int big = treeHeight(la) + treeHeight(lb) >= 2 * PARALLEL_MIN_HEIGHT &&
+            treeHeight(ra) + treeHeight(rb) >= 2 * PARALLEL_MIN_HEIGHT;
+  set_task task = {pool, op, la, lb, forks - 1, NULL};
+  pthread_t thread;
+
+  if(!pool && forks > 0 && big && !pthread_create(&thread, NULL, setTaskRun, &task))
+  {
+    *right = setOperation(pool, op, ra, rb, forks - 1);
+    pthread_join(thread, NULL);
+    *left = task.result;
+    return;
+  }
+
+  *left = setOperation(pool, op, la, lb, forks);
+  *right = setOperation(pool, op, ra, rb, forks);
+}
+
+static binary_tree *setOperation (node_pool *pool, set_op op, binary_tree *a, binary_tree *b, int forks) {
+  binary_tree *bl, *found, *br, *left, *right;
+
+  if(!a || !b)
+  {
+    if(op == SET_UNION) return a ? a : b;
+    if(op == SET_DIFFERENCE)
+    {
+      freeTreePool(pool, b);
+      return a;
+    }
+    freeTreePool(pool, a);
+    freeTreePool(pool, b);
+    return NULL;
+  }
+
+  // split the other tree around the root of a, then both sides are independent
+  splitAvlTree(b, a -> data, &bl, &found, &br);
+  binary_tree *al = a -> left;
+  binary_tree *ar = a -> right;
+
+  setRecurse(pool, op, al, bl, ar, br, forks, &left, &right);
+
+  switch(op)
+  {
+    case SET_UNION:
+      if(found) releaseTreeNode(pool, found);
+      return joinAvlTree(left, a, right);
+
+    case SET_INTERSECT:
+      if(!found)
+      {
+        releaseTreeNode(pool, a);
+        return joinTwo(left, right);
+      }
+      releaseTreeNode(pool, found);
+      return joinAvlTree(left, a, right);
+
+    default:
+      if(found)
+      {
+        releaseTreeNode(pool, found);
+        releaseTreeNode(pool, a);
+        return joinTwo(left, right);
+      }
+      return joinAvlTree(left, a, right);
+  }
+}
+
+// about two threads per core, each fork level doubles the thread count
+static int forkBudget (void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int forks = 1;
+
+  while((1L << forks) < 2 * cores && forks < 16) forks++;
+  return cores > 1 ? forks : 0;
+}
+
+binary_tree *unionAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b) {
+  return setOperation(pool, SET_UNION, a, b, pool ? 0 : forkBudget());
+}
+
+binary_tree *intersectAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b) {
+  return setOperation(pool, SET_INTERSECT, a, b, pool ? 0 : forkBudget());
+}
+
+binary_tree *differenceAvlTreePool (node_pool *pool, binary_tree *a, binary_tree *b) {
+  return setOperation(pool, SET_DIFFERENCE, a, b, pool ? 0 : forkBudget());
+}
+
+binary_tree *unionAvlTree (binary_tree *a, binary_tree *b) {
+  return unionAvlTreePool(NULL, a, b);
+}
+
+binary_tree *intersectAvlTree (binary_tree *a, binary_tree *b) {
+  return intersectAvlTreePool(NULL, a, b);
+}
+
+binary_tree *differenceAvlTree (binary_tree *a, binary_tree *b) {
+  return differenceAvlTreePool(NULL, a, b);
+}
+
+// when the batch tree cannot be built the keys go in or out one at a time, which needs no scratch memory
+binary_tree *insertKeysAvlTree (binary_tree *root, const int *keys, size_t n) {
+  binary_tree *batch = buildAvlFromUnsorted(keys, n);
+  if(batch || !n) return unionAvlTree(root, batch);
+
+  for (size_t i = 0; i < n; i++) root = insertAvlTree(root, keys[i]);
+  return root;
+}
+
+binary_tree *deleteKeysAvlTree (binary_tree *root, const int *keys, size_t n) {
+  binary_tree *batch = buildAvlFromUnsorted(keys, n);
+  if(batch || !n) return differenceAvlTree(root, batch);
+
+  for (size_t i = 0; i < n; i++) root = deleteNodeAvlTree(root, keys[i]);
+  return root;
+}
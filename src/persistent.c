@@ -0,0 +1,376 @@
+#include "../include/persistent.h"
+#include "../include/tree.h"
+
+#include <stdlib.h>
+
+#define READER_FREE 0
+#define READER_IDLE 1
+
+static int nodeHeight (const persistent_node *node) {
+  return node ? node -> height : -1;
+}
+
+static void updateHeight (persistent_node *node) {
+  int hl = nodeHeight(node -> left);
+  int hr = nodeHeight(node -> right);
+  node -> height = hl > hr ? hl + 1 : hr + 1;
+}
+
+static int balanceFactor (const persistent_node *node) {
+  return nodeHeight(node -> left) - nodeHeight(node -> right);
+}
+
+static persistent_node *newNode (int key, persistent_node *left, persistent_node *right) {
+  persistent_node *node = malloc(sizeof(persistent_node));
+  if(!node) return NULL;
+
+  node -> data = key;
+  node -> left = left;
+  node -> right = right;
+  node -> refs = 1;
+  updateHeight(node);
+
+  return node;
+}
+
+static void retain (persistent_node *node) {
+  if(node) node -> refs++;
+}
+
+// drops one reference, a node nobody points to anymore takes its children's references with it
+static void release (persistent_node *node) {
+  while(node && --node -> refs == 0)
+  {
+    persistent_node *right = node -> right;
+    release(node -> left);
+    free(node);
+    node = right;
+  }
+}
+
+// newNode for a copy on the path, it takes over one reference to each child. when out of memory it drops
+// them again and returns NULL
+static persistent_node *pathNode (int key, persistent_node *left, persistent_node *right) {
+  persistent_node *node = newNode(key, left, right);
+  if(node) return node;
+
+  release(left);
+  release(right);
+  return NULL;
+}
+
+// copy of node with both children shared, the copy is only reachable from the new version
+static persistent_node *copyNode (const persistent_node *node) {
+  retain(node -> left);
+  retain(node -> right);
+  return pathNode(node -> data, node -> left, node -> right);
+}
+
+// node is referenced from a fresh parent: a count of one means nothing else can see it and it may be
+// changed in place, otherwise the parent swaps its reference for a private copy. NULL when the copy could
+// not be made, node is left as it was
+static persistent_node *own (persistent_node *node) {
+  if(node -> refs == 1) return node;
+
+  persistent_node *copy = copyNode(node);
+  if(copy) node -> refs--;
+  return copy;
+}
+
+// the ll/rr rotations of src/tree.c on private nodes, children are made private before they are moved.
+// NULL when out of memory, nothing has moved then
+static persistent_node *rotateRight (persistent_node *root) {
+  persistent_node *newRoot = own(root -> left);
+  if(!newRoot) return NULL;
+
+  root -> left = newRoot -> right;
+  newRoot -> right = root;
+  updateHeight(root);
+  updateHeight(newRoot);
+
+  return newRoot;
+}
+
+static persistent_node *rotateLeft (persistent_node *root) {
+  persistent_node *newRoot = own(root -> right);
+  if(!newRoot) return NULL;
+
+  root -> right = newRoot -> left;
+  newRoot -> left = root;
+  updateHeight(root);
+  updateHeight(newRoot);
+
+  return newRoot;
+}
+
+// root is private, lr and rl are the two single rotations in a row. when a copy fails the whole new
+// subtree is released and NULL returned, a NULL root (from a failed pathNode) passes straight through
+static persistent_node *rebalance (persistent_node *root) {
+  if(!root) return NULL;
+
+  int factor = balanceFactor(root);
+  persistent_node *rotated = root;
+
+  updateHeight(root);
+
+  if(factor > 1)
+  {
+    persistent_node *left = root -> left;
+    if(balanceFactor(left) < 0)
+    {
+      // a private copy in place of the shared child keeps the subtree whole, so it can still be released
+      if((left = own(left))) root -> left = left;
+      if(left && (left = rotateLeft(left))) root -> left = left;
+    }
+    rotated = left ? rotateRight(root) : NULL;
+  }
+  else if(factor < -1)
+  {
+    persistent_node *right = root -> right;
+    if(balanceFactor(right) > 0)
+    {
+      if((right = own(right))) root -> right = right;
+      if(right && (right = rotateRight(right))) root -> right = right;
+    }
+    rotated = right ? rotateLeft(root) : NULL;
+  }
+
+  if(!rotated) release(root);
+  return rotated;
+}
+
+// the returned subtree carries one reference for the caller, *changed says whether a copy was made at all.
+// out of memory counts as no change: everything copied so far is released and node comes back as it was
+static persistent_node *insertPath (persistent_node *node, int key, bool *changed) {
+  if(!node)
+  {
+    persistent_node *leaf = newNode(key, NULL, NULL);
+    *changed = leaf != NULL;
+    return leaf;
+  }
+  if(key == node -> data)
+  {
+    *changed = false;
+    return node;
+  }
+
+  persistent_node *child = insertPath(key < node -> data ? node -> left : node -> right, key, changed);
+  if(!*changed) return node;
+
+  // the copy keeps the untouched side shared and points at the new child on the other
+  persistent_node *copy;
+  if(key < node -> data)
+  {
+    retain(node -> right);
+    copy = rebalance(pathNode(node -> data, child, node -> right));
+  }
+  else
+  {
+    retain(node -> left);
+    copy = rebalance(pathNode(node -> data, node -> left, child));
+  }
+
+  if(!copy)
+  {
+    *changed = false;
+    return node;
+  }
+  return copy;
+}
+
+// removes the minimum of node, its key goes to *min. *ok goes false when out of memory, nothing is left
+// to release then
+static persistent_node *deleteMin (persistent_node *node, int *min, bool *ok) {
+  if(!node -> left)
+  {
+    *min = node -> data;
+    retain(node -> right);
+    return node -> right;
+  }
+
+  persistent_node *left = deleteMin(node -> left, min, ok);
+  if(!*ok) return NULL;
+
+  retain(node -> right);
+  persistent_node *copy = rebalance(pathNode(node -> data, left, node -> right));
+  if(!copy) *ok = false;
+  return copy;
+}
+
+static persistent_node *deletePath (persistent_node *node, int key, bool *changed) {
+  if(!node)
+  {
+    *changed = false;
+    return NULL;
+  }
+
+  if(key != node -> data)
+  {
+    bool left = key < node -> data;
+    persistent_node *child = deletePath(left ? node -> left : node -> right, key, changed);
+    if(!*changed) return node;
+
+    retain(left ? node -> right : node -> left);
+    persistent_node *copy = rebalance(left ? pathNode(node -> data, child, node -> right) :
+                                             pathNode(node -> data, node -> left, child));
+    if(!copy)
+    {
+      *changed = false;
+      return node;
+    }
+    return copy;
+  }
+
+  *changed = true;
+
+  if(!node -> left || !node -> right)
+  {
+    persistent_node *child = node -> left ? node -> left : node -> right;
+    retain(child);
+    return child;
+  }
+
+  // two children: the successor's key moves into a copy of this node
+  int successor;
+  bool ok = true;
+  persistent_node *right = deleteMin(node -> right, &successor, &ok);
+  persistent_node *copy = NULL;
+  if(ok)
+  {
+    retain(node -> left);
+    copy = rebalance(pathNode(successor, node -> left, right));
+  }
+  if(!copy)
+  {
+    *changed = false;
+    return node;
+  }
+  return copy;
+}
+
+persistent_avl *createPersistentAvl (void) {
+  persistent_avl *tree = malloc(sizeof(persistent_avl));
+  if(!tree) return NULL;
+
+  atomic_init(&tree -> root, NULL);
+  atomic_init(&tree -> epoch, 0);
+  for (int i = 0; i < PERSISTENT_MAX_READERS; i++) atomic_init(&tree -> readers[i], READER_FREE);
+
+  pthread_mutex_init(&tree -> writeLock, NULL);
+  tree -> retired = NULL;
+  tree -> retiredCount = tree -> retiredCapacity = 0;
+
+  return tree;
+}
+
+// frees the retired versions no active reader can still be looking at
+static void reclaim (persistent_avl *tree) {
+  unsigned long oldest = (unsigned long)-1;
+
+  for (int i = 0; i < PERSISTENT_MAX_READERS; i++)
+  {
+    unsigned long state = atomic_load(&tree -> readers[i]);
+    if(state > READER_IDLE && state - 2 < oldest) oldest = state - 2;
+  }
+
+  // a reader that pinned in epoch e took its root after every version retired before e was replaced
+  size_t kept = 0;
+  for (size_t i = 0; i < tree -> retiredCount; i++)
+  {
+    if(tree -> retired[i].epoch < oldest) release(tree -> retired[i].root);
+    else tree -> retired[kept++] = tree -> retired[i];
+  }
+  tree -> retiredCount = kept;
+}
+
+static void publish (persistent_avl *tree, persistent_node *root) {
+  persistent_node *old = atomic_exchange(&tree -> root, root);
+  unsigned long epoch = atomic_fetch_add(&tree -> epoch, 1);
+
+  if(tree -> retiredCount == tree -> retiredCapacity)
+  {
+    size_t capacity = tree -> retiredCapacity ? 2 * tree -> retiredCapacity : 16;
+    retired_version *grown = realloc(tree -> retired, capacity * sizeof(retired_version));
+
+    // out of memory: keep the old version alive forever rather than free it under a reader
+    if(!grown) return;
+    tree -> retired = grown;
+    tree -> retiredCapacity = capacity;
+  }
+
+  tree -> retired[tree -> retiredCount].root = old;
+  tree -> retired[tree -> retiredCount].epoch = epoch;
+  tree -> retiredCount++;
+
+  reclaim(tree);
+}
+
+bool persistentInsert (persistent_avl *tree, int key) {
+  bool changed;
+
+  pthread_mutex_lock(&tree -> writeLock);
+  persistent_node *root = insertPath(atomic_load(&tree -> root), key, &changed);
+  if(changed) publish(tree, root);
+  pthread_mutex_unlock(&tree -> writeLock);
+
+  return changed;
+}
+
+bool persistentDelete (persistent_avl *tree, int key) {
+  bool changed;
+
+  pthread_mutex_lock(&tree -> writeLock);
+  persistent_node *root = deletePath(atomic_load(&tree -> root), key, &changed);
+  if(changed) publish(tree, root);
+  pthread_mutex_unlock(&tree -> writeLock);
+
+  return changed;
+}
+
+void destroyPersistentAvl (persistent_avl *tree) {
+  if(!tree) return;
+
+  for (size_t i = 0; i < tree -> retiredCount; i++) release(tree -> retired[i].root);
+  release(atomic_load(&tree -> root));
+
+  pthread_mutex_destroy(&tree -> writeLock);
+  free(tree -> retired);
+  free(tree);
+}
+
+int persistentRegisterReader (persistent_avl *tree) {
+  for (int i = 0; i < PERSISTENT_MAX_READERS; i++)
+  {
+    unsigned long expected = READER_FREE;
+    if(atomic_compare_exchange_strong(&tree -> readers[i], &expected, READER_IDLE)) return i;
+  }
+  return -1;
+}
+
+void persistentUnregisterReader (persistent_avl *tree, int slot) {
+  atomic_store(&tree -> readers[slot], READER_FREE);
+}
+
+const persistent_node *persistentReadBegin (persistent_avl *tree, int slot) {
+  // announce the epoch before loading the root (both sequentially consistent), see reclaim
+  atomic_store(&tree -> readers[slot], atomic_load(&tree -> epoch) + 2);
+  return atomic_load(&tree -> root);
+}
+
+void persistentReadEnd (persistent_avl *tree, int slot) {
+  atomic_store(&tree -> readers[slot], READER_IDLE);
+}
+
+bool persistentContains (const persistent_node *snapshot, int key) {
+  while(snapshot)
+  {
+    if(snapshot -> data == key) return true;
+    snapshot = key < snapshot -> data ? snapshot -> left : snapshot -> right;
+  }
+  return false;
+}
+
+size_t persistentCount (const persistent_node *snapshot) {
+  if(!snapshot) return 0;
+  return 1 + persistentCount(snapshot -> left) + persistentCount(snapshot -> right);
+}
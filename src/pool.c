@@ -0,0 +1,117 @@
+#include "../include/pool.h"
+#include "../include/tree.h"
+#include "../include/stats.h"
+
+#include <stdlib.h>
+
+#define POOL_DEFAULT_SLAB 1024
+#define POOL_MAX_SLAB (1 << 20)
+
+node_pool *createNodePool (size_t slabCapacity) {
+  node_pool *pool = malloc(sizeof(node_pool));
+  if(!pool) return NULL;
+
+  pool -> slabs = NULL;
+  pool -> freeList = NULL;
+  pool -> nextCapacity = slabCapacity ? slabCapacity : POOL_DEFAULT_SLAB;
+  pool -> liveNodes = 0;
+
+  return pool;
+}
+
+static node_slab *addSlab (node_pool *pool) {
+  size_t capacity = pool -> nextCapacity;
+
+  // header and nodes share one allocation so a slab costs a single free on teardown
+  node_slab *slab = malloc(sizeof(node_slab) + capacity * sizeof(binary_tree));
+  if(!slab) return NULL;
+
+  slab -> capacity = capacity;
+  slab -> used = 0;
+  slab -> nodes = (binary_tree *)(slab + 1);
+  slab -> next = pool -> slabs;
+  pool -> slabs = slab;
+
+  // growing geometrically keeps the slab count (and so the teardown cost) logarithmic in the tree size
+  if(capacity < POOL_MAX_SLAB) pool -> nextCapacity = capacity * 2;
+
+  return slab;
+}
+
+binary_tree *poolAllocNode (node_pool *pool) {
+  binary_tree *node = pool -> freeList;
+
+  // recycled nodes first, they are already warm in cache
+  if(node) pool -> freeList = node -> left;
+  else
+  {
+    node_slab *slab = pool -> slabs;
+    if(!slab || slab -> used == slab -> capacity) slab = addSlab(pool);
+    if(!slab) return NULL;
+    node = &slab -> nodes[slab -> used++];
+  }
+
+  pool -> liveNodes++;
+  return node;
+}
+
+void poolFreeNode (node_pool *pool, binary_tree *node) {
+  // no live node has a negative height, so a stale pointer (a lookup cache entry) can tell it is free
+  node -> height = -1;
+  node -> left = pool -> freeList;
+  pool -> freeList = node;
+  pool -> liveNodes--;
+}
+
+void resetNodePool (node_pool *pool) {
+  node_slab *keep = pool -> slabs;
+
+  // the newest slab is the biggest one, keep it and drop the rest
+  if(keep)
+  {
+    node_slab *slab = keep -> next;
+    while(slab)
+    {
+      node_slab *next = slab -> next;
+      free(slab);
+      slab = next;
+    }
+    keep -> next = NULL;
+    keep -> used = 0;
+  }
+
+  pool -> freeList = NULL;
+  pool -> liveNodes = 0;
+}
+
+void destroyNodePool (node_pool *pool) {
+  if(!pool) return;
+
+  node_slab *slab = pool -> slabs;
+  while(slab)
+  {
+    node_slab *next = slab -> next;
+    free(slab);
+    slab = next;
+  }
+
+  free(pool);
+}
+
+binary_tree *newTreeNode (node_pool *pool, int key) {
+  binary_tree *node = pool ? poolAllocNode(pool) : malloc(sizeof(binary_tree));
+  if(!node) return NULL;
+  AVL_STAT_ADD(allocs, 1);
+
+  node -> data = key;
+  node -> left = node -> right = NULL;
+  updateNode(node);
+
+  return node;
+}
+
+void releaseTreeNode (node_pool *pool, binary_tree *node) {
+  AVL_STAT_ADD(frees, 1);
+  if(pool) poolFreeNode(pool, node);
+  else free(node);
+}
@@ -1,39 +1,50 @@
 #include "../include/queue.h"
 
-void enQueue (queue **front, queue **rear, binary_tree *element) {
- 
-  // creating the new node despite the queue state
-  queue *node = malloc(sizeof(queue));
-  // check for memory allocation errors
-  if(!node) return;
-
-  node -> next = NULL;
-  node -> data = element;
-
-  // if queue is empty
-  if(! (*front)) {
-    *rear = *front = node;
-  } 
-  else {
-    (*rear) -> next = node;
-    *rear = node;
-  }
-};
-
-binary_tree *deQueue(queue **front, queue **rear) {
-  // if queue empty
-  if(!(*front)) return NULL;
-  // store the value
-  binary_tree *deQueued = (*front) -> data;
-
-  // store the front to free it later anyways
-  queue *temp = *front;
-
-  // updating front depending on the queue state (deleting front means the queue becomes empty or not)
-  if(*rear == *front) *rear = *front = NULL;
-  else *front = (*front) -> next;
-
-  free(temp);
-
-  return deQueued;
-}
\ No newline at end of file
+#include <stdlib.h>
+#include <string.h>
+
+void queueInit (queue *q) {
+  q -> slots = q -> inlineSlots;
+  q -> capacity = QUEUE_INLINE_SLOTS;
+  q -> head = 0;
+  q -> count = 0;
+}
+
+void queueFree (queue *q) {
+  if(q -> slots != q -> inlineSlots) free(q -> slots);
+  queueInit(q);
+}
+
+// doubles the ring, unwrapping it so the live slots start at 0 again
+static bool grow (queue *q) {
+  binary_tree **slots = malloc(2 * q -> capacity * sizeof(binary_tree *));
+  if(!slots) return false;
+
+  size_t first = q -> capacity - q -> head;
+  if(first > q -> count) first = q -> count;
+  memcpy(slots, q -> slots + q -> head, first * sizeof(binary_tree *));
+  memcpy(slots + first, q -> slots, (q -> count - first) * sizeof(binary_tree *));
+
+  if(q -> slots != q -> inlineSlots) free(q -> slots);
+  q -> slots = slots;
+  q -> capacity *= 2;
+  q -> head = 0;
+  return true;
+}
+
+bool enQueue (queue *q, binary_tree *element) {
+  if(q -> count == q -> capacity && !grow(q)) return false;
+
+  q -> slots[(q -> head + q -> count) & (q -> capacity - 1)] = element;
+  q -> count++;
+  return true;
+}
+
+binary_tree *deQueue (queue *q) {
+  if(!q -> count) return NULL;
+
+  binary_tree *element = q -> slots[q -> head];
+  q -> head = (q -> head + 1) & (q -> capacity - 1);
+  q -> count--;
+  return element;
+}
@@ -0,0 +1,293 @@
+#include "../include/serialize.h"
+#include "../include/tree.h"
+#include "../include/pool.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// loading rebuilds the tree with real heights
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "serialize needs the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+#define IO_BUFFER 65536
+#define HEADER_BYTES 16
+
+// adler-32: the largest prime below 2^16, and how many bytes fit before the sums could overflow 32 bits
+#define ADLER_MOD 65521
+#define ADLER_NMAX 5552
+
+static const unsigned char magic[4] = {'A', 'V', 'L', 'K'};
+
+static uint32_t adler32 (uint32_t adler, const unsigned char *bytes, size_t n) {
+  uint32_t a = adler & 0xffff;
+  uint32_t b = adler >> 16;
+
+  while(n)
+  {
+    size_t chunk = n < ADLER_NMAX ? n : ADLER_NMAX;
+    for (size_t i = 0; i < chunk; i++)
+    {
+      a += bytes[i];
+      b += a;
+    }
+    a %= ADLER_MOD;
+    b %= ADLER_MOD;
+    bytes += chunk;
+    n -= chunk;
+  }
+
+  return b << 16 | a;
+}
+
+static void putLittleEndian (unsigned char *bytes, uint64_t value, int n) {
+  for (int i = 0; i < n; i++) bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t getLittleEndian (const unsigned char *bytes, int n) {
+  uint64_t value = 0;
+  for (int i = 0; i < n; i++) value |= (uint64_t)bytes[i] << (8 * i);
+  return value;
+}
+
+#if AVL_AUGMENT
+static uint64_t countKeys (binary_tree *root) {
+  return root ? (uint64_t)root -> size : 0;
+}
+#else
+static uint64_t countKeys (binary_tree *root) {
+  if(!root) return 0;
+  return 1 + countKeys(root -> left) + countKeys(root -> right);
+}
+#endif
+
+// ---------------------------------------------------------------------------------------------------
+// writing
+
+typedef struct tree_writer {
+  FILE *out;
+  size_t used;
+  uint32_t checksum;
+  bool ok;
+  unsigned char buffer[IO_BUFFER];
+}tree_writer;
+
+static void flushWriter (tree_writer *writer) {
+  writer -> checksum = adler32(writer -> checksum, writer -> buffer, writer -> used);
+  if(writer -> used && fwrite(writer -> buffer, 1, writer -> used, writer -> out) != writer -> used) writer -> ok = false;
+  writer -> used = 0;
+}
+
+static void putVarint (tree_writer *writer, uint32_t value) {
+  if(writer -> used > IO_BUFFER - 5) flushWriter(writer);
+
+  unsigned char *out = writer -> buffer + writer -> used;
+  while(value >= 0x80)
+  {
+    *out++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (unsigned char)value;
+  writer -> used = out - writer -> buffer;
+}
+
+bool saveAvlTree (binary_tree *root, FILE *out) {
+  tree_writer *writer = malloc(sizeof(tree_writer));
+  if(!writer) return false;
+
+  writer -> out = out;
+  writer -> used = HEADER_BYTES;
+  writer -> checksum = 1;
+  writer -> ok = true;
+
+  for (int i = 0; i < 4; i++) writer -> buffer[i] = magic[i];
+  putLittleEndian(writer -> buffer + 4, AVL_FORMAT_VERSION, 4);
+  putLittleEndian(writer -> buffer + 8, countKeys(root), 8);
+
+  // in order walk with the left spine on a stack, the previous key starts one below INT_MIN
+  binary_tree *stack[AVL_MAX_HEIGHT];
+  int depth = 0;
+  long long prev = INT_MIN - 1LL;
+
+  while(root || depth)
+  {
+    while(root)
+    {
+      stack[depth++] = root;
+      root = root -> left;
+    }
+
+    binary_tree *node = stack[--depth];
+    putVarint(writer, (uint32_t)(node -> data - prev - 1));
+    prev = node -> data;
+    root = node -> right;
+  }
+  flushWriter(writer);
+
+  unsigned char trailer[4];
+  putLittleEndian(trailer, writer -> checksum, 4);
+  bool ok = writer -> ok && fwrite(trailer, 1, 4, out) == 4 && fflush(out) == 0;
+
+  free(writer);
+  return ok;
+}
+
+bool saveAvlTreeFile (binary_tree *root, const char *path) {
+  FILE *out = fopen(path, "wb");
+  if(!out) return false;
+
+  bool ok = saveAvlTree(root, out);
+  return fclose(out) == 0 && ok;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// loading
+
+typedef struct tree_reader {
+  FILE *in;
+  node_pool *pool;
+  size_t pos;
+  size_t end;
+  // bytes before this offset of the buffer are already in the checksum, summing stops at the trailer
+  size_t summed;
+  bool summing;
+  uint32_t checksum;
+  long long prev;
+  bool ok;
+  unsigned char buffer[IO_BUFFER];
+}tree_reader;
+
+static bool refill (tree_reader *reader) {
+  if(reader -> summing) reader -> checksum = adler32(reader -> checksum, reader -> buffer + reader -> summed, reader -> end - reader -> summed);
+
+  reader -> pos = reader -> summed = 0;
+  reader -> end = fread(reader -> buffer, 1, IO_BUFFER, reader -> in);
+  return reader -> end > 0;
+}
+
+// -1 at the end of the stream
+static int getByte (tree_reader *reader) {
+  if(reader -> pos == reader -> end && !refill(reader)) return -1;
+  return reader -> buffer[reader -> pos++];
+}
+
+// a corrupt or short stream clears ok and returns 0, loadRange stops building as soon as it sees that
+// and frees what it already has
+static int nextKey (tree_reader *reader) {
+  uint32_t value = 0;
+
+  for (int shift = 0; shift < 35; shift += 7)
+  {
+    int byte = getByte(reader);
+    if(byte < 0) break;
+
+    value |= (uint32_t)(byte & 0x7f) << shift;
+    if(byte & 0x80) continue;
+
+    // the fifth byte only has room for the top 4 bits
+    long long key = reader -> prev + 1 + value;
+    if((shift == 28 && byte > 0x0f) || key > INT_MAX) break;
+
+    reader -> prev = key;
+    return (int)key;
+  }
+
+  reader -> ok = false;
+  return 0;
+}
+
+// the keys arrive in order, so the left subtree is built first, then the node, then the right subtree,
+// split the way buildRange splits a sorted array
+static binary_tree *loadRange (tree_reader *reader, uint64_t n) {
+  if(!n || !reader -> ok) return NULL;
+
+  binary_tree *left = loadRange(reader, n / 2);
+  int key = nextKey(reader);
+  binary_tree *node = reader -> ok ? newTreeNode(reader -> pool, key) : NULL;
+  if(!node)
+  {
+    reader -> ok = false;
+    freeTreePool(reader -> pool, left);
+    return NULL;
+  }
+
+  node -> left = left;
+  node -> right = loadRange(reader, n - n / 2 - 1);
+  updateNode(node);
+  return node;
+}
+
+bool loadAvlTreePool (node_pool *pool, FILE *in, binary_tree **root) {
+  *root = NULL;
+
+  tree_reader *reader = malloc(sizeof(tree_reader));
+  if(!reader) return false;
+
+  reader -> in = in;
+  reader -> pool = pool;
+  reader -> pos = reader -> end = reader -> summed = 0;
+  reader -> summing = true;
+  reader -> checksum = 1;
+  reader -> prev = INT_MIN - 1LL;
+  reader -> ok = true;
+
+  unsigned char header[HEADER_BYTES];
+  for (int i = 0; i < HEADER_BYTES; i++)
+  {
+    int byte = getByte(reader);
+    if(byte < 0) reader -> ok = false;
+    header[i] = (unsigned char)byte;
+  }
+
+  // there are at most 2^32 distinct int keys
+  uint64_t count = getLittleEndian(header + 8, 8);
+  for (int i = 0; i < 4; i++)
+  {
+    if(header[i] != magic[i]) reader -> ok = false;
+  }
+  if(getLittleEndian(header + 4, 4) != AVL_FORMAT_VERSION || count > (uint64_t)UINT32_MAX + 1) reader -> ok = false;
+
+  binary_tree *tree = loadRange(reader, count);
+
+  // everything up to here is covered by the checksum, the trailer itself is not
+  reader -> checksum = adler32(reader -> checksum, reader -> buffer + reader -> summed, reader -> pos - reader -> summed);
+  reader -> summing = false;
+
+  unsigned char trailer[4];
+  for (int i = 0; i < 4; i++)
+  {
+    int byte = getByte(reader);
+    if(byte < 0) reader -> ok = false;
+    trailer[i] = (unsigned char)byte;
+  }
+
+  bool ok = reader -> ok && getLittleEndian(trailer, 4) == reader -> checksum;
+  free(reader);
+
+  if(!ok)
+  {
+    freeTreePool(pool, tree);
+    return false;
+  }
+
+  *root = tree;
+  return true;
+}
+
+bool loadAvlTree (FILE *in, binary_tree **root) {
+  return loadAvlTreePool(NULL, in, root);
+}
+
+bool loadAvlTreeFile (const char *path, binary_tree **root) {
+  FILE *in = fopen(path, "rb");
+  if(!in)
+  {
+    *root = NULL;
+    return false;
+  }
+
+  bool ok = loadAvlTree(in, root);
+  fclose(in);
+  return ok;
+}
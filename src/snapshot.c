@@ -0,0 +1,85 @@
+#include "../include/snapshot.h"
+#include "../include/tree.h"
+#include "../include/cursor.h"
+
+#include <stdlib.h>
+
+#define CACHE_LINE 64
+
+// an inorder walk over the eytzinger slots, fed from an inorder cursor over the tree
+static void fillSlots (int *keys, size_t n, size_t k, avl_cursor *cursor) {
+  if(k > n) return;
+
+  fillSlots(keys, n, 2 * k, cursor);
+  keys[k] = cursorKey(cursor);
+  cursorNext(cursor);
+  fillSlots(keys, n, 2 * k + 1, cursor);
+}
+
+static size_t countNodes (binary_tree *root) {
+#if AVL_AUGMENT
+  return root ? (size_t)root -> size : 0;
+#else
+  return root ? 1 + countNodes(root -> left) + countNodes(root -> right) : 0;
+#endif
+}
+
+avl_snapshot *freezeAvlTree (binary_tree *root) {
+  avl_snapshot *snapshot = malloc(sizeof(avl_snapshot));
+  if(!snapshot) return NULL;
+
+  snapshot -> n = countNodes(root);
+
+  // aligned_alloc wants a multiple of the alignment
+  size_t bytes = (snapshot -> n + 1) * sizeof(int);
+  bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+  snapshot -> keys = aligned_alloc(CACHE_LINE, bytes);
+  if(!snapshot -> keys)
+  {
+    free(snapshot);
+    return NULL;
+  }
+
+  avl_cursor cursor;
+  cursorFirst(&cursor, root);
+  fillSlots(snapshot -> keys, snapshot -> n, 1, &cursor);
+
+  return snapshot;
+}
+
+void freeSnapshot (avl_snapshot *snapshot) {
+  if(!snapshot) return;
+  free(snapshot -> keys);
+  free(snapshot);
+}
+
+// slot of the smallest key >= key, 0 when there is none
+static size_t lowerBoundSlot (const avl_snapshot *snapshot, int key) {
+  const int *keys = snapshot -> keys;
+  size_t n = snapshot -> n;
+  size_t k = 1;
+
+  while(k <= n)
+  {
+    // slot 16k is four levels down, one cache line holds all 16 of its descendants there
+    __builtin_prefetch(keys + 16 * k);
+    k = 2 * k + (keys[k] < key);
+  }
+
+  // every right turn appended a 1 bit, the answer is where the last left turn happened
+  k >>= __builtin_ctzll(~(unsigned long long)k) + 1;
+  return k;
+}
+
+bool snapshotLowerBound (const avl_snapshot *snapshot, int key, int *out) {
+  size_t k = lowerBoundSlot(snapshot, key);
+  if(!k) return false;
+
+  *out = snapshot -> keys[k];
+  return true;
+}
+
+bool snapshotContains (const avl_snapshot *snapshot, int key) {
+  size_t k = lowerBoundSlot(snapshot, key);
+  return k && snapshot -> keys[k] == key;
+}
@@ -0,0 +1,96 @@
+#include "../include/stats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if AVL_STATS
+
+// one block of counters per thread that ever updated a tree, linked so a read can find them all
+typedef struct stat_slot {
+  _Atomic uint64_t counters[AVL_STAT_COUNTERS];
+  struct stat_slot *prev;
+  struct stat_slot *next;
+}stat_slot;
+
+_Thread_local _Atomic uint64_t *avlThreadCounters;
+
+static pthread_mutex_t slotsLock = PTHREAD_MUTEX_INITIALIZER;
+static stat_slot *slots;
+// what the threads that exited had counted, only touched under slotsLock
+static uint64_t retired[AVL_STAT_COUNTERS];
+
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t exitKey;
+
+// runs on the exiting thread: its counts move to retired and its slot goes away
+static void retireSlot (void *arg) {
+  stat_slot *slot = arg;
+
+  pthread_mutex_lock(&slotsLock);
+  for (size_t i = 0; i < AVL_STAT_COUNTERS; i++) retired[i] += atomic_load_explicit(&slot -> counters[i], memory_order_relaxed);
+  if(slot -> prev) slot -> prev -> next = slot -> next;
+  else slots = slot -> next;
+  if(slot -> next) slot -> next -> prev = slot -> prev;
+  pthread_mutex_unlock(&slotsLock);
+
+  avlThreadCounters = NULL;
+  free(slot);
+}
+
+static void createExitKey (void) {
+  pthread_key_create(&exitKey, retireSlot);
+}
+
+// the slow path of the first update on a thread, NULL (and the update dropped) when out of memory
+_Atomic uint64_t *avlStatsRegisterThread (void) {
+  stat_slot *slot = calloc(1, sizeof(stat_slot));
+  if(!slot) return NULL;
+
+  pthread_once(&keyOnce, createExitKey);
+  pthread_setspecific(exitKey, slot);
+
+  pthread_mutex_lock(&slotsLock);
+  slot -> next = slots;
+  if(slots) slots -> prev = slot;
+  slots = slot;
+  pthread_mutex_unlock(&slotsLock);
+
+  avlThreadCounters = slot -> counters;
+  return avlThreadCounters;
+}
+
+void avlStatsRead (avl_stats *out) {
+  uint64_t sum[AVL_STAT_COUNTERS];
+
+  pthread_mutex_lock(&slotsLock);
+  memcpy(sum, retired, sizeof(sum));
+  for (stat_slot *slot = slots; slot; slot = slot -> next)
+  {
+    for (size_t i = 0; i < AVL_STAT_COUNTERS; i++) sum[i] += atomic_load_explicit(&slot -> counters[i], memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&slotsLock);
+
+  memcpy(out, sum, sizeof(avl_stats));
+}
+
+void avlStatsReset (void) {
+  pthread_mutex_lock(&slotsLock);
+  memset(retired, 0, sizeof(retired));
+  for (stat_slot *slot = slots; slot; slot = slot -> next)
+  {
+    for (size_t i = 0; i < AVL_STAT_COUNTERS; i++) atomic_store_explicit(&slot -> counters[i], 0, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&slotsLock);
+}
+
+#else
+
+void avlStatsRead (avl_stats *out) {
+  memset(out, 0, sizeof(avl_stats));
+}
+
+void avlStatsReset (void) {
+}
+
+#endif
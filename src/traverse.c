@@ -0,0 +1,479 @@
+#include "../include/traverse.h"
+#include "../include/queue.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// a deque only ever holds right children of distinct nodes on its thread's current path, so one slot
+// per tree level is enough. a push into a full deque is walked in place instead
+#define DEQUE_SLOTS 64
+
+typedef struct walk_deque {
+  pthread_mutex_t lock;
+  binary_tree *tasks[DEQUE_SLOTS];   // a ring, the oldest task at head
+  unsigned head;
+  unsigned count;
+}walk_deque;
+
+typedef struct walk_shared {
+  avl_par_visit visit;
+  void *ctx;
+  int threads;
+  walk_deque *deques;
+  char *accs;
+  size_t accSize;
+  atomic_long pending;     // tasks pushed and not finished, the walk is over at 0
+  atomic_long queued;      // tasks sitting in a deque, what an idle thread waits for
+  atomic_int sleepers;     // threads parked on wake
+  pthread_mutex_t idle;
+  pthread_cond_t wake;
+}walk_shared;
+
+// the helper threads are started on first use, then parked between walks for the rest of the process.
+// one walk at a time owns them, a walk that finds them taken (another thread's, or one started from a
+// visit) runs on its calling thread alone
+typedef struct walk_pool {
+  pthread_mutex_t lock;
+  pthread_cond_t start;      // a new walk was posted
+  pthread_cond_t finished;   // the last helper left the walk
+  int size;                  // helpers started so far
+  walk_shared *job;
+  int wanted;                // helpers taking part in the current walk, the first ones started
+  unsigned long round;       // bumped for every walk posted
+  int helping;               // helpers still in the current walk
+  bool busy;
+}walk_pool;
+
+static walk_pool pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+typedef struct helper_start {
+  int index;
+  unsigned long round;   // the last round before it was started, it only takes part in later ones
+}helper_start;
+
+// depth first, right subtrees in the loop so the recursion only goes as deep as the left links
+static void walkSubtree (avl_par_visit visit, binary_tree *node, void *acc, void *ctx) {
+  while(node)
+  {
+    binary_tree *left = node -> left;
+    binary_tree *right = node -> right;
+
+    visit(node, acc, ctx);
+    walkSubtree(visit, left, acc, ctx);
+    node = right;
+  }
+}
+
+static bool pushTask (walk_shared *shared, int id, binary_tree *node) {
+  walk_deque *deque = shared -> deques + id;
+  bool pushed = false;
+
+  pthread_mutex_lock(&deque -> lock);
+  if(deque -> count < DEQUE_SLOTS)
+  {
+    atomic_fetch_add(&shared -> pending, 1);
+    deque -> tasks[(deque -> head + deque -> count) % DEQUE_SLOTS] = node;
+    deque -> count++;
+    pushed = true;
+  }
+  pthread_mutex_unlock(&deque -> lock);
+
+  // queued goes up before sleepers is read and a sleeper counts itself before reading queued, so one of
+  // the two sees the other and the task cannot be missed
+  if(pushed)
+  {
+    atomic_fetch_add(&shared -> queued, 1);
+    if(atomic_load(&shared -> sleepers))
+    {
+      pthread_mutex_lock(&shared -> idle);
+      pthread_cond_signal(&shared -> wake);
+      pthread_mutex_unlock(&shared -> idle);
+    }
+  }
+
+  return pushed;
+}
+
+// the owner takes the newest task, its subtree is still warm in the cache
+static binary_tree *popTask (walk_shared *shared, int id) {
+  walk_deque *deque = shared -> deques + id;
+  binary_tree *node = NULL;
+
+  pthread_mutex_lock(&deque -> lock);
+  if(deque -> count)
+  {
+    deque -> count--;
+    node = deque -> tasks[(deque -> head + deque -> count) % DEQUE_SLOTS];
+  }
+  pthread_mutex_unlock(&deque -> lock);
+
+  if(node) atomic_fetch_sub(&shared -> queued, 1);
+  return node;
+}
+
+// a thief takes the oldest task, the one closest to the root
+static binary_tree *stealTask (walk_shared *shared, int id) {
+  for (int i = 1; i < shared -> threads; i++)
+  {
+    walk_deque *deque = shared -> deques + (id + i) % shared -> threads;
+    binary_tree *node = NULL;
+
+    pthread_mutex_lock(&deque -> lock);
+    if(deque -> count)
+    {
+      node = deque -> tasks[deque -> head];
+      deque -> head = (deque -> head + 1) % DEQUE_SLOTS;
+      deque -> count--;
+    }
+    pthread_mutex_unlock(&deque -> lock);
+
+    if(node)
+    {
+      atomic_fetch_sub(&shared -> queued, 1);
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+// down the left spine of a task, leaving the right subtrees above the grain on the deque for whoever
+// gets to them first
+static void runTask (walk_shared *shared, int id, binary_tree *node, void *acc) {
+  while(node && node -> height > TRAVERSE_GRAIN_HEIGHT)
+  {
+    binary_tree *left = node -> left;
+    binary_tree *right = node -> right;
+
+    shared -> visit(node, acc, shared -> ctx);
+    if(right && !pushTask(shared, id, right)) walkSubtree(shared -> visit, right, acc, shared -> ctx);
+    node = left;
+  }
+
+  walkSubtree(shared -> visit, node, acc, shared -> ctx);
+}
+
+// parks until a task is queued or the walk is over, false for the latter
+static bool waitForTask (walk_shared *shared) {
+  pthread_mutex_lock(&shared -> idle);
+  atomic_fetch_add(&shared -> sleepers, 1);
+  while(atomic_load(&shared -> pending) && !atomic_load(&shared -> queued)) pthread_cond_wait(&shared -> wake, &shared -> idle);
+  atomic_fetch_sub(&shared -> sleepers, 1);
+  pthread_mutex_unlock(&shared -> idle);
+
+  return atomic_load(&shared -> pending) != 0;
+}
+
+static void walkRun (walk_shared *shared, int id) {
+  void *acc = shared -> accs + id * shared -> accSize;
+
+  while(1)
+  {
+    binary_tree *node = popTask(shared, id);
+    if(!node) node = stealTask(shared, id);
+    if(!node)
+    {
+      // everything left is being walked by other threads, which may still push more
+      if(!waitForTask(shared)) break;
+      continue;
+    }
+
+    runTask(shared, id, node, acc);
+    if(atomic_fetch_sub(&shared -> pending, 1) == 1)
+    {
+      pthread_mutex_lock(&shared -> idle);
+      pthread_cond_broadcast(&shared -> wake);
+      pthread_mutex_unlock(&shared -> idle);
+    }
+  }
+}
+
+static void *helperRun (void *arg) {
+  helper_start start = *(helper_start *)arg;
+  free(arg);
+
+  pthread_mutex_lock(&pool.lock);
+  while(1)
+  {
+    while(pool.round == start.round) pthread_cond_wait(&pool.start, &pool.lock);
+    start.round = pool.round;
+
+    // a helper left out may only wake after the walk is over, so it must not look at the job
+    if(start.index >= pool.wanted) continue;
+    walk_shared *job = pool.job;
+
+    pthread_mutex_unlock(&pool.lock);
+    walkRun(job, start.index + 1);
+    pthread_mutex_lock(&pool.lock);
+
+    if(!--pool.helping) pthread_cond_signal(&pool.finished);
+  }
+
+  return NULL;
+}
+
+// the helpers are not copied into a forked child, it starts over without any
+static void resetPoolInChild (void) {
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.start, NULL);
+  pthread_cond_init(&pool.finished, NULL);
+  pool.size = 0;
+  pool.helping = 0;
+  pool.busy = false;
+}
+
+static void registerFork (void) {
+  pthread_atfork(NULL, NULL, resetPoolInChild);
+}
+
+// called with the pool lock held
+static bool startHelper (void) {
+  helper_start *start = malloc(sizeof(helper_start));
+  pthread_t handle;
+
+  if(!start) return false;
+  start -> index = pool.size;
+  start -> round = pool.round;
+  if(pthread_create(&handle, NULL, helperRun, start))
+  {
+    free(start);
+    return false;
+  }
+
+  pthread_detach(handle);
+  pool.size++;
+  return true;
+}
+
+void parallelVisitAvlTree (binary_tree *root, int threads, avl_par_visit visit, avl_par_merge merge,
+                           void *acc, size_t accSize, void *ctx) {
+  if(!root) return;
+
+  if(threads <= 0)
+  {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores > 0 ? (int)cores : 1;
+  }
+
+  walk_shared shared = { .visit = visit, .ctx = ctx, .accSize = accSize };
+
+  // a small tree or a single thread walks straight into acc
+  if(threads > 1 && root -> height > TRAVERSE_GRAIN_HEIGHT)
+  {
+    shared.deques = malloc(threads * sizeof(walk_deque));
+    shared.accs = malloc(threads * accSize);
+  }
+  if(!shared.deques || !shared.accs)
+  {
+    free(shared.deques);
+    free(shared.accs);
+    walkSubtree(visit, root, acc, ctx);
+    return;
+  }
+
+  pthread_once(&poolOnce, registerFork);
+  pthread_mutex_lock(&pool.lock);
+  if(pool.busy)
+  {
+    pthread_mutex_unlock(&pool.lock);
+    free(shared.deques);
+    free(shared.accs);
+    walkSubtree(visit, root, acc, ctx);
+    return;
+  }
+  pool.busy = true;
+  // a helper that fails to start only means less stealing
+  while(pool.size < threads - 1 && startHelper());
+  shared.threads = pool.size < threads - 1 ? pool.size + 1 : threads;
+
+  for (int i = 0; i < shared.threads; i++)
+  {
+    pthread_mutex_init(&shared.deques[i].lock, NULL);
+    shared.deques[i].head = shared.deques[i].count = 0;
+    memcpy(shared.accs + i * accSize, acc, accSize);
+  }
+  atomic_init(&shared.pending, 0);
+  atomic_init(&shared.queued, 0);
+  atomic_init(&shared.sleepers, 0);
+  pthread_mutex_init(&shared.idle, NULL);
+  pthread_cond_init(&shared.wake, NULL);
+  pushTask(&shared, 0, root);
+
+  pool.job = &shared;
+  pool.wanted = pool.helping = shared.threads - 1;
+  pool.round++;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.lock);
+
+  walkRun(&shared, 0);
+
+  pthread_mutex_lock(&pool.lock);
+  while(pool.helping) pthread_cond_wait(&pool.finished, &pool.lock);
+  pool.busy = false;
+  pthread_mutex_unlock(&pool.lock);
+
+  for (int i = 0; i < shared.threads; i++)
+  {
+    merge(acc, shared.accs + i * accSize, ctx);
+    pthread_mutex_destroy(&shared.deques[i].lock);
+  }
+  pthread_mutex_destroy(&shared.idle);
+  pthread_cond_destroy(&shared.wake);
+
+  free(shared.deques);
+  free(shared.accs);
+}
+
+// the reductions
+
+typedef struct filter_ctx {
+  avl_key_filter keep;
+  void *ctx;
+}filter_ctx;
+
+static void countVisit (binary_tree *node, void *acc, void *ctx) {
+  filter_ctx *filter = ctx;
+  if(!filter -> keep || filter -> keep(node -> data, filter -> ctx)) (*(size_t *)acc)++;
+}
+
+static void countMerge (void *acc, const void *part, void *ctx) {
+  *(size_t *)acc += *(const size_t *)part;
+}
+
+size_t parallelCountAvlTree (binary_tree *root, int threads, avl_key_filter keep, void *ctx) {
+  filter_ctx filter = {keep, ctx};
+  size_t count = 0;
+
+  parallelVisitAvlTree(root, threads, countVisit, countMerge, &count, sizeof(count), &filter);
+  return count;
+}
+
+static void sumVisit (binary_tree *node, void *acc, void *ctx) {
+  *(long long *)acc += node -> data;
+}
+
+static void sumMerge (void *acc, const void *part, void *ctx) {
+  *(long long *)acc += *(const long long *)part;
+}
+
+long long parallelSumAvlTree (binary_tree *root, int threads) {
+  long long sum = 0;
+
+  parallelVisitAvlTree(root, threads, sumVisit, sumMerge, &sum, sizeof(sum), NULL);
+  return sum;
+}
+
+// every thread collects into its own growing array, the merge appends them
+typedef struct key_buffer {
+  int *keys;
+  size_t count;
+  size_t capacity;
+  bool failed;
+}key_buffer;
+
+static bool bufferReserve (key_buffer *buffer, size_t extra) {
+  if(buffer -> count + extra <= buffer -> capacity) return true;
+
+  size_t capacity = buffer -> capacity ? buffer -> capacity : 256;
+  while(capacity < buffer -> count + extra) capacity *= 2;
+
+  int *keys = realloc(buffer -> keys, capacity * sizeof(int));
+  if(!keys) return false;
+  buffer -> keys = keys;
+  buffer -> capacity = capacity;
+  return true;
+}
+
+static void collectVisit (binary_tree *node, void *acc, void *ctx) {
+  filter_ctx *filter = ctx;
+  key_buffer *buffer = acc;
+
+  if(buffer -> failed || (filter -> keep && !filter -> keep(node -> data, filter -> ctx))) return;
+  if(!bufferReserve(buffer, 1))
+  {
+    buffer -> failed = true;
+    return;
+  }
+  buffer -> keys[buffer -> count++] = node -> data;
+}
+
+static void collectMerge (void *acc, const void *part, void *ctx) {
+  key_buffer *buffer = acc;
+  const key_buffer *other = part;
+
+  // the first buffer is taken over as it is
+  if(!buffer -> keys && !buffer -> failed)
+  {
+    *buffer = *other;
+    return;
+  }
+
+  if(other -> failed || buffer -> failed || !bufferReserve(buffer, other -> count)) buffer -> failed = true;
+  else if(other -> count)
+  {
+    memcpy(buffer -> keys + buffer -> count, other -> keys, other -> count * sizeof(int));
+    buffer -> count += other -> count;
+  }
+  free(other -> keys);
+}
+
+size_t parallelCollectAvlTree (binary_tree *root, int threads, avl_key_filter keep, void *ctx, int **keys) {
+  filter_ctx filter = {keep, ctx};
+  key_buffer buffer = {NULL, 0, 0, false};
+
+  parallelVisitAvlTree(root, threads, collectVisit, collectMerge, &buffer, sizeof(buffer), &filter);
+
+  if(buffer.failed || !buffer.count)
+  {
+    free(buffer.keys);
+    *keys = NULL;
+    return 0;
+  }
+
+  *keys = buffer.keys;
+  return buffer.count;
+}
+
+static void freeVisit (binary_tree *node, void *acc, void *ctx) {
+  free(node);
+}
+
+static void noMerge (void *acc, const void *part, void *ctx) {
+}
+
+void parallelFreeTree (binary_tree *root, int threads) {
+  char unused = 0;
+
+  parallelVisitAvlTree(root, threads, freeVisit, noMerge, &unused, sizeof(unused), NULL);
+}
+
+
+bool levelOrderVisit (binary_tree *root, void (*visit)(binary_tree *node, int level, void *ctx), void *ctx) {
+  queue q;
+  bool ok = true;
+
+  queueInit(&q);
+  if(root) enQueue(&q, root);
+
+  // the queue holds exactly one level at the top of each round
+  for (int level = 0; ok && !queueEmpty(&q); level++)
+  {
+    for (size_t width = q.count; width > 0; width--)
+    {
+      binary_tree *node = deQueue(&q);
+      visit(node, level, ctx);
+      if((node -> left && !enQueue(&q, node -> left)) || (node -> right && !enQueue(&q, node -> right)))
+      {
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  queueFree(&q);
+  return ok;
+}
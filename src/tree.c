@@ -1,5 +1,7 @@
 #include "../include/tree.h"
 #include "../include/queue.h"
+#include "../include/pool.h"
+#include "../include/stats.h"
 
 
 #include <stdio.h>
@@ -9,14 +11,18 @@
 // where to calculate the imblanace factor ? is for the newely created node parent then it's parent only three nodes are necessary for rotating
 // how to know which rotating method to use : if imbalance factor is positive it's left if the imbalance factor is negative it's right then combine ll ?rr ? lr? rl?
 
-void freeTree (binary_tree *root) {
+void freeTreePool (node_pool *pool, binary_tree *root) {
   if(root) {
-    freeTree (root -> left);
-    freeTree (root -> right);
-    free(root);
+    freeTreePool (pool, root -> left);
+    freeTreePool (pool, root -> right);
+    releaseTreeNode(pool, root);
   }
 }
 
+void freeTree (binary_tree *root) {
+  freeTreePool(NULL, root);
+}
+
 // tree traversels
 void preorder (binary_tree *root) {
   if(root) {
@@ -44,22 +50,28 @@ void postorder (binary_tree *root) {
   }
 }
 
+// breadth first with the ring queue, only real children are queued (queueing the NULL ones and then
+// reading their children is what used to crash here)
 void levelOrder (binary_tree *root) {
-  if(!root) printf("tree empty");
-  
-  queue *front = NULL;
-  queue *rear = NULL;
-  enQueue (&front, &rear, root);
+  if(!root)
+  {
+    printf("tree empty");
+    return;
+  }
+
+  queue q;
+  queueInit(&q);
+  enQueue(&q, root);
 
-  while(front)
+  while(!queueEmpty(&q))
   {
-    binary_tree *node = deQueue(&front, &rear);
-    if(node) printf("\n%d\n", node -> data);
-    else printf("\n%p\n", node);
-    enQueue (&front, &rear, node -> left);
-    enQueue (&front, &rear, node -> right);
+    binary_tree *node = deQueue(&q);
+    printf("\n%d\n", node -> data);
+    if(node -> left && !enQueue(&q, node -> left)) break;
+    if(node -> right && !enQueue(&q, node -> right)) break;
   }
-  
+
+  queueFree(&q);
 }
 
 // int height (binary_tree *root) {
@@ -79,7 +91,58 @@ hr = node && node -> right ? node -> right -> height : -1;
 return hl > hr ? hl + 1 : hr + 1;
 }
 
+#if AVL_AUGMENT
+// only size and aggregate, for the part of a path above where the heights stopped changing
+static void updateAugment (binary_tree *node) {
+  binary_tree *l = node -> left;
+  binary_tree *r = node -> right;
+
+  node -> size = 1;
+  node -> agg.sum = node -> data;
+  node -> agg.min = node -> agg.max = node -> data;
+
+  if(l)
+  {
+    node -> size += l -> size;
+    node -> agg.sum += l -> agg.sum;
+    node -> agg.min = l -> agg.min;
+  }
+  if(r)
+  {
+    node -> size += r -> size;
+    node -> agg.sum += r -> agg.sum;
+    node -> agg.max = r -> agg.max;
+  }
+}
+#endif
+
+void updateNode (binary_tree *node) {
+  node -> height = NodeHeight(node);
+#if AVL_AUGMENT
+  updateAugment(node);
+#endif
+}
+
+// read from the statistics so the rotations themselves only count when AVL_STATS is on
+unsigned long avlRotationCount (void) {
+  avl_stats stats;
+
+  avlStatsRead(&stats);
+  return stats.llRotations + stats.rrRotations + stats.lrRotations + stats.rlRotations;
+}
+
+const char *avlBalancePolicyName (void) {
+#if AVL_POLICY == AVL_POLICY_WAVL
+  return "wavl";
+#elif AVL_POLICY == AVL_POLICY_RB
+  return "red-black";
+#else
+  return "avl";
+#endif
+}
+
 binary_tree *llRotation (binary_tree *root, binary_tree *prev) {
+  AVL_STAT_ADD(llRotations, 1);
 
   binary_tree *newRoot = root -> left;
   binary_tree *childRight = newRoot -> right;
@@ -95,14 +158,15 @@ binary_tree *llRotation (binary_tree *root, binary_tree *prev) {
   }
 
   // height update (only update rotated nodes parent's and the newRoot is last one to update as his height is dependent on the updated height's of his new children)   
-  root -> height = NodeHeight(root);
-  newRoot -> height = NodeHeight(newRoot);
+  updateNode(root);
+  updateNode(newRoot);
 
   return newRoot;
 }
 
 
 binary_tree *rrRotation (binary_tree *root, binary_tree *prev) {
+  AVL_STAT_ADD(rrRotations, 1);
   binary_tree *newRoot = root -> right;
   binary_tree *childLeft = newRoot -> left;
 
@@ -116,8 +180,8 @@ binary_tree *rrRotation (binary_tree *root, binary_tree *prev) {
   }
 
   // height update
-  root -> height = NodeHeight(root);
-  newRoot -> height = NodeHeight(newRoot);
+  updateNode(root);
+  updateNode(newRoot);
 
   return newRoot;
 }
@@ -128,6 +192,7 @@ binary_tree *rrRotation (binary_tree *root, binary_tree *prev) {
 //  newRoot (root->left) -> right so it's left go to the child that was on root's right on the node that was  linked to newRoot 
 // same goes for root but this time for the node linked with child takes newRoot rightchild
 binary_tree *lrRotation (binary_tree *root, binary_tree *prev) {
+  AVL_STAT_ADD(lrRotations, 1);
  
   binary_tree *child = root -> left;
   binary_tree *newRoot = child -> right;
@@ -152,14 +217,15 @@ binary_tree *lrRotation (binary_tree *root, binary_tree *prev) {
   }
 
   // height update
-  child -> height = NodeHeight(child);
-  root -> height = NodeHeight(root);
-  newRoot -> height = NodeHeight(newRoot);
+  updateNode(child);
+  updateNode(root);
+  updateNode(newRoot);
 
   return newRoot;
 }
 
 binary_tree *rlRotation (binary_tree *root, binary_tree *prev) {
+  AVL_STAT_ADD(rlRotations, 1);
  
   binary_tree *child = root -> right;  
   binary_tree *newRoot = child -> left;
@@ -184,9 +250,9 @@ binary_tree *rlRotation (binary_tree *root, binary_tree *prev) {
   }
 
   // height update
-  child -> height = NodeHeight(child);
-  root -> height = NodeHeight(root);
-  newRoot -> height = NodeHeight(newRoot);
+  updateNode(child);
+  updateNode(root);
+  updateNode(newRoot);
 
 
   return newRoot;
@@ -202,150 +268,501 @@ int calculateBalanceFactor (binary_tree *node) {
   return leftChildHeight - rightChildHeight;
 }
 
-binary_tree *createNodeAvlTree (binary_tree *curr, binary_tree *prev, int key) {
+// picks the rotation for an unbalanced node, prev is the parent or the node itself when it is the root
+binary_tree *balanceNode (binary_tree *curr, binary_tree *prev) {
+  int balanceFactor = calculateBalanceFactor(curr);
 
-  // classic bst insertion
-  if (!curr)
+  if(balanceFactor < -1)
   {
-    //this is for increasing the height of the new parent when it only has no children 
-    if(prev && !(prev -> left) && !(prev -> right) ) prev -> height++;
+    // a balanced right child (only possible after a deletion) needs the single rotation
+    if (calculateBalanceFactor(curr -> right) > 0) return rlRotation(curr, prev);
+    return rrRotation(curr, prev);
+  }
+  if(balanceFactor > 1)
+  {
+    if (calculateBalanceFactor(curr -> left) < 0) return lrRotation(curr, prev);
+    return llRotation(curr, prev);
+  }
 
-    binary_tree *node = malloc(sizeof(binary_tree));
-    node -> data = key;
-    node -> height = 0;
-    node -> left = node -> right = NULL;
-  
-    return node;
+  return curr;
+}
+
+#if AVL_POLICY == AVL_POLICY_AVL
+
+// walks the insertion path bottom up, an insert rotation restores the old subtree height
+// and an unchanged height means nothing above can change either, so both stop the retrace
+binary_tree *retraceInsertPath (binary_tree *root, binary_tree **path, int depth, int *stop, bool *rotated) {
+  int i;
+
+  if(rotated) *rotated = false;
+  for (i = depth - 1; i >= 0; i--)
+  {
+    binary_tree *curr = path[i];
+    int oldHeight = curr -> height;
+    int balanceFactor;
+
+    updateNode(curr);
+    balanceFactor = calculateBalanceFactor(curr);
+
+    if( balanceFactor < -1 || balanceFactor > 1 )
+    {
+      binary_tree *newRoot = balanceNode(curr, i ? path[i - 1] : curr);
+      if(!i) root = newRoot;
+      if(rotated) *rotated = true;
+      break;
+    }
+
+    if(curr -> height == oldHeight) break;
   }
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
 
-  if(curr -> data < key) curr -> right = createNodeAvlTree(curr -> right, curr, key);
-  else if (curr -> data > key) curr -> left = createNodeAvlTree(curr -> left, curr, key);
-  
-  // updating the height as needed
-  // if curr != prev to prevent updating the root every time  cause root has the height of the whole tree
-  // if height of the previous node which is the parent of the new parent is updated is equal to it's child curr
-  //  we increase the height of the parent of the new parent aka prev cause every parent and child height diff is maximum 1
-  int balanceFactor = calculateBalanceFactor(curr);
+  *stop = i;
+  return root;
+}
+
+static binary_tree *retraceInsert (binary_tree *root, binary_tree **path, int depth) {
+  int i;
+
+  root = retraceInsertPath(root, path, depth, &i, NULL);
+
+  // the balance is settled, the ancestors above only need their augmentation refreshed
+#if AVL_AUGMENT
+  while(--i >= 0) updateAugment(path[i]);
+#endif
+
+  return root;
+}
+
+// deletion can shrink the subtree even after a rotation, so only an unchanged height stops the retrace
+static binary_tree *retraceDelete (binary_tree *root, binary_tree **path, int depth) {
+  int i;
+
+  for (i = depth - 1; i >= 0; i--)
+  {
+    binary_tree *curr = path[i];
+    int oldHeight = curr -> height;
+
+    updateNode(curr);
+    curr = balanceNode(curr, i ? path[i - 1] : curr);
+    if(!i) root = curr;
 
-  // bst tree height balancing
+    if(curr -> height == oldHeight) break;
+  }
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
+
+#if AVL_AUGMENT
+  while(--i >= 0) updateAugment(path[i]);
+#endif
+
+  return root;
+}
+
+#else
+
+// rank balanced retracing for the wavl and red-black policies (see tree.h). the height field holds the
+// rank, a missing child has rank -1 and a node's rank difference is its parent's rank minus its own.
+// both walk up from path[depth], the new node or the child that took the removed node's place
+
+static int nodeRank (binary_tree *node) {
+  return node ? node -> height : -1;
+}
+
+static void refreshAugment (binary_tree *node) {
+#if AVL_AUGMENT
+  updateAugment(node);
+#else
+  (void)node;
+#endif
+}
 
-  if( balanceFactor < -1 || balanceFactor > 1 )
+// child takes parent's place under above (NULL when parent is the root), ranks are up to the caller
+static binary_tree *rotateUp (binary_tree *root, binary_tree *above, binary_tree *parent, binary_tree *child) {
+  if(parent -> left == child)
   {
-    binary_tree *child = NULL;
-    int childBalanceFactor;
+    parent -> left = child -> right;
+    child -> right = parent;
+  }
+  else
+  {
+    parent -> right = child -> left;
+    child -> left = parent;
+  }
+
+  if(!above) root = child;
+  else if(above -> left == parent) above -> left = child;
+  else above -> right = child;
+
+  refreshAugment(parent);
+  refreshAugment(child);
+  return root;
+}
+
+// a single rotation of child over parent or, with inner (the child's inner child), the double rotation
+// that lifts inner over both. counted like the avl rotations, once each under the shape they fix
+static binary_tree *rotateRanked (binary_tree *root, binary_tree *above, binary_tree *parent, binary_tree *child,
+                                  binary_tree *inner) {
+  bool left = parent -> left == child;
+
+  if(!inner)
+  {
+    if(left) AVL_STAT_ADD(llRotations, 1);
+    else AVL_STAT_ADD(rrRotations, 1);
+    return rotateUp(root, above, parent, child);
+  }
+
+  if(left) AVL_STAT_ADD(lrRotations, 1);
+  else AVL_STAT_ADD(rlRotations, 1);
+  root = rotateUp(root, parent, child, inner);
+  return rotateUp(root, above, parent, inner);
+}
+
+#if AVL_POLICY == AVL_POLICY_WAVL
+
+// the new leaf (rank 0) may be a 0-child. promote its parent while the parent is 0,1, at 0,2 a single
+// or double rotation ends it, the same steps as avl but without looking at the sibling subtree's height
+static binary_tree *retraceInsert (binary_tree *root, binary_tree **path, int depth) {
+  int i;
+
+  for (i = depth - 1; i >= 0; i--)
+  {
+    binary_tree *p = path[i];
+    binary_tree *x = path[i + 1];
+    binary_tree *s = p -> left == x ? p -> right : p -> left;
+
+    refreshAugment(p);
+    if(p -> height != x -> height) break;
+
+    if(p -> height - nodeRank(s) == 1)
+    {
+      p -> height++;
+      continue;
+    }
 
-    if(balanceFactor < 0)
+    // x's inner child is a 2-child (or missing): single rotation, else the double one
+    binary_tree *inner = p -> left == x ? x -> right : x -> left;
+    if(x -> height - nodeRank(inner) == 2)
     {
-      child = curr -> right;
-      childBalanceFactor = calculateBalanceFactor(child);
-      if (childBalanceFactor < 0) curr = rrRotation(curr, prev);
-      else curr = rlRotation(curr, prev);
+      root = rotateRanked(root, i ? path[i - 1] : NULL, p, x, NULL);
+      p -> height--;
     }
     else
     {
-      child = curr -> left;
-      childBalanceFactor = calculateBalanceFactor(child);
-      if (childBalanceFactor < 0) curr = lrRotation(curr, prev);
-      else curr = llRotation(curr, prev);
+      root = rotateRanked(root, i ? path[i - 1] : NULL, p, x, inner);
+      inner -> height++;
+      x -> height--;
+      p -> height--;
     }
+    break;
   }
-  
-  // this jumps after the balancing check cause we don't want to update a parent based on a dibalanced child
-  int height = curr -> height; 
-  if(curr != prev && height == prev -> height) prev -> height++;
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
 
-  return curr;
+  while(--i >= 0) refreshAugment(path[i]);
+
+  return root;
 }
 
-binary_tree *insertAvlTree (binary_tree *root, int key) {
+// a removal can leave a 2,2 leaf (demoted) or a 3-child. a 3-child is fixed by demoting its parent, or
+// the parent and a 2,2 sibling, which moves the problem up, or by at most two rotations that end it
+static binary_tree *retraceDelete (binary_tree *root, binary_tree **path, int depth) {
+  binary_tree *x = path[depth];
+  int i;
 
-  return createNodeAvlTree(root, root, key);
+  for (i = depth - 1; i >= 0; i--)
+  {
+    binary_tree *p = path[i];
+    // when x is NULL and p has no children either side will do
+    bool left = p -> left == x;
+    binary_tree *s = left ? p -> right : p -> left;
 
-}
+    refreshAugment(p);
+    x = p;
 
+    if(!p -> left && !p -> right)
+    {
+      if(!p -> height) break;
+      p -> height = 0;
+      continue;
+    }
+    if(p -> height - nodeRank(left ? p -> left : p -> right) < 3) break;
 
-// avl deletion
+    if(p -> height - nodeRank(s) == 2)
+    {
+      p -> height--;
+      continue;
+    }
 
-binary_tree *inorderPredecessor (binary_tree *node) {
-  node = node -> left;
+    binary_tree *outer = left ? s -> right : s -> left;
+    binary_tree *inner = left ? s -> left : s -> right;
+    if(s -> height - nodeRank(outer) == 2 && s -> height - nodeRank(inner) == 2)
+    {
+      p -> height--;
+      s -> height--;
+      continue;
+    }
+
+    if(s -> height - nodeRank(outer) == 1)
+    {
+      root = rotateRanked(root, i ? path[i - 1] : NULL, p, s, NULL);
+      s -> height++;
+      p -> height--;
+      // a leaf now, which has rank 0
+      if(!p -> left && !p -> right) p -> height = 0;
+    }
+    else
+    {
+      root = rotateRanked(root, i ? path[i - 1] : NULL, p, s, inner);
+      inner -> height += 2;
+      s -> height--;
+      p -> height -= 2;
+    }
+    break;
+  }
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
 
-  while (node -> right) node = node -> right;
+  while(--i >= 0) refreshAugment(path[i]);
 
-  return node;
+  return root;
 }
 
-binary_tree *inorderSuccessor (binary_tree *node) {
-  node = node -> right;
+#else
+
+// the new node (rank 0, red) may be a 0-child of a 0-child. a 0-child uncle means promoting the
+// grandparent and going on two levels up, otherwise one single or double rotation ends it
+static binary_tree *retraceInsert (binary_tree *root, binary_tree **path, int depth) {
+  int i;
 
-  while (node -> left) node = node -> left;
+  for (i = depth - 1; i >= 0; i--)
+  {
+    binary_tree *p = path[i];
+    binary_tree *x = path[i + 1];
+
+    refreshAugment(p);
+    // a 1-child, or a 0-child of the root, is fine
+    if(p -> height != x -> height || !i) break;
+
+    binary_tree *g = path[i - 1];
+    if(g -> height != p -> height) break;
+
+    binary_tree *u = g -> left == p ? g -> right : g -> left;
+    i--;
+    if(g -> height == nodeRank(u))
+    {
+      g -> height++;
+      refreshAugment(g);
+      continue;
+    }
 
-  return node;
+    binary_tree *inner = g -> left == p ? p -> right : p -> left;
+    root = rotateRanked(root, i ? path[i - 1] : NULL, g, p, x == inner ? x : NULL);
+    break;
+  }
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
+
+  while(--i >= 0) refreshAugment(path[i]);
+
+  return root;
 }
 
-binary_tree *refactorTree(binary_tree *curr, binary_tree *prev, int key) {
-  if(!curr) return NULL;
+// only a removed black leaf (a 1-child) leaves a 2-child behind, a removed node with a child is replaced
+// by that red child at the same difference. a 0-child sibling is rotated up first, then a rotation at a
+// 0-child nephew ends it, or demoting the parent does when the parent was a 0-child
+static binary_tree *retraceDelete (binary_tree *root, binary_tree **path, int depth) {
+  binary_tree *x = path[depth];
+  int i;
 
-  if (curr -> data > key) curr -> left = refactorTree(curr -> left, curr, key);
-  else if (curr -> data < key) curr -> right = refactorTree(curr -> right, curr, key);
-  
-  else if (curr -> data == key)
+  for (i = depth - 1; i >= 0; i--)
   {
-    
-    int leftSubTreeHeight = curr -> left ? (curr -> left) -> height : -1;
-    int rightSubTreeHeight = curr -> right ? (curr -> right) -> height : -1;
-    binary_tree *swapNode = NULL;
+    binary_tree *p = path[i];
+    bool left = p -> left == x;
+    binary_tree *s = left ? p -> right : p -> left;
+    binary_tree *above = i ? path[i - 1] : NULL;
+    binary_tree *lifted = NULL;
+
+    refreshAugment(p);
+    if(p -> height - nodeRank(x) < 2) break;
 
-    if ( (leftSubTreeHeight < rightSubTreeHeight && leftSubTreeHeight > -1) ||  leftSubTreeHeight > rightSubTreeHeight) 
+    if(p -> height == s -> height)
     {
-      swapNode = inorderPredecessor(curr);
-      curr -> data = swapNode -> data;
-      curr -> left = refactorTree(curr -> left, curr, swapNode -> data);
+      // p ends up a 0-child of s, so whatever happens below does not go past it
+      root = rotateRanked(root, above, p, s, NULL);
+      above = lifted = s;
+      s = left ? p -> right : p -> left;
     }
-    else if ( (leftSubTreeHeight > rightSubTreeHeight && rightSubTreeHeight > -1) || rightSubTreeHeight!= -1 )
+
+    binary_tree *outer = left ? s -> right : s -> left;
+    binary_tree *inner = left ? s -> left : s -> right;
+    if(s -> height == nodeRank(outer))
     {
-      swapNode = inorderSuccessor(curr);
-      curr -> data = swapNode -> data;
-      curr -> right = refactorTree(curr -> right, curr, swapNode -> data);
+      root = rotateRanked(root, above, p, s, NULL);
+      s -> height++;
+      p -> height--;
     }
-    else if (leftSubTreeHeight == -1 && rightSubTreeHeight == -1) 
+    else if(s -> height == nodeRank(inner))
     {
-      if (prev || ( !prev && !(curr -> height) ) ) return NULL;
+      root = rotateRanked(root, above, p, s, inner);
+      inner -> height++;
+      p -> height--;
     }
+    else
+    {
+      bool zeroChild = above && above -> height == p -> height;
+      p -> height--;
+      if(!zeroChild)
+      {
+        x = p;
+        continue;
+      }
+    }
+
+    if(lifted) refreshAugment(lifted);
+    break;
   }
+  AVL_STAT_ADD(retraceSteps, depth - (i < 0 ? 0 : i));
 
-  curr -> height = NodeHeight(curr);
-  prev = !prev ? curr : prev;
-  int balanceFactor = calculateBalanceFactor(curr);
+  while(--i >= 0) refreshAugment(path[i]);
+
+  return root;
+}
+
+#endif
+
+#endif
 
+binary_tree *createNodeAvlTree (node_pool *pool, binary_tree *root, int key) {
+  binary_tree *path[AVL_MAX_HEIGHT];
+  int depth = 0;
+  binary_tree *curr = root;
 
-  if( balanceFactor < -1 || balanceFactor > 1 )
+  AVL_STAT_ADD(inserts, 1);
+
+  // classic bst descent, remembering the path instead of recursing
+  while(curr)
   {
-    binary_tree *child = NULL;
-    int childBalanceFactor;
+    if(curr -> data == key)
+    {
+      AVL_STAT_ADD(comparisons, 2 * depth + 1);
+      AVL_STAT_ADD(pathLength, depth + 1);
+      AVL_STAT_DEPTH(depth + 1);
+      return root;
+    }
+    path[depth++] = curr;
+    curr = curr -> data < key ? curr -> right : curr -> left;
+  }
+  AVL_STAT_ADD(comparisons, 2 * depth);
+  AVL_STAT_ADD(pathLength, depth);
+  AVL_STAT_DEPTH(depth);
+
+  binary_tree *node = newTreeNode(pool, key);
+  if(!node) return root;
+  if(!depth) return node;
+
+  binary_tree *parent = path[depth - 1];
+  if(parent -> data < key) parent -> right = node;
+  else parent -> left = node;
+  // where the rank policies start retracing from
+  path[depth] = node;
 
-    if(balanceFactor < 0)
+  return retraceInsert(root, path, depth);
+}
+
+binary_tree *searchAvlTree (binary_tree *root, int key) {
+  binary_tree *curr = root;
+  int depth = 0;
+
+  AVL_STAT_ADD(searches, 1);
+
+  while(curr && curr -> data != key)
+  {
+    depth++;
+    curr = curr -> data < key ? curr -> right : curr -> left;
+  }
+
+  AVL_STAT_ADD(comparisons, 2 * depth + (curr != NULL));
+  AVL_STAT_ADD(pathLength, depth + (curr != NULL));
+  AVL_STAT_DEPTH(depth + (curr != NULL));
+  return curr;
+}
+
+binary_tree *insertAvlTreePool (node_pool *pool, binary_tree *root, int key) {
+
+  return createNodeAvlTree(pool, root, key);
+
+}
+
+binary_tree *insertAvlTree (binary_tree *root, int key) {
+
+  return insertAvlTreePool(NULL, root, key);
+
+}
+
+
+// avl deletion
+
+binary_tree *refactorTree(node_pool *pool, binary_tree *root, int key, binary_tree **moved) {
+  binary_tree *path[AVL_MAX_HEIGHT];
+  int depth = 0;
+  binary_tree *curr = root;
+
+  AVL_STAT_ADD(deletes, 1);
+  if(moved) *moved = NULL;
+
+  while(curr && curr -> data != key)
+  {
+    path[depth++] = curr;
+    curr = curr -> data < key ? curr -> right : curr -> left;
+  }
+  AVL_STAT_ADD(comparisons, 2 * depth + (curr != NULL));
+  AVL_STAT_ADD(pathLength, depth + (curr != NULL));
+  AVL_STAT_DEPTH(depth + (curr != NULL));
+  if(!curr) return root;
+
+  // a node with two children takes the data of its inorder predecessor (taller left side) or successor
+  // and that node, which has at most one child, is the one unlinked
+  if(curr -> left && curr -> right)
+  {
+    binary_tree *target = curr;
+    path[depth++] = curr;
+
+    if(curr -> left -> height > curr -> right -> height)
     {
-      child = curr -> right;
-      childBalanceFactor = calculateBalanceFactor(child);
-      if (childBalanceFactor < 0) curr = rrRotation(curr, prev);
-      else curr = rlRotation(curr, prev);
+      curr = curr -> left;
+      while(curr -> right)
+      {
+        path[depth++] = curr;
+        curr = curr -> right;
+      }
     }
     else
     {
-      child = curr -> left;
-      childBalanceFactor = calculateBalanceFactor(child);
-      if (childBalanceFactor < 0) curr = lrRotation(curr, prev);
-      else curr = llRotation(curr, prev);
+      curr = curr -> right;
+      while(curr -> left)
+      {
+        path[depth++] = curr;
+        curr = curr -> left;
+      }
     }
+
+    target -> data = curr -> data;
+    if(moved) *moved = target;
   }
 
-  int height = curr -> height; 
-  if(curr != prev && height == prev -> height) prev -> height++;
-  
-  return curr;
+  binary_tree *child = curr -> left ? curr -> left : curr -> right;
+
+  if(!depth) root = child;
+  else if(path[depth - 1] -> left == curr) path[depth - 1] -> left = child;
+  else path[depth - 1] -> right = child;
+
+  // the removed node goes back to its allocator (the pool recycles it for the next insert)
+  releaseTreeNode(pool, curr);
+  path[depth] = child;
+
+  return retraceDelete(root, path, depth);
+}
 
+binary_tree *deleteNodeAvlTreePool(node_pool *pool, binary_tree *root, int key) {
+  return refactorTree(pool, root, key, NULL);
 }
 
 binary_tree *deleteNodeAvlTree(binary_tree *root, int key) {
-  return refactorTree(root, NULL, key);
+  return deleteNodeAvlTreePool(NULL, root, key);
 }
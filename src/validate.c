@@ -0,0 +1,201 @@
+#include "../include/validate.h"
+
+#include <limits.h>
+
+// bounds are exclusive and kept as long long so INT_MIN and INT_MAX keys need no special case
+#define NO_LOWER_BOUND LLONG_MIN
+#define NO_UPPER_BOUND LLONG_MAX
+
+static avl_violation fail (avl_check *report, avl_violation violation, binary_tree *node) {
+  report -> violation = violation;
+  report -> node = node;
+  return violation;
+}
+
+static int rankOf (binary_tree *node) {
+  return node ? node -> height : -1;
+}
+
+// what one node must satisfy given the fields stored in its children (and, red-black, grandchildren)
+static avl_violation checkLocal (binary_tree *node) {
+  int hl = rankOf(node -> left);
+  int hr = rankOf(node -> right);
+
+#if AVL_POLICY == AVL_POLICY_WAVL
+  if(!node -> left && !node -> right && node -> height) return AVL_HEIGHT;
+  if(node -> height - hl < 1 || node -> height - hl > 2 || node -> height - hr < 1 || node -> height - hr > 2)
+    return AVL_BALANCE;
+#elif AVL_POLICY == AVL_POLICY_RB
+  if(node -> height - hl < 0 || node -> height - hl > 1 || node -> height - hr < 0 || node -> height - hr > 1)
+    return AVL_BALANCE;
+  // a 0-child (red) only has 1-children
+  for (int side = 0; side < 2; side++)
+  {
+    binary_tree *child = side ? node -> right : node -> left;
+    if(child && child -> height == node -> height &&
+       (rankOf(child -> left) == child -> height || rankOf(child -> right) == child -> height))
+      return AVL_BALANCE;
+  }
+#else
+  if(node -> height != (hl > hr ? hl : hr) + 1) return AVL_HEIGHT;
+  if(hl - hr > 1 || hr - hl > 1) return AVL_BALANCE;
+#endif
+
+#if AVL_AUGMENT
+  int size = 1;
+  long long sum = node -> data;
+  int min = node -> data;
+  int max = node -> data;
+
+  if(node -> left)
+  {
+    size += node -> left -> size;
+    sum += node -> left -> agg.sum;
+    min = node -> left -> agg.min;
+  }
+  if(node -> right)
+  {
+    size += node -> right -> size;
+    sum += node -> right -> agg.sum;
+    max = node -> right -> agg.max;
+  }
+  if(node -> size != size || node -> agg.sum != sum || node -> agg.min != min || node -> agg.max != max)
+    return AVL_AUGMENT_BAD;
+#endif
+
+  return AVL_OK;
+}
+
+// children first, so when a node is checked against its children their stored fields are already known good
+static avl_violation checkSubtree (binary_tree *node, long long lo, long long hi, int depth, avl_check *report) {
+  if(!node) return AVL_OK;
+  if(depth >= AVL_MAX_HEIGHT) return fail(report, AVL_TOO_DEEP, node);
+  if(node -> data <= lo || node -> data >= hi) return fail(report, AVL_ORDER, node);
+
+  report -> nodes++;
+  if(checkSubtree(node -> left, lo, node -> data, depth + 1, report)) return report -> violation;
+  if(checkSubtree(node -> right, node -> data, hi, depth + 1, report)) return report -> violation;
+
+  avl_violation violation = checkLocal(node);
+  return violation ? fail(report, violation, node) : AVL_OK;
+}
+
+static void startReport (avl_check *report, binary_tree *root) {
+  report -> violation = AVL_OK;
+  report -> node = NULL;
+  report -> nodes = 0;
+  report -> height = root ? root -> height : -1;
+}
+
+avl_violation checkAvlTree (binary_tree *root, avl_check *report) {
+  startReport(report, root);
+  return checkSubtree(root, NO_LOWER_BOUND, NO_UPPER_BOUND, 0, report);
+}
+
+// one node of a path and its children, each against its own children. next is the child the path goes on
+// to, which gets its own step, so it is not checked here
+static avl_violation checkStep (binary_tree *node, binary_tree *next, long long lo, long long hi, avl_check *report) {
+  binary_tree *left = node -> left;
+  binary_tree *right = node -> right;
+  avl_violation violation;
+
+  if(node -> data <= lo || node -> data >= hi) return fail(report, AVL_ORDER, node);
+  if(left && (left -> data <= lo || left -> data >= node -> data)) return fail(report, AVL_ORDER, left);
+  if(right && (right -> data <= node -> data || right -> data >= hi)) return fail(report, AVL_ORDER, right);
+
+  report -> nodes++;
+  if((violation = checkLocal(node))) return fail(report, violation, node);
+  if(left && left != next && (violation = checkLocal(left))) return fail(report, violation, left);
+  if(right && right != next && (violation = checkLocal(right))) return fail(report, violation, right);
+
+  return AVL_OK;
+}
+
+// the path down one side of a subtree, where a delete unlinks the node whose key replaced the deleted one
+static avl_violation checkSpine (binary_tree *node, long long lo, long long hi, int depth, int right, avl_check *report) {
+  while(node)
+  {
+    if(depth++ >= AVL_MAX_HEIGHT) return fail(report, AVL_TOO_DEEP, node);
+    if(checkStep(node, right ? node -> right : node -> left, lo, hi, report)) return report -> violation;
+
+    if(right)
+    {
+      lo = node -> data;
+      node = node -> right;
+    }
+    else
+    {
+      hi = node -> data;
+      node = node -> left;
+    }
+  }
+
+  return AVL_OK;
+}
+
+avl_violation checkAvlPath (binary_tree *root, int key, avl_check *report) {
+  binary_tree *node = root;
+  long long lo = NO_LOWER_BOUND;
+  long long hi = NO_UPPER_BOUND;
+  int depth = 0;
+
+  // the last nodes the path turned right and left at, with what their inner spines need
+  binary_tree *below = NULL, *above = NULL;
+  long long belowLo = 0, aboveHi = 0;
+  int belowDepth = 0, aboveDepth = 0;
+
+  startReport(report, root);
+
+  // an insert only writes fields on the search path of the key (rotations also write the children of the
+  // nodes on it, which checkStep covers)
+  while(node)
+  {
+    if(depth++ >= AVL_MAX_HEIGHT) return fail(report, AVL_TOO_DEEP, node);
+    binary_tree *next = node -> data < key ? node -> right : node -> data > key ? node -> left : NULL;
+    if(checkStep(node, next, lo, hi, report)) return report -> violation;
+
+    if(node -> data == key)
+    {
+      // still there: its own neighbours' paths below it
+      if(checkSpine(node -> left, lo, node -> data, depth, 1, report)) return report -> violation;
+      return checkSpine(node -> right, node -> data, hi, depth, 0, report);
+    }
+
+    if(node -> data < key)
+    {
+      below = node;
+      belowLo = lo;
+      belowDepth = depth;
+      lo = node -> data;
+      node = node -> right;
+    }
+    else
+    {
+      above = node;
+      aboveHi = hi;
+      aboveDepth = depth;
+      hi = node -> data;
+      node = node -> left;
+    }
+  }
+
+  // a delete moved the predecessor (now in below) or successor (now in above) into the deleted node's
+  // place and unlinked it from the inner spine of that node's subtree, which is where the retrace started
+  if(below && checkSpine(below -> left, belowLo, below -> data, belowDepth, 1, report)) return report -> violation;
+  if(above && checkSpine(above -> right, above -> data, aboveHi, aboveDepth, 0, report)) return report -> violation;
+
+  return AVL_OK;
+}
+
+const char *avlViolationName (avl_violation violation) {
+  switch(violation)
+  {
+    case AVL_OK: return "ok";
+    case AVL_ORDER: return "key order";
+    case AVL_HEIGHT: return "stored height";
+    case AVL_BALANCE: return "balance factor";
+    case AVL_AUGMENT_BAD: return "size/aggregate";
+    case AVL_TOO_DEEP: return "too deep";
+  }
+  return "unknown";
+}
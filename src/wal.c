@@ -0,0 +1,449 @@
+#include "../include/wal.h"
+#include "../include/serialize.h"
+#include "../include/build.h"
+#include "../include/join.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// recovery loads the checkpoint and replays the log through build, union and difference
+#if AVL_POLICY != AVL_POLICY_AVL
+#error "the write-ahead log needs the default avl balancing policy (see AVL_POLICY in tree.h)"
+#endif
+
+#define LOG_HEADER_BYTES 8
+#define LOG_VERSION 1
+
+// op byte, key and a check over both plus the record's position in the log, 9 bytes a record
+#define RECORD_BYTES 9
+#define RECORD_INSERT 1
+#define RECORD_DELETE 2
+
+// records replayed per batch, each batch is reduced to its net effect and merged into the tree at once
+#define REPLAY_BATCH (1 << 20)
+
+static const unsigned char logMagic[4] = {'A', 'V', 'L', 'W'};
+
+static uint64_t monotonicNs (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// the position makes a stale record left behind past the end of a shorter log fail the check
+static uint32_t recordCheck (uint64_t index, int op, int key) {
+  uint64_t h = index * 0x9e3779b97f4a7c15ull ^ (uint64_t)op << 32 ^ (uint32_t)key;
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return (uint32_t)h;
+}
+
+static void encodeRecord (unsigned char *out, uint64_t index, int op, int key) {
+  uint32_t check = recordCheck(index, op, key);
+
+  out[0] = (unsigned char)op;
+  for (int i = 0; i < 4; i++)
+  {
+    out[1 + i] = (unsigned char)((uint32_t)key >> (8 * i));
+    out[5 + i] = (unsigned char)(check >> (8 * i));
+  }
+}
+
+// false for a torn or stale record
+static bool decodeRecord (const unsigned char *in, uint64_t index, int *op, int *key) {
+  uint32_t k = 0, check = 0;
+
+  for (int i = 0; i < 4; i++)
+  {
+    k |= (uint32_t)in[1 + i] << (8 * i);
+    check |= (uint32_t)in[5 + i] << (8 * i);
+  }
+
+  *op = in[0];
+  *key = (int)k;
+  return (*op == RECORD_INSERT || *op == RECORD_DELETE) && check == recordCheck(index, *op, *key);
+}
+
+static bool writeAll (int fd, const unsigned char *bytes, size_t n) {
+  while(n)
+  {
+    ssize_t done = write(fd, bytes, n);
+    if(done < 0 && errno == EINTR) continue;
+    if(done <= 0) return false;
+    bytes += done;
+    n -= done;
+  }
+  return true;
+}
+
+static char *joinPath (const char *path, const char *suffix) {
+  char *joined = malloc(strlen(path) + strlen(suffix) + 1);
+  if(joined) strcat(strcpy(joined, path), suffix);
+  return joined;
+}
+
+// a rename is only durable once the directory holding it is synced
+static bool syncDirectory (const char *path) {
+  const char *slash = strrchr(path, '/');
+  char *dir = slash ? strndup(path, slash == path ? 1 : slash - path) : strdup(".");
+  if(!dir) return false;
+
+  int fd = open(dir, O_RDONLY);
+  free(dir);
+  if(fd < 0) return false;
+
+  bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// appending
+
+// makes every record up to lsn written (and fsynced with sync), called and returning with the lock held.
+// whoever finds no flush running takes the whole buffer to disk for everyone, the others wait for it and
+// look again: while one fsync runs the next group piles up in the buffer
+static bool flushLocked (wal_tree *wal, uint64_t lsn, bool sync) {
+  while((sync ? wal -> synced : wal -> written) < lsn && !wal -> failed)
+  {
+    if(wal -> flushing)
+    {
+      pthread_cond_wait(&wal -> flushed, &wal -> lock);
+      continue;
+    }
+
+    size_t n = wal -> used;
+    uint64_t upTo = wal -> appended;
+    memcpy(wal -> io, wal -> buffer, n);
+    wal -> used = 0;
+    wal -> flushing = true;
+    pthread_mutex_unlock(&wal -> lock);
+
+    bool ok = writeAll(wal -> logFd, wal -> io, n) && (!sync || fdatasync(wal -> logFd) == 0);
+
+    pthread_mutex_lock(&wal -> lock);
+    wal -> flushing = false;
+    if(ok)
+    {
+      wal -> written = upTo;
+      if(sync)
+      {
+        wal -> synced = upTo;
+        wal -> syncs++;
+      }
+    }
+    else wal -> failed = true;
+    pthread_cond_broadcast(&wal -> flushed);
+  }
+
+  return !wal -> failed;
+}
+
+static bool checkpointLocked (wal_tree *wal);
+
+static bool logUpdate (wal_tree *wal, int op, int key) {
+  if(wal -> failed) return false;
+  // flushLocked drops the lock while it writes (or waits for another flush), and the other writers can
+  // fill the buffer up again in the meantime, so there is only room once it says so after returning
+  while(wal -> used + RECORD_BYTES > WAL_BUFFER)
+  {
+    if(!flushLocked(wal, wal -> appended, false)) return false;
+  }
+
+  encodeRecord(wal -> buffer + wal -> used, wal -> logRecords++, op, key);
+  wal -> used += RECORD_BYTES;
+  uint64_t lsn = ++wal -> appended;
+
+  bool ok = true;
+  if(wal -> options.durability == WAL_SYNC) ok = flushLocked(wal, lsn, true);
+  else if(wal -> options.durability == WAL_GROUP)
+  {
+    uint64_t now = monotonicNs();
+    if(lsn == wal -> synced + 1) wal -> groupStart = now;
+
+    if(lsn - wal -> synced >= wal -> options.groupRecords || now - wal -> groupStart >= wal -> options.groupMicros * 1000ull)
+    {
+      ok = flushLocked(wal, lsn, true);
+    }
+  }
+
+  if(ok && wal -> options.checkpointRecords && wal -> logRecords >= wal -> options.checkpointRecords) ok = checkpointLocked(wal);
+  return ok;
+}
+
+bool walInsert (wal_tree *wal, int key) {
+  pthread_mutex_lock(&wal -> lock);
+  wal -> root = insertAvlTree(wal -> root, key);
+  bool ok = logUpdate(wal, RECORD_INSERT, key);
+  pthread_mutex_unlock(&wal -> lock);
+  return ok;
+}
+
+bool walDelete (wal_tree *wal, int key) {
+  pthread_mutex_lock(&wal -> lock);
+  wal -> root = deleteNodeAvlTree(wal -> root, key);
+  bool ok = logUpdate(wal, RECORD_DELETE, key);
+  pthread_mutex_unlock(&wal -> lock);
+  return ok;
+}
+
+bool walContains (wal_tree *wal, int key) {
+  pthread_mutex_lock(&wal -> lock);
+  binary_tree *node = wal -> root;
+  while(node && node -> data != key) node = key < node -> data ? node -> left : node -> right;
+  pthread_mutex_unlock(&wal -> lock);
+  return node != NULL;
+}
+
+bool walSync (wal_tree *wal) {
+  pthread_mutex_lock(&wal -> lock);
+  bool ok = flushLocked(wal, wal -> appended, true);
+  pthread_mutex_unlock(&wal -> lock);
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// checkpoints
+
+static bool writeLogHeader (int fd) {
+  unsigned char header[LOG_HEADER_BYTES];
+
+  memcpy(header, logMagic, 4);
+  for (int i = 0; i < 4; i++) header[4 + i] = (unsigned char)(LOG_VERSION >> (8 * i));
+  return writeAll(fd, header, LOG_HEADER_BYTES);
+}
+
+// the tree goes to a temporary file that is renamed over the old checkpoint once it is on disk, so there is
+// always one complete checkpoint. only then is the log cut back to its header
+static bool checkpointLocked (wal_tree *wal) {
+  // waiting on a flush lets other updates in, the log has to be fully synced with nobody writing to it
+  while(wal -> flushing || wal -> synced < wal -> appended)
+  {
+    if(!flushLocked(wal, wal -> appended, true)) return false;
+    while(wal -> flushing) pthread_cond_wait(&wal -> flushed, &wal -> lock);
+  }
+
+  char *tmpPath = joinPath(wal -> checkpointPath, ".tmp");
+  FILE *out = tmpPath ? fopen(tmpPath, "wb") : NULL;
+  bool ok = out && saveAvlTree(wal -> root, out) && fsync(fileno(out)) == 0;
+  if(out && fclose(out) != 0) ok = false;
+
+  ok = ok && rename(tmpPath, wal -> checkpointPath) == 0 && syncDirectory(wal -> checkpointPath);
+  if(!ok && tmpPath) unlink(tmpPath);
+  free(tmpPath);
+
+  // a failed checkpoint leaves the log as it was, which is still enough to recover
+  if(!ok) return false;
+
+  if(ftruncate(wal -> logFd, LOG_HEADER_BYTES) != 0 || lseek(wal -> logFd, LOG_HEADER_BYTES, SEEK_SET) < 0 ||
+     fdatasync(wal -> logFd) != 0)
+  {
+    wal -> failed = true;
+    return false;
+  }
+
+  wal -> logRecords = 0;
+  wal -> checkpoints++;
+  return true;
+}
+
+bool walCheckpoint (wal_tree *wal) {
+  pthread_mutex_lock(&wal -> lock);
+  bool ok = !wal -> failed && checkpointLocked(wal);
+  pthread_mutex_unlock(&wal -> lock);
+  return ok;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// recovery
+
+static int compareRecords (const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// only the last record of each key counts, so the batch is sorted by key then position and cut down to
+// one sorted array of keys to remove and one of keys to add, merged in with difference and union
+// instead of one insertAvlTree/deleteNodeAvlTree per record
+static bool applyBatch (wal_tree *wal, uint64_t *batch, size_t n) {
+  int *inserts = malloc(n * sizeof(int));
+  int *deletes = malloc(n * sizeof(int));
+  size_t ni = 0, nd = 0;
+
+  if(!inserts || !deletes)
+  {
+    free(inserts);
+    free(deletes);
+    return false;
+  }
+
+  qsort(batch, n, sizeof(uint64_t), compareRecords);
+  for (size_t i = 0; i < n; i++)
+  {
+    if(i + 1 < n && batch[i] >> 32 == batch[i + 1] >> 32) continue;
+
+    int key = (int)((uint32_t)(batch[i] >> 32) ^ 0x80000000u);
+    if(batch[i] & 1) inserts[ni++] = key;
+    else deletes[nd++] = key;
+  }
+
+  // both trees first, an empty one out of memory would pass for a batch with nothing in it
+  binary_tree *deleted = buildAvlFromSorted(deletes, nd);
+  binary_tree *inserted = buildAvlFromSorted(inserts, ni);
+  free(inserts);
+  free(deletes);
+  if((nd && !deleted) || (ni && !inserted))
+  {
+    freeTree(deleted);
+    freeTree(inserted);
+    return false;
+  }
+
+  if(nd) wal -> root = differenceAvlTree(wal -> root, deleted);
+  if(ni) wal -> root = unionAvlTree(wal -> root, inserted);
+  return true;
+}
+
+// applies the records of the log in order up to the first one that does not check out and cuts the log there
+static bool replayLog (wal_tree *wal) {
+  unsigned char *chunk = wal -> io;
+  size_t have = 0;
+  off_t good = LOG_HEADER_BYTES;
+
+  off_t size = lseek(wal -> logFd, 0, SEEK_END);
+  if(size < 0 || lseek(wal -> logFd, 0, SEEK_SET) < 0) return false;
+
+  // a crash can leave an empty log behind if it came right after the file was created
+  if(size < LOG_HEADER_BYTES)
+  {
+    return ftruncate(wal -> logFd, 0) == 0 && writeLogHeader(wal -> logFd) && fdatasync(wal -> logFd) == 0;
+  }
+
+  unsigned char header[LOG_HEADER_BYTES];
+  if(read(wal -> logFd, header, LOG_HEADER_BYTES) != LOG_HEADER_BYTES) return false;
+  if(memcmp(header, logMagic, 4) != 0 || header[4] != LOG_VERSION || header[5] || header[6] || header[7]) return false;
+
+  // key with the sign flipped so unsigned order is key order, then position in the batch, then insert or not
+  size_t records = (size_t)(size - LOG_HEADER_BYTES) / RECORD_BYTES;
+  size_t capacity = records < REPLAY_BATCH ? records : REPLAY_BATCH;
+  uint64_t *batch = malloc((capacity ? capacity : 1) * sizeof(uint64_t));
+  size_t queued = 0;
+  bool ok = batch != NULL;
+
+  while(ok)
+  {
+    ssize_t got = read(wal -> logFd, chunk + have, WAL_BUFFER - have);
+    if(got < 0 && errno == EINTR) continue;
+    if(got < 0)
+    {
+      ok = false;
+      break;
+    }
+    have += got;
+
+    size_t pos = 0;
+    bool torn = false;
+    while(pos + RECORD_BYTES <= have)
+    {
+      int op, key;
+      if(!decodeRecord(chunk + pos, wal -> logRecords, &op, &key))
+      {
+        torn = true;
+        break;
+      }
+
+      if(queued == capacity)
+      {
+        // a batch that could not be applied fails the recovery right there
+        if(!(ok = applyBatch(wal, batch, queued))) break;
+        queued = 0;
+      }
+      batch[queued] = (uint64_t)((uint32_t)key ^ 0x80000000u) << 32 | (uint64_t)queued << 1 | (op == RECORD_INSERT);
+      queued++;
+
+      wal -> logRecords++;
+      wal -> replayed++;
+      pos += RECORD_BYTES;
+      good += RECORD_BYTES;
+    }
+
+    if(!ok || torn || got == 0) break;
+    memmove(chunk, chunk + pos, have - pos);
+    have -= pos;
+  }
+
+  ok = ok && applyBatch(wal, batch, queued);
+  free(batch);
+  if(!ok) return false;
+
+  if(good < size && (ftruncate(wal -> logFd, good) != 0 || fdatasync(wal -> logFd) != 0)) return false;
+  return lseek(wal -> logFd, good, SEEK_SET) == good;
+}
+
+wal_tree *walOpen (const char *path, const wal_options *options) {
+  wal_tree *wal = malloc(sizeof(wal_tree));
+  if(!wal) return NULL;
+
+  wal_options defaults = {WAL_GROUP, 0, 0, 0};
+  wal -> options = options ? *options : defaults;
+  if(!wal -> options.groupRecords) wal -> options.groupRecords = 256;
+  if(!wal -> options.groupMicros) wal -> options.groupMicros = 2000;
+
+  pthread_mutex_init(&wal -> lock, NULL);
+  pthread_cond_init(&wal -> flushed, NULL);
+  wal -> root = NULL;
+  wal -> appended = wal -> written = wal -> synced = 0;
+  wal -> groupStart = 0;
+  wal -> logRecords = 0;
+  wal -> flushing = wal -> failed = false;
+  wal -> used = 0;
+  wal -> replayed = wal -> syncs = wal -> checkpoints = 0;
+
+  wal -> checkpointPath = joinPath(path, ".ckpt");
+  wal -> logPath = joinPath(path, ".log");
+  wal -> logFd = -1;
+
+  // no checkpoint yet is an empty tree, a checkpoint that does not load is an error
+  bool ok = wal -> checkpointPath && wal -> logPath;
+  if(ok && access(wal -> checkpointPath, F_OK) == 0) ok = loadAvlTreeFile(wal -> checkpointPath, &wal -> root);
+
+  if(ok)
+  {
+    wal -> logFd = open(wal -> logPath, O_RDWR | O_CREAT, 0644);
+    ok = wal -> logFd >= 0 && replayLog(wal) && syncDirectory(wal -> logPath);
+  }
+
+  if(!ok)
+  {
+    wal -> failed = true;
+    walClose(wal);
+    return NULL;
+  }
+
+  return wal;
+}
+
+bool walClose (wal_tree *wal) {
+  if(!wal) return true;
+
+  bool ok = !wal -> failed && walSync(wal);
+
+  if(wal -> logFd >= 0 && close(wal -> logFd) != 0) ok = false;
+  freeTree(wal -> root);
+  free(wal -> checkpointPath);
+  free(wal -> logPath);
+  pthread_cond_destroy(&wal -> flushed);
+  pthread_mutex_destroy(&wal -> lock);
+  free(wal);
+
+  return ok;
+}